@@ -7,7 +7,7 @@
 #endif
 
 #define REFRAMEWORK_PLUGIN_VERSION_MAJOR 1
-#define REFRAMEWORK_PLUGIN_VERSION_MINOR 4
+#define REFRAMEWORK_PLUGIN_VERSION_MINOR 6
 #define REFRAMEWORK_PLUGIN_VERSION_PATCH 0
 
 #define REFRAMEWORK_RENDERER_D3D11 0
@@ -290,6 +290,14 @@ typedef struct {
     REFrameworkTypeInfoHandle type_info;
 } REFrameworkManagedSingleton;
 
+typedef struct {
+    REFrameworkManagedObjectHandle transform;
+    REFrameworkManagedObjectHandle game_object;
+    REFrameworkManagedObjectHandle component; /* the component that matched the filter, if there was one */
+    float position[3];
+    unsigned int depth; /* 0 for the scene's root transforms */
+} REFrameworkSceneEntry;
+
 typedef struct {
     /* resource type, and then the path to the resource in the PAK */
     REFrameworkResourceHandle (*create_resource)(REFrameworkResourceManagerHandle, const char* type_name, const char* name);
@@ -360,6 +368,17 @@ typedef struct {
 
     void* (*allocate)(unsigned long long size);
     void (*deallocate)(void*);
+
+    /* Projects count world positions (3 floats each) into out (2 floats each) using the camera as of this frame. */
+    /* visible is optional; points behind the camera get false there and NaN in out */
+    /* Returns REFRAMEWORK_ERROR_UNKNOWN when there is no camera to project with */
+    REFrameworkResult (*world_to_screen)(const float* world_pos, unsigned int count, float* out, bool* visible);
+
+    /* Every transform in the scene, walked once and shared with the Lua scripts until it's invalidated before UpdateBehavior and before on_frame */
+    /* The handles in out are only good until then */
+    /* component_type is optional; if given, only transforms whose game object has such a component are returned */
+    /* out_size is in bytes; on REFRAMEWORK_ERROR_OUT_TOO_SMALL, out_count is set to the number of entries needed */
+    REFrameworkResult (*get_scene_snapshot)(REFrameworkTypeDefinitionHandle component_type, REFrameworkSceneEntry* out, unsigned int out_size, unsigned int* out_count);
 } REFrameworkSDKFunctions;
 
 /* these are NOT pointers to the actual objects */
@@ -166,6 +166,39 @@ public:
         return out;
     }
 
+    // component_type can be null to get every transform.
+    std::vector<REFrameworkSceneEntry> get_scene_snapshot(const TypeDefinition* component_type = nullptr) const {
+        std::vector<REFrameworkSceneEntry> out{};
+        out.resize(4096);
+
+        uint32_t count{};
+
+        auto result = sdk()->functions->get_scene_snapshot((REFrameworkTypeDefinitionHandle)component_type, &out[0], out.size() * sizeof(REFrameworkSceneEntry), &count);
+
+        if (result == REFRAMEWORK_ERROR_OUT_TOO_SMALL) {
+            out.resize(count);
+            result = sdk()->functions->get_scene_snapshot((REFrameworkTypeDefinitionHandle)component_type, &out[0], out.size() * sizeof(REFrameworkSceneEntry), &count);
+        }
+
+#ifdef REFRAMEWORK_API_EXCEPTIONS
+        if (result != REFRAMEWORK_ERROR_NONE) {
+            throw std::runtime_error("get_scene_snapshot failed");
+        }
+#else
+        if (result != REFRAMEWORK_ERROR_NONE) {
+            return {};
+        }
+#endif
+
+        out.resize(count);
+        return out;
+    }
+
+    // world_pos is count * 3 floats, out is count * 2 floats.
+    bool world_to_screen(const float* world_pos, uint32_t count, float* out, bool* visible = nullptr) const {
+        return sdk()->functions->world_to_screen(world_pos, count, out, visible) == REFRAMEWORK_ERROR_NONE;
+    }
+
     std::vector<REFrameworkNativeSingleton> get_native_singletons() const {
         std::vector<REFrameworkNativeSingleton> out{};
         out.resize(512);
@@ -3,6 +3,7 @@
 #include <utility/Module.hpp>
 
 #include "reframework/API.hpp"
+#include "Trace.hpp"
 #include "RETypeDB.hpp"
 
 namespace sdk {
@@ -28,6 +29,8 @@ reframework::InvokeRet invoke_object_func(::REManagedObject* obj, std::string_vi
 }
 
 sdk::RETypeDefinition* RETypeDB::find_type(std::string_view name) const {
+    REF_TRACE_SCOPE(FIND_TYPE);
+
     {
         std::shared_lock _{ g_tdb_type_mtx };
 
@@ -464,6 +467,8 @@ uint32_t sdk::REMethodDefinition::get_invoke_id() const {
 }
 
 reframework::InvokeRet sdk::REMethodDefinition::invoke(void* object, const std::vector<void*>& args) const {
+    REF_TRACE_SCOPE(INVOKE);
+
     const auto num_params = get_num_params();
 
     if (num_params != args.size()) {
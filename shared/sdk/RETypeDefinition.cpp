@@ -4,6 +4,7 @@
 #include <execution>
 #include <sstream>
 
+#include "Trace.hpp"
 #include "RETypeDB.hpp"
 #include "RETypeDefinition.hpp"
 
@@ -436,6 +437,8 @@ static std::shared_mutex g_method_mtx{};
 static std::unordered_map<std::string, REMethodDefinition*> g_method_map{};
 
 sdk::REMethodDefinition* RETypeDefinition::get_method(std::string_view name) const {
+    REF_TRACE_SCOPE(GET_METHOD);
+
     // originally this used this->get_full_name() + "." + name.data()
     // but that doesn't work for generic types if we haven't yet mapped out
     // how generic (instantiated) types work for the game we're working with
@@ -1,3 +1,9 @@
+#include <atomic>
+#include <limits>
+#include <mutex>
+
+#include <xmmintrin.h>
+
 #include <spdlog/spdlog.h>
 #include <Zydis/Zydis.h>
 
@@ -530,7 +536,12 @@ sdk::renderer::layer::Output* get_output_layer() {
     return sdk::call_native_func<sdk::renderer::layer::Output*>(nullptr, renderer_t, "getOutputLayer", sdk::get_thread_context(), nullptr);
 }
 
-std::optional<Vector2f> world_to_screen(const Vector3f& world_pos) {
+namespace detail {
+std::mutex g_camera_mtx{};
+std::atomic<bool> g_camera_stale{true};
+std::optional<CameraSnapshot> g_camera{};
+
+std::optional<CameraSnapshot> read_camera() {
     auto camera = sdk::get_primary_camera();
 
     if (camera == nullptr) {
@@ -546,38 +557,132 @@ std::optional<Vector2f> world_to_screen(const Vector3f& world_pos) {
     auto context = sdk::get_thread_context();
 
     static auto transform_def = sdk::find_type_definition("via.Transform");
-    static auto math_t = sdk::find_type_definition("via.math");
-
     static auto get_gameobject_method = transform_def->get_method("get_GameObject");
     static auto get_axisz_method = transform_def->get_method("get_AxisZ");
-    static auto world_to_screen_methods = math_t->get_methods("worldPos2ScreenPos"); // there are 2 of them.
 
     auto camera_gameobject = get_gameobject_method->call<REGameObject*>(context, camera);
+
+    if (camera_gameobject == nullptr || camera_gameobject->transform == nullptr) {
+        return std::nullopt;
+    }
+
     auto camera_transform = camera_gameobject->transform;
 
-    Matrix4x4f proj{}, view{};
+    CameraSnapshot out{};
     float screen_size[2]{};
 
-    const auto camera_origin = sdk::get_transform_position(camera_transform);
+    out.origin = sdk::get_transform_position(camera_transform);
+    get_axisz_method->call<void*>(&out.forward, context, camera_transform);
 
-    Vector4f camera_forward{};
-    get_axisz_method->call<void*>(&camera_forward, context, camera_transform);
-
-    sdk::call_object_func<void*>(camera, "get_ProjectionMatrix", &proj, context, camera);
-    sdk::call_object_func<void*>(camera, "get_ViewMatrix", &view, context, camera);
+    sdk::call_object_func<void*>(camera, "get_ProjectionMatrix", &out.proj, context, camera);
+    sdk::call_object_func<void*>(camera, "get_ViewMatrix", &out.view, context, camera);
     sdk::call_object_func<void*>(main_view, "get_Size", &screen_size, context, main_view);
 
-    const Vector4f pos = Vector4f{world_pos, 1.0f};
-    Vector4f screen_pos{};
+    out.view_proj = out.proj * out.view;
+    out.screen_size = Vector2f{screen_size[0], screen_size[1]};
+
+    return out;
+}
+}
+
+void invalidate_camera_snapshot() {
+    detail::g_camera_stale = true;
+}
+
+std::optional<CameraSnapshot> get_camera_snapshot() {
+    std::scoped_lock _{detail::g_camera_mtx};
+
+    if (detail::g_camera_stale.exchange(false)) {
+        detail::g_camera = detail::read_camera();
+    }
+
+    return detail::g_camera;
+}
+
+std::optional<Vector2f> world_to_screen(const Vector3f& world_pos) {
+    const auto camera = get_camera_snapshot();
+
+    if (!camera) {
+        return std::nullopt;
+    }
+
+    return world_to_screen(*camera, world_pos);
+}
+
+std::optional<Vector2f> world_to_screen(const CameraSnapshot& camera, const Vector3f& world_pos) {
+    Vector2f out{};
+    bool visible{};
+
+    world_to_screen(camera, &world_pos, 1, &out, &visible);
+
+    if (!visible) {
+        return std::nullopt;
+    }
+
+    return out;
+}
 
-    const auto delta = pos - camera_origin;
+// Does what via.math.worldPos2ScreenPos does, natively: clip = view_proj * (pos, 1), then the perspective divide and
+// a viewport transform with the origin at the top left. Each point is one SSE column combination.
+void world_to_screen(const CameraSnapshot& camera, const Vector3f* world_pos, size_t count, Vector2f* out, bool* visible) {
+    const auto& m = camera.view_proj;
+    const auto c0 = _mm_loadu_ps(&m[0][0]);
+    const auto c1 = _mm_loadu_ps(&m[1][0]);
+    const auto c2 = _mm_loadu_ps(&m[2][0]);
+    const auto c3 = _mm_loadu_ps(&m[3][0]);
+
+    const auto half_w = camera.screen_size.x * 0.5f;
+    const auto half_h = camera.screen_size.y * 0.5f;
+    const auto nan = std::numeric_limits<float>::quiet_NaN();
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto& p = world_pos[i];
+
+        auto clip = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p.x)), _mm_mul_ps(c1, _mm_set1_ps(p.y)));
+        clip = _mm_add_ps(clip, _mm_mul_ps(c2, _mm_set1_ps(p.z)));
+        clip = _mm_add_ps(clip, c3);
+
+        alignas(16) float v[4];
+        _mm_store_ps(v, clip);
+
+        // w is the distance in front of the camera, so anything at or behind it has no screen position.
+        if (v[3] <= 0.0f) {
+            out[i] = Vector2f{nan, nan};
+
+            if (visible != nullptr) {
+                visible[i] = false;
+            }
+
+            continue;
+        }
+
+        const auto inv_w = 1.0f / v[3];
+
+        out[i] = Vector2f{(v[0] * inv_w + 1.0f) * half_w, (1.0f - v[1] * inv_w) * half_h};
+
+        if (visible != nullptr) {
+            visible[i] = true;
+        }
+    }
+}
+
+std::optional<Vector2f> world_to_screen_managed(const CameraSnapshot& camera, const Vector3f& world_pos) {
+    static auto math_t = sdk::find_type_definition("via.math");
+    static auto world_to_screen_methods = math_t->get_methods("worldPos2ScreenPos"); // there are 2 of them.
+
+    const Vector4f pos = Vector4f{world_pos, 1.0f};
 
     // behind camera
-    if (glm::dot(delta, -camera_forward) <= 0.0f) {
+    if (glm::dot(pos - camera.origin, -camera.forward) <= 0.0f) {
         return std::nullopt;
     }
 
-    world_to_screen_methods[1]->call<void*>(&screen_pos, context, &pos, &view, &proj, &screen_size);
+    auto view = camera.view;
+    auto proj = camera.proj;
+    float screen_size[2]{camera.screen_size.x, camera.screen_size.y};
+    Vector4f screen_pos{};
+
+    world_to_screen_methods[1]->call<void*>(&screen_pos, sdk::get_thread_context(), &pos, &view, &proj, &screen_size);
 
     return Vector2f{screen_pos.x, screen_pos.y};
 }
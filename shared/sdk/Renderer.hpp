@@ -140,6 +140,31 @@ RenderLayer* find_layer(::REType* layer_type);
 
 sdk::renderer::layer::Output* get_output_layer();
 
+// What world_to_screen needs from the camera. Reading it takes several VM calls, so it's read once
+// and shared by every projection made until the next application entry runs.
+struct CameraSnapshot {
+    Matrix4x4f view{};
+    Matrix4x4f proj{};
+    Matrix4x4f view_proj{};
+    Vector4f origin{};
+    Vector4f forward{};
+    Vector2f screen_size{};
+};
+
+// Called after every application entry; the next get_camera_snapshot reads the camera again.
+void invalidate_camera_snapshot();
+
+// nullopt when there's no primary camera or main view.
+std::optional<CameraSnapshot> get_camera_snapshot();
+
 std::optional<Vector2f> world_to_screen(const Vector3f& world_pos);
+std::optional<Vector2f> world_to_screen(const CameraSnapshot& camera, const Vector3f& world_pos);
+
+// Projects count points in one pass. Points behind the camera get visible[i] = false and NaN coordinates.
+void world_to_screen(const CameraSnapshot& camera, const Vector3f* world_pos, size_t count, Vector2f* out, bool* visible);
+
+// The same projection done by the game, through via.math.worldPos2ScreenPos. Far slower;
+// only here to check the native one against.
+std::optional<Vector2f> world_to_screen_managed(const CameraSnapshot& camera, const Vector3f& world_pos);
 }
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#include "RETypeDB.hpp"
+#include "SceneManager.hpp"
+
+#include "SceneSnapshot.hpp"
+
+namespace sdk {
+namespace detail {
+// Far more than any scene has; stops a corrupted list from running away.
+constexpr size_t MAX_SCENE_ENTRIES = 1 << 20;
+
+std::mutex g_scene_mtx{};
+std::atomic<uint64_t> g_generation{1}; // the empty initial snapshot is generation 0, so the first get walks
+std::shared_ptr<const SceneSnapshot> g_scene{std::make_shared<SceneSnapshot>()};
+
+::RETransform* get_first_transform() {
+    auto scene = sdk::get_current_scene();
+
+    if (scene == nullptr) {
+        return nullptr;
+    }
+
+    static auto scene_def = sdk::find_type_definition("via.Scene");
+
+    return sdk::call_native_func_easy<::RETransform*>(scene, scene_def, "get_FirstTransform");
+}
+}
+
+bool SceneSnapshot::is_current() const {
+    return m_generation == detail::g_generation.load();
+}
+
+void invalidate_scene_snapshot() {
+    ++detail::g_generation;
+}
+
+std::shared_ptr<const SceneSnapshot> get_scene_snapshot() {
+    std::scoped_lock _{detail::g_scene_mtx};
+
+    const auto generation = detail::g_generation.load();
+
+    if (detail::g_scene->m_generation == generation) {
+        return detail::g_scene;
+    }
+
+    auto snapshot = std::make_shared<SceneSnapshot>();
+    snapshot->m_generation = generation;
+
+    // Reserve what the last frame needed; scenes rarely change size much between frames.
+    snapshot->m_entries.reserve(detail::g_scene->get_entries().size());
+
+    // Pre-order: a transform, then its children, then its next sibling.
+    std::vector<std::pair<::RETransform*, uint32_t>> stack{};
+    stack.emplace_back(detail::get_first_transform(), 0);
+
+    while (!stack.empty() && snapshot->m_entries.size() < detail::MAX_SCENE_ENTRIES) {
+        const auto [transform, depth] = stack.back();
+        stack.pop_back();
+
+        if (transform == nullptr) {
+            continue;
+        }
+
+        SceneEntry entry{};
+        entry.transform = transform;
+        entry.game_object = transform->ownerGameObject;
+        entry.parent = transform->parentTransform;
+        entry.position = Vector3f{transform->worldTransform[3]};
+        entry.depth = depth;
+
+        snapshot->m_entries.push_back(entry);
+
+        stack.emplace_back(transform->next, depth);
+        stack.emplace_back(transform->child, depth + 1);
+    }
+
+    detail::g_scene = std::move(snapshot);
+
+    return detail::g_scene;
+}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ReClass.hpp"
+
+namespace sdk {
+// Every transform in the current scene as of this frame, collected in one walk over the transform tree.
+// The walk follows the child/next fields directly; the only VM call is the scene's get_FirstTransform.
+//
+// Tools and scripts that used to walk the scene themselves every frame share this instead. The pointers are only
+// good until the snapshot is invalidated, which happens before UpdateBehavior and before on_frame, since objects
+// can be destroyed in between. is_current() says whether that has happened yet.
+struct SceneEntry {
+    ::RETransform* transform{};
+    ::REGameObject* game_object{};
+    ::RETransform* parent{};
+    Vector3f position{}; // from the cached world matrix
+    uint32_t depth{};    // 0 for the scene's root transforms
+};
+
+class SceneSnapshot {
+public:
+    const std::vector<SceneEntry>& get_entries() const {
+        return m_entries;
+    }
+
+    // False once the snapshot has been invalidated; its pointers may be dangling by then.
+    bool is_current() const;
+
+    // Entries whose game object has a component of type t, with that component. t is matched with is_a.
+    template <typename Fn>
+    void for_each_with_component(::REType* t, Fn&& fn) const {
+        for (const auto& entry : m_entries) {
+            if (auto component = utility::re_component::find(entry.transform, t); component != nullptr) {
+                fn(entry, component);
+            }
+        }
+    }
+
+private:
+    friend std::shared_ptr<const SceneSnapshot> get_scene_snapshot();
+
+    std::vector<SceneEntry> m_entries{};
+    uint64_t m_generation{};
+};
+
+// Called before UpdateBehavior and before on_frame; the next get_scene_snapshot walks the scene again.
+void invalidate_scene_snapshot();
+
+// Never null; empty when there's no scene. Holding on to it keeps the snapshot's memory alive, not the objects in it.
+std::shared_ptr<const SceneSnapshot> get_scene_snapshot();
+}
@@ -1,8 +1,40 @@
 #include "RETypeDB.hpp"
+#include "REArray.hpp"
 
 #include "SystemArray.hpp"
 
+std::optional<sdk::SystemArray::Layout> sdk::SystemArray::get_layout() {
+    if (utility::re_managed_object::get_vm_type(this) != via::clr::VMObjType::Array) {
+        return std::nullopt;
+    }
+
+    const auto container = (::REArrayBase*)this;
+
+    // Multidimensional arrays keep their bounds between the header and the data.
+    if (container->num1 > 1 || container->numElements < 0) {
+        return std::nullopt;
+    }
+
+    Layout out{};
+    out.element_type = utility::re_array::get_contained_type(container);
+
+    if (out.element_type == nullptr) {
+        return std::nullopt;
+    }
+
+    out.inline_elements = utility::re_array::has_inline_elements(container);
+    out.element_size = utility::re_array::get_element_size(container);
+    out.count = container->numElements;
+    out.data = (uint8_t*)((::REArrayBase*)utility::re_managed_object::get_field_ptr(container) + 1) - sizeof(::REManagedObject);
+
+    return out;
+}
+
 int32_t sdk::SystemArray::size() {
+    if (const auto layout = get_layout()) {
+        return layout->count;
+    }
+
     static auto system_array_type = sdk::find_type_definition("System.Array");
     static auto get_length_method = system_array_type->get_method("GetLength");
 
@@ -10,6 +42,15 @@ int32_t sdk::SystemArray::size() {
 }
 
 ::REManagedObject* sdk::SystemArray::get_element(int32_t index) {
+    // Object arrays hold the pointers directly. Value type elements need boxing, which only the VM can do.
+    if (const auto layout = get_layout(); layout && !layout->inline_elements) {
+        if (index < 0 || index >= layout->count) {
+            return nullptr;
+        }
+
+        return ((::REManagedObject**)layout->data)[index];
+    }
+
     static auto system_array_type = sdk::find_type_definition("System.Array");
     static auto get_element_method = system_array_type->get_method("GetValue(System.Int32)");
 
@@ -24,9 +65,19 @@ void sdk::SystemArray::set_element(int32_t index, ::REManagedObject* value) {
 }
 
 std::vector<::REManagedObject*> sdk::SystemArray::get_elements() {
+    const auto layout = get_layout();
+
+    if (layout && !layout->inline_elements) {
+        const auto elements = (::REManagedObject**)layout->data;
+        return {elements, elements + layout->count};
+    }
+
     std::vector<::REManagedObject*> elements{};
+    const auto count = size();
+
+    elements.reserve(count);
 
-    for (int32_t i = 0; i < size(); i++) {
+    for (int32_t i = 0; i < count; i++) {
         elements.push_back(get_element(i));
     }
 
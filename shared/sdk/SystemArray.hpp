@@ -4,12 +4,40 @@ struct SystemArray;
 
 #pragma once
 
+#include <optional>
+#include <span>
 #include <vector>
 
 #include "REManagedObject.hpp"
 
 namespace sdk {
+struct RETypeDefinition;
+
 struct SystemArray : public ::REManagedObject {
+    // Read from the array header, no VM calls involved.
+    struct Layout {
+        ::sdk::RETypeDefinition* element_type{};
+        uint32_t element_size{};
+        int32_t count{};
+        uint8_t* data{};
+        bool inline_elements{}; // value types stored in place, otherwise an array of object pointers
+    };
+
+    // nullopt for arrays that have to go through the VM (multidimensional, or an unknown element type).
+    std::optional<Layout> get_layout();
+
+    // The elements read in place as T. Empty if the array has no layout or its elements aren't sizeof(T) wide.
+    template <typename T>
+    std::span<T> get_span() {
+        const auto layout = get_layout();
+
+        if (!layout || layout->element_size != sizeof(T)) {
+            return {};
+        }
+
+        return {(T*)layout->data, (size_t)layout->count};
+    }
+
     int32_t size();
     ::REManagedObject* get_element(int32_t index);
     void set_element(int32_t index, ::REManagedObject* value);
@@ -0,0 +1,107 @@
+#include "Trace.hpp"
+
+#ifdef REF_TRACING
+#include <memory>
+#include <mutex>
+
+namespace sdk {
+namespace trace {
+namespace detail {
+static std::mutex g_threads_mtx{};
+static std::vector<std::unique_ptr<ThreadCounters>> g_threads{};
+
+ThreadCounters& get_thread_counters() {
+    // Never freed; a thread that exits still has counts worth keeping.
+    thread_local ThreadCounters* counters = []() {
+        std::scoped_lock _{g_threads_mtx};
+        return g_threads.emplace_back(std::make_unique<ThreadCounters>()).get();
+    }();
+
+    return *counters;
+}
+}
+
+static std::atomic<SiteNameFn> g_site_name_fn{nullptr};
+
+const char* get_counter_name(Counter counter) {
+    switch (counter) {
+    case Counter::FIND_TYPE:
+        return "find_type";
+    case Counter::GET_METHOD:
+        return "get_method";
+    case Counter::INVOKE:
+        return "REMethodDefinition::invoke";
+    case Counter::LUA_PUSH:
+        return "sol_lua_push";
+    case Counter::HOOK_PRE:
+        return "hook pre";
+    case Counter::HOOK_POST:
+        return "hook post";
+    default:
+        return "unknown";
+    }
+}
+
+void set_site_name_fn(SiteNameFn fn) {
+    g_site_name_fn = fn;
+}
+
+std::string get_site_name(SiteId site) {
+    if (site == UNKNOWN_SITE) {
+        return "(unattributed)";
+    }
+
+    if (auto fn = g_site_name_fn.load(); fn != nullptr) {
+        return fn(site);
+    }
+
+    return "site " + std::to_string(site);
+}
+
+Snapshot snapshot() {
+    Snapshot result{};
+    result.tsc = __rdtsc();
+    result.time = std::chrono::steady_clock::now();
+
+    std::vector<Stats> sites(MAX_SITES);
+    std::vector<bool> hit(MAX_SITES);
+
+    {
+        std::scoped_lock _{detail::g_threads_mtx};
+
+        for (const auto& thread : detail::g_threads) {
+            for (size_t site = 0; site < MAX_SITES; ++site) {
+                for (size_t i = 0; i < (size_t)Counter::COUNT; ++i) {
+                    const auto& stat = thread->sites[site][i];
+                    const auto calls = stat.calls.load(std::memory_order_relaxed);
+
+                    if (calls == 0) {
+                        continue;
+                    }
+
+                    sites[site][i].calls += calls;
+                    sites[site][i].cycles += stat.cycles.load(std::memory_order_relaxed);
+                    hit[site] = true;
+                }
+            }
+        }
+    }
+
+    for (size_t site = 0; site < MAX_SITES; ++site) {
+        if (!hit[site]) {
+            continue;
+        }
+
+        for (size_t i = 0; i < (size_t)Counter::COUNT; ++i) {
+            result.totals[i].calls += sites[site][i].calls;
+            result.totals[i].cycles += sites[site][i].cycles;
+        }
+
+        result.sites.emplace_back((SiteId)site, sites[site]);
+    }
+
+    return result;
+}
+}
+}
+#endif
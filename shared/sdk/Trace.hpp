@@ -0,0 +1,142 @@
+#pragma once
+
+// Call counters and RDTSC timers for the hot SDK entry points.
+// Everything here compiles down to nothing unless REF_TRACING is defined (the REF_TRACING cmake option).
+//
+// REF_TRACE_SCOPE(FIND_TYPE);    // counts the call and times it until the end of the scope
+// REF_TRACE_COUNT(LUA_PUSH);     // counts the call only
+// REF_TRACE_SITE(site_id);       // attributes everything on this thread to site_id until the end of the scope
+//
+// Counters are per thread and per site, so the hot path never takes a lock or a locked instruction.
+
+#ifdef REF_TRACING
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <intrin.h>
+
+namespace sdk {
+namespace trace {
+enum class Counter : uint8_t {
+    FIND_TYPE,
+    GET_METHOD,
+    INVOKE,
+    LUA_PUSH,
+    HOOK_PRE,
+    HOOK_POST,
+    COUNT,
+};
+
+const char* get_counter_name(Counter counter);
+
+// Sites are whatever the framework wants them to be (mods, scripts, plugins). Sites past MAX_SITES,
+// and work done outside any site, are counted under UNKNOWN_SITE.
+using SiteId = uint32_t;
+static constexpr SiteId UNKNOWN_SITE = 0;
+static constexpr size_t MAX_SITES = 1024;
+
+struct Stat {
+    uint64_t calls{};
+    uint64_t cycles{};
+};
+
+using Stats = std::array<Stat, (size_t)Counter::COUNT>;
+
+namespace detail {
+struct ThreadCounters {
+    struct AtomicStat {
+        std::atomic<uint64_t> calls{};
+        std::atomic<uint64_t> cycles{};
+    };
+
+    std::array<std::array<AtomicStat, (size_t)Counter::COUNT>, MAX_SITES> sites{};
+};
+
+ThreadCounters& get_thread_counters();
+
+inline thread_local SiteId g_current_site{UNKNOWN_SITE};
+
+// Only the owning thread writes, so a plain load/store pair is enough; the snapshot reads relaxed.
+inline void add(Counter counter, uint64_t cycles) {
+    auto& stat = get_thread_counters().sites[g_current_site][(size_t)counter];
+
+    stat.calls.store(stat.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    stat.cycles.store(stat.cycles.load(std::memory_order_relaxed) + cycles, std::memory_order_relaxed);
+}
+}
+
+inline void count(Counter counter) {
+    detail::add(counter, 0);
+}
+
+class TimedScope {
+public:
+    TimedScope(Counter counter)
+        : m_counter{counter},
+        m_start{__rdtsc()}
+    {
+    }
+
+    ~TimedScope() {
+        detail::add(m_counter, __rdtsc() - m_start);
+    }
+
+    TimedScope(const TimedScope&) = delete;
+    TimedScope& operator=(const TimedScope&) = delete;
+
+private:
+    Counter m_counter;
+    uint64_t m_start;
+};
+
+class SiteScope {
+public:
+    SiteScope(SiteId site)
+        : m_previous{detail::g_current_site}
+    {
+        detail::g_current_site = site < MAX_SITES ? site : UNKNOWN_SITE;
+    }
+
+    ~SiteScope() {
+        detail::g_current_site = m_previous;
+    }
+
+    SiteScope(const SiteScope&) = delete;
+    SiteScope& operator=(const SiteScope&) = delete;
+
+private:
+    SiteId m_previous;
+};
+
+// The framework names its sites; the SDK only sees numbers.
+using SiteNameFn = std::string (*)(SiteId site);
+void set_site_name_fn(SiteNameFn fn);
+std::string get_site_name(SiteId site);
+
+struct Snapshot {
+    uint64_t tsc{};
+    std::chrono::steady_clock::time_point time{};
+
+    Stats totals{};
+    std::vector<std::pair<SiteId, Stats>> sites{}; // only sites that have been hit
+};
+
+// Sums every thread's counters. The counters only ever grow, so diff two snapshots to get rates.
+Snapshot snapshot();
+}
+}
+
+#define REF_TRACE_CONCAT_INNER(a, b) a##b
+#define REF_TRACE_CONCAT(a, b) REF_TRACE_CONCAT_INNER(a, b)
+#define REF_TRACE_SCOPE(counter) ::sdk::trace::TimedScope REF_TRACE_CONCAT(_ref_trace_scope_, __LINE__){::sdk::trace::Counter::counter}
+#define REF_TRACE_COUNT(counter) ::sdk::trace::count(::sdk::trace::Counter::counter)
+#define REF_TRACE_SITE(site) ::sdk::trace::SiteScope REF_TRACE_CONCAT(_ref_trace_site_, __LINE__){site}
+#else
+#define REF_TRACE_SCOPE(counter)
+#define REF_TRACE_COUNT(counter)
+#define REF_TRACE_SITE(site)
+#endif
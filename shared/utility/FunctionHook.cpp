@@ -61,9 +61,12 @@ bool FunctionHook::remove() {
         return true;
     }
 
-    // Disable then remove the hook.
-    if (MH_DisableHook((LPVOID)m_target) != MH_OK ||
-        MH_RemoveHook((LPVOID)m_target) != MH_OK) {
+    // Disable then remove the hook. It may have already been disabled through MinHook's queued API.
+    if (auto status = MH_DisableHook((LPVOID)m_target); status != MH_OK && status != MH_ERROR_DISABLED) {
+        return false;
+    }
+
+    if (MH_RemoveHook((LPVOID)m_target) != MH_OK) {
         return false;
     }
 
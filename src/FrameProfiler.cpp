@@ -0,0 +1,423 @@
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+#include <sstream>
+
+#include <Windows.h>
+
+#include <imgui.h>
+#include <json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "utility/Module.hpp"
+
+#include "mods/FileWorker.hpp"
+#include "REFramework.hpp"
+#include "FrameProfiler.hpp"
+
+size_t FrameProfiler::bucket_of(uint64_t ns) {
+    if (ns < 8) {
+        return (size_t)ns;
+    }
+
+    const auto msb = (size_t)std::bit_width(ns) - 1;
+    const auto sub = (size_t)(ns >> (msb - 3)) & 7;
+
+    return (msb - 2) * 8 + sub;
+}
+
+uint64_t FrameProfiler::bucket_floor(size_t bucket) {
+    if (bucket < 8) {
+        return bucket;
+    }
+
+    const auto msb = bucket / 8 + 2;
+    const auto sub = bucket % 8;
+
+    return (uint64_t)(8 + sub) << (msb - 3);
+}
+
+uint64_t FrameProfiler::ScopeData::percentile(double p) const {
+    const auto calls = current.calls + previous.calls;
+
+    if (calls == 0) {
+        return 0;
+    }
+
+    const auto rank = (uint64_t)(p * (double)(calls - 1));
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        seen += current.buckets[i] + previous.buckets[i];
+
+        if (seen > rank) {
+            return bucket_floor(i);
+        }
+    }
+
+    return bucket_floor(NUM_BUCKETS - 1);
+}
+
+FrameProfiler::FrameProfiler() {
+#ifdef REF_TRACING
+    sdk::trace::set_site_name_fn([](sdk::trace::SiteId site) {
+        return g_profiler.get_scope_name((ScopeId)site - 1);
+    });
+#endif
+}
+
+void FrameProfiler::set_enabled(bool enabled) {
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+FrameProfiler::ScopeId FrameProfiler::register_scope(std::string_view group, std::string_view name, ScopeKind kind) {
+    std::scoped_lock _{m_mtx};
+
+    auto key = std::string{group} + '\0' + std::string{name};
+
+    if (auto it = m_scope_ids.find(key); it != m_scope_ids.end()) {
+        return it->second;
+    }
+
+    const auto id = (ScopeId)m_scopes.size();
+    auto& scope = m_scopes.emplace_back();
+    scope.group = group;
+    scope.name = name;
+    scope.kind = kind;
+
+    m_scope_ids.emplace(std::move(key), id);
+
+    return id;
+}
+
+std::string FrameProfiler::get_scope_name(ScopeId id) {
+    std::scoped_lock _{m_mtx};
+
+    if (id >= m_scopes.size()) {
+        return "unknown scope";
+    }
+
+    return m_scopes[id].group + ": " + m_scopes[id].name;
+}
+
+FrameProfiler::ThreadBuffer& FrameProfiler::get_thread_buffer() {
+    thread_local ThreadBufferRef ref{};
+
+    if (ref.buffer == nullptr) {
+        std::scoped_lock _{m_buffers_mtx};
+
+        ref.buffer = m_buffers.emplace_back(std::make_shared<ThreadBuffer>());
+        ref.buffer->thread_id = GetCurrentThreadId();
+    }
+
+    return *ref.buffer;
+}
+
+void FrameProfiler::record(ScopeId id, int64_t start, int64_t end) {
+    auto& buffer = get_thread_buffer();
+    const auto head = buffer.head.load(std::memory_order_relaxed);
+
+    // Full; on_frame hasn't caught up yet.
+    if (head - buffer.tail.load(std::memory_order_acquire) >= RING_SIZE) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer.samples[head % RING_SIZE] = Sample{id, start, end};
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void FrameProfiler::on_frame() {
+    std::vector<ThreadBuffer*> buffers{};
+
+    {
+        std::scoped_lock _{m_buffers_mtx};
+
+        buffers.reserve(m_buffers.size());
+
+        for (auto& buffer : m_buffers) {
+            buffers.push_back(buffer.get());
+        }
+    }
+
+    std::scoped_lock _{m_mtx};
+
+    const auto capturing = m_capture_frames_left > 0;
+    std::vector<ThreadBuffer*> retired{};
+
+    for (auto buffer : buffers) {
+        // Checked before reading head, so everything the thread wrote before exiting gets drained.
+        if (buffer->retired.load(std::memory_order_acquire)) {
+            retired.push_back(buffer);
+        }
+
+        const auto head = buffer->head.load(std::memory_order_acquire);
+        auto tail = buffer->tail.load(std::memory_order_relaxed);
+
+        for (; tail != head; ++tail) {
+            const auto& sample = buffer->samples[tail % RING_SIZE];
+
+            if (sample.scope >= m_scopes.size()) {
+                continue;
+            }
+
+            const auto duration = (uint64_t)std::max<int64_t>(sample.end - sample.start, 0);
+            auto& hist = m_scopes[sample.scope].current;
+
+            ++hist.buckets[bucket_of(duration)];
+            hist.total_ns += duration;
+            ++hist.calls;
+
+            if (capturing && m_capture.size() < MAX_CAPTURED_SAMPLES) {
+                m_capture.push_back(CapturedSample{sample, buffer->thread_id});
+            }
+        }
+
+        buffer->tail.store(tail, std::memory_order_release);
+        m_dropped_samples += buffer->dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    if (!retired.empty()) {
+        std::scoped_lock __{m_buffers_mtx};
+
+        std::erase_if(m_buffers, [&](const auto& buffer) {
+            return std::find(retired.begin(), retired.end(), buffer.get()) != retired.end();
+        });
+    }
+
+    if (++m_frames_in_current >= WINDOW_FRAMES) {
+        for (auto& scope : m_scopes) {
+            scope.previous = scope.current;
+            scope.current.clear();
+        }
+
+        m_frames_in_previous = m_frames_in_current;
+        m_frames_in_current = 0;
+    }
+
+    if (capturing) {
+        // Frame boundaries show up as instant events in the trace.
+        const auto frame_time = now();
+        m_capture.push_back(CapturedSample{Sample{INVALID_SCOPE, frame_time, frame_time}, GetCurrentThreadId()});
+
+        if (m_capture.size() >= MAX_CAPTURED_SAMPLES) {
+            spdlog::warn("[FrameProfiler] Capture reached {} samples, stopping early", m_capture.size());
+            m_capture_frames_left = 0;
+            finish_capture();
+        } else if (--m_capture_frames_left == 0) {
+            finish_capture();
+        }
+    }
+}
+
+void FrameProfiler::begin_capture(size_t num_frames, std::string path) {
+    std::scoped_lock _{m_mtx};
+
+    start_capture(num_frames, std::move(path));
+}
+
+void FrameProfiler::start_capture(size_t num_frames, std::string path) {
+    if (num_frames == 0) {
+        return;
+    }
+
+    m_capture.clear();
+    m_capture_path = std::move(path);
+    m_last_capture_result = std::nullopt;
+    m_capture_frames_left = num_frames;
+
+    set_enabled(true);
+}
+
+void FrameProfiler::finish_capture() {
+    spdlog::info("[FrameProfiler] Writing {} samples to {}", m_capture.size(), m_capture_path);
+
+    // Escaping every name once up front keeps the write loop cheap.
+    std::vector<std::string> names{};
+    std::vector<std::string> categories{};
+
+    names.reserve(m_scopes.size());
+    categories.reserve(m_scopes.size());
+
+    for (const auto& scope : m_scopes) {
+        names.push_back(nlohmann::json(scope.group + ": " + scope.name).dump());
+        categories.push_back(nlohmann::json(scope.group).dump());
+    }
+
+    const auto num_samples = m_capture.size();
+    m_last_capture_result = "Writing " + std::to_string(num_samples) + " events to " + m_capture_path + "...";
+
+    // The JSON for a long capture runs into hundreds of megabytes, so it's built on the worker thread too.
+    auto make_data = [capture = std::move(m_capture), names = std::move(names), categories = std::move(categories)]() {
+        std::ostringstream out{};
+
+        const auto base = capture.empty() ? 0 : std::min_element(capture.begin(), capture.end(), [](const auto& a, const auto& b) {
+            return a.sample.start < b.sample.start;
+        })->sample.start;
+
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+        bool first = true;
+
+        for (const auto& captured : capture) {
+            const auto& sample = captured.sample;
+
+            if (!first) {
+                out << ",\n";
+            }
+
+            first = false;
+
+            const auto ts = (double)(sample.start - base) / 1000.0;
+
+            if (sample.scope == INVALID_SCOPE) {
+                out << "{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":" << captured.thread_id << ",\"ts\":" << ts << "}";
+                continue;
+            }
+
+            const auto dur = (double)(sample.end - sample.start) / 1000.0;
+
+            out << "{\"name\":" << names[sample.scope] << ",\"cat\":" << categories[sample.scope]
+                << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << captured.thread_id << ",\"ts\":" << ts << ",\"dur\":" << dur << "}";
+        }
+
+        out << "\n]}\n";
+
+        return std::move(out).str();
+    };
+
+    auto on_done = [this, num_samples, path = m_capture_path](bool ok, std::string, std::string error) {
+        std::scoped_lock _{m_mtx};
+
+        if (ok) {
+            m_last_capture_result = "Wrote " + std::to_string(num_samples) + " events to " + path;
+        } else {
+            m_last_capture_result = "Failed to write " + path + ": " + error;
+            spdlog::error("[FrameProfiler] {}", *m_last_capture_result);
+        }
+    };
+
+    g_file_worker.write(m_capture_path, std::move(make_data), false, std::move(on_done));
+
+    m_capture = {};
+}
+
+void FrameProfiler::on_draw_ui() {
+    auto enabled = is_enabled();
+
+    if (ImGui::Checkbox("Enable Profiling", &enabled)) {
+        set_enabled(enabled);
+    }
+
+    if (!enabled) {
+        return;
+    }
+
+    std::scoped_lock _{m_mtx};
+
+    ImGui::InputInt("Capture Frames", &m_capture_frame_count);
+    m_capture_frame_count = std::clamp(m_capture_frame_count, 1, 10000);
+
+    if (m_capture_frames_left > 0) {
+        ImGui::Text("Capturing... %zu frames left", m_capture_frames_left.load());
+    } else if (ImGui::Button("Capture Chrome Trace")) {
+        const auto dir = utility::get_module_directory(g_framework->get_module().as<HMODULE>()).value_or(".");
+        const auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+        start_capture((size_t)m_capture_frame_count, dir + "/reframework_trace_" + std::to_string(timestamp) + ".json");
+    }
+
+    if (m_last_capture_result) {
+        ImGui::TextWrapped("%s", m_last_capture_result->c_str());
+    }
+
+    if (m_dropped_samples > 0) {
+        ImGui::Text("Dropped samples: %llu", m_dropped_samples);
+    }
+
+    ImGui::Checkbox("Hide Game Time", &m_show_only_reframework);
+
+    const auto frames = m_frames_in_current + m_frames_in_previous;
+
+    if (frames == 0) {
+        return;
+    }
+
+    std::vector<size_t> sorted{};
+    uint64_t total_reframework_ns{};
+    uint64_t total_script_ns{};
+    uint64_t total_game_ns{};
+
+    for (size_t i = 0; i < m_scopes.size(); ++i) {
+        const auto& scope = m_scopes[i];
+        const auto total = scope.current.total_ns + scope.previous.total_ns;
+
+        switch (scope.kind) {
+        case ScopeKind::REFRAMEWORK:
+            total_reframework_ns += total;
+            break;
+        case ScopeKind::SCRIPT:
+            total_script_ns += total;
+            break;
+        case ScopeKind::GAME:
+            total_game_ns += total;
+            break;
+        }
+
+        if (scope.current.calls + scope.previous.calls == 0) {
+            continue;
+        }
+
+        if (m_show_only_reframework && scope.kind == ScopeKind::GAME) {
+            continue;
+        }
+
+        sorted.push_back(i);
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [&](size_t a, size_t b) {
+        return m_scopes[a].current.total_ns + m_scopes[a].previous.total_ns > m_scopes[b].current.total_ns + m_scopes[b].previous.total_ns;
+    });
+
+    const auto per_frame_ms = [&](uint64_t ns) { return (float)((double)ns / (double)frames / 1000000.0); };
+
+    // Script callbacks run inside ScriptRunner's own scopes, so they're already part of the REFramework total.
+    ImGui::Text("REFramework: %.3fms/frame (scripts: %.3fms)", per_frame_ms(total_reframework_ns), per_frame_ms(total_script_ns));
+    ImGui::Text("Game: %.3fms/frame", per_frame_ms(total_game_ns));
+    ImGui::Text("Averaged over %zu frames", frames);
+
+    if (ImGui::BeginTable("##profiler", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY, ImVec2{0, 400})) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Hook");
+        ImGui::TableSetupColumn("Callback");
+        ImGui::TableSetupColumn("ms/frame");
+        ImGui::TableSetupColumn("calls/frame");
+        ImGui::TableSetupColumn("p50 us");
+        ImGui::TableSetupColumn("p95 us");
+        ImGui::TableSetupColumn("p99 us");
+        ImGui::TableHeadersRow();
+
+        for (auto i : sorted) {
+            const auto& scope = m_scopes[i];
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(scope.group.c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(scope.name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", per_frame_ms(scope.current.total_ns + scope.previous.total_ns));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", (float)(scope.current.calls + scope.previous.calls) / (float)frames);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", (float)scope.percentile(0.50) / 1000.0f);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", (float)scope.percentile(0.95) / 1000.0f);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", (float)scope.percentile(0.99) / 1000.0f);
+        }
+
+        ImGui::EndTable();
+    }
+}
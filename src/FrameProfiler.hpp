@@ -0,0 +1,197 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "sdk/Trace.hpp"
+
+// Records how long each mod, script callback and original function takes inside the hooks,
+// so per-frame costs can be pinned on whoever is responsible.
+//
+// Threads write samples into their own ring buffer without locking. Once per frame the buffers are drained
+// into rolling histograms (for the UI), and into a Chrome trace capture when one is running.
+class FrameProfiler {
+public:
+    using ScopeId = uint32_t;
+    static constexpr ScopeId INVALID_SCOPE = ~(ScopeId)0;
+
+    enum class ScopeKind : uint8_t {
+        REFRAMEWORK,
+        SCRIPT,
+        GAME, // the hooked function itself
+    };
+
+    // Times from construction to destruction. Does nothing for INVALID_SCOPE or while the profiler is disabled.
+    // With REF_TRACING, the SDK counters are attributed to the scope regardless.
+    class Scope {
+    public:
+        Scope(FrameProfiler& profiler, ScopeId id)
+            : m_profiler{profiler},
+#ifdef REF_TRACING
+            m_site{FrameProfiler::get_trace_site(id)},
+#endif
+            m_id{profiler.is_enabled() ? id : INVALID_SCOPE},
+            m_start{m_id != INVALID_SCOPE ? FrameProfiler::now() : 0}
+        {
+        }
+
+        ~Scope() {
+            if (m_id != INVALID_SCOPE) {
+                m_profiler.record(m_id, m_start, FrameProfiler::now());
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FrameProfiler& m_profiler;
+#ifdef REF_TRACING
+        sdk::trace::SiteScope m_site;
+#endif
+        ScopeId m_id;
+        int64_t m_start;
+    };
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    }
+
+    bool is_enabled() const {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    void set_enabled(bool enabled);
+
+    // Registering the same group/name pair twice returns the same ID, so scripts can re-register after a reset.
+    ScopeId register_scope(std::string_view group, std::string_view name, ScopeKind kind);
+    std::string get_scope_name(ScopeId id);
+
+#ifdef REF_TRACING
+    // Trace sites are scope IDs shifted by one, leaving 0 for sdk::trace::UNKNOWN_SITE.
+    static sdk::trace::SiteId get_trace_site(ScopeId id) {
+        return id != INVALID_SCOPE ? (sdk::trace::SiteId)id + 1 : sdk::trace::UNKNOWN_SITE;
+    }
+#endif
+
+    FrameProfiler();
+
+    // Lock-free; called from any thread.
+    void record(ScopeId id, int64_t start, int64_t end);
+
+    // Drains the thread buffers. Call once per frame from a single thread.
+    void on_frame();
+
+    // Writes the next num_frames frames to a Chrome trace JSON file (also loadable in Perfetto).
+    // The file is written on the FileWorker thread once the capture is done.
+    void begin_capture(size_t num_frames, std::string path);
+    bool is_capturing() const { return m_capture_frames_left > 0; }
+
+    void on_draw_ui();
+
+private:
+    // Log-linear buckets: exact below 8ns, then 8 buckets per power of two.
+    static constexpr size_t NUM_BUCKETS = 496;
+    static constexpr size_t WINDOW_FRAMES = 120;
+    static constexpr size_t RING_SIZE = 1 << 16;
+    static constexpr size_t MAX_CAPTURED_SAMPLES = 1 << 20; // ~32MB, the capture ends early once it's full
+
+    static size_t bucket_of(uint64_t ns);
+    static uint64_t bucket_floor(size_t bucket);
+
+    struct Histogram {
+        std::array<uint32_t, NUM_BUCKETS> buckets{};
+        uint64_t total_ns{};
+        uint64_t calls{};
+
+        void clear() {
+            buckets.fill(0);
+            total_ns = 0;
+            calls = 0;
+        }
+    };
+
+    struct ScopeData {
+        std::string group{};
+        std::string name{};
+        ScopeKind kind{};
+
+        // The current window fills up while the previous one is kept around,
+        // so the stats always cover between one and two windows of frames.
+        Histogram current{};
+        Histogram previous{};
+
+        uint64_t percentile(double p) const;
+    };
+
+    struct Sample {
+        ScopeId scope{};
+        int64_t start{};
+        int64_t end{};
+    };
+
+    // Single producer (the owning thread), single consumer (on_frame).
+    struct ThreadBuffer {
+        uint32_t thread_id{};
+        std::atomic<uint64_t> head{};
+        std::atomic<uint64_t> tail{};
+        std::atomic<uint64_t> dropped{};
+        std::atomic<bool> retired{}; // the thread exited; freed by on_frame once drained
+        std::unique_ptr<Sample[]> samples{std::make_unique<Sample[]>(RING_SIZE)};
+    };
+
+    // Shared with the owning thread, so the buffer outlives whichever of the two goes away first.
+    struct ThreadBufferRef {
+        std::shared_ptr<ThreadBuffer> buffer{};
+
+        ~ThreadBufferRef() {
+            if (buffer != nullptr) {
+                buffer->retired.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    struct CapturedSample {
+        Sample sample{};
+        uint32_t thread_id{};
+    };
+
+    ThreadBuffer& get_thread_buffer();
+    void start_capture(size_t num_frames, std::string path);
+    void finish_capture();
+
+    std::atomic<bool> m_enabled{false};
+
+    std::mutex m_buffers_mtx{};
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers{};
+
+    // Everything below is guarded by m_mtx. Scopes live in a deque so registering never moves them.
+    std::mutex m_mtx{};
+    std::deque<ScopeData> m_scopes{};
+    std::unordered_map<std::string, ScopeId> m_scope_ids{};
+
+    size_t m_frames_in_current{};
+    size_t m_frames_in_previous{};
+    uint64_t m_dropped_samples{};
+
+    std::atomic<size_t> m_capture_frames_left{};
+    std::string m_capture_path{};
+    std::vector<CapturedSample> m_capture{};
+    std::optional<std::string> m_last_capture_result{};
+
+    // UI state
+    int m_capture_frame_count{120};
+    bool m_show_only_reframework{false};
+};
+
+inline FrameProfiler g_profiler{};
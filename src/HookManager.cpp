@@ -1,53 +1,103 @@
-#include <hde64.h>
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <limits>
+
 #include <spdlog/spdlog.h>
 
+#include "sdk/Trace.hpp"
+
 #include "HookManager.hpp"
 
 namespace detail {
-void* get_actual_function(void* possible_fn) {
-    auto actual_fn = possible_fn;
-    auto ip = (uintptr_t)possible_fn;
-
-    // Disassemble the first few instructions to see if there is a jmp to an actual function.
-    for (auto i = 0; i < 10; ++i) {
-        hde64s hde{};
-        auto len = hde64_disasm((void*)ip, &hde);
-        ip += len;
-
-        if (hde.opcode == 0xE9) { // jmp.
-            actual_fn = (void*)(ip + hde.imm.imm32);
-            break;
+// Epoch-based reclamation for the observer lists. A thread inside notify_observers publishes the epoch
+// it started in to its own slot; a list retired at epoch R can be freed once no published epoch is below R.
+// Slots are cache line sized so readers on different threads don't contend, and are reused after a thread exits.
+struct alignas(64) ObserverReader {
+    std::atomic<uint64_t> epoch{0}; // 0 while not reading
+    bool in_use{true};
+};
+
+std::atomic<uint64_t> g_observer_epoch{1};
+std::mutex g_observer_readers_mux{};
+std::deque<ObserverReader> g_observer_readers{}; // deque so the slots never move
+
+struct ThreadObserverReader {
+    ObserverReader* slot{};
+    uint32_t depth{};
+
+    ~ThreadObserverReader() {
+        if (slot != nullptr) {
+            std::scoped_lock _{g_observer_readers_mux};
+            slot->in_use = false;
         }
     }
+};
+
+thread_local ThreadObserverReader t_observer_reader{};
+
+ObserverReader* acquire_observer_reader() {
+    std::scoped_lock _{g_observer_readers_mux};
 
-    if (possible_fn != actual_fn) {
-        spdlog::info("[HookManager] Using actual function @ {:p} for wrapper function @ {:p}", actual_fn, possible_fn);
+    for (auto& reader : g_observer_readers) {
+        if (!reader.in_use) {
+            reader.in_use = true;
+            return &reader;
+        }
     }
 
-    return actual_fn;
+    return &g_observer_readers.emplace_back();
+}
+
+uint64_t oldest_observer_epoch() {
+    std::scoped_lock _{g_observer_readers_mux};
+    auto oldest = std::numeric_limits<uint64_t>::max();
+
+    for (const auto& reader : g_observer_readers) {
+        if (const auto epoch = reader.epoch.load(); epoch != 0) {
+            oldest = std::min(oldest, epoch);
+        }
+    }
+
+    return oldest;
 }
 }
 
 HookManager::HookedFn::HookedFn(HookManager& hm) : hookman{hm} {
+    update_dispatch();
 }
 
 HookManager::HookedFn::~HookedFn() {
-    fn_hook.reset();
+    // The facilitator itself lives in one of HookManager's blobs.
+    if (original_fn != 0) {
+        hookman.m_backend->remove(target_fn);
+    }
+}
 
-    if (facilitator_fn) {
-        std::scoped_lock _{hookman.m_jit_mux};
-        hookman.m_jit.release(facilitator_fn);
+void HookManager::HookedFn::unlock_static(HookedFn* fn) {
+    fn->mux.unlock();
+
+    if (--s_dispatch_depth == 0 && fn->hookman.m_has_deferred.load(std::memory_order_acquire)) {
+        fn->hookman.run_deferred();
     }
 }
 
 HookManager::PreHookResult HookManager::HookedFn::on_pre_hook() {
+    REF_TRACE_SCOPE(HOOK_PRE);
+
     auto any_skipped = false;
 
+    notify_observers(ObserverFrame{args.data(), args.size()}, false);
+
     for (const auto& cb : cbs) {
         if (cb.pre_fn) {
             if (cb.pre_fn(args, arg_tys) == PreHookResult::SKIP_ORIGINAL) {
                 any_skipped = true;
             }
+        } else if (cb.raw_pre_fn) {
+            if (cb.raw_pre_fn(cb.pre_data, args.data(), args.size(), arg_tys.data()) == PreHookResult::SKIP_ORIGINAL) {
+                any_skipped = true;
+            }
         }
     } 
 
@@ -55,36 +105,212 @@ HookManager::PreHookResult HookManager::HookedFn::on_pre_hook() {
 }
 
 void HookManager::HookedFn::on_post_hook() {
+    REF_TRACE_SCOPE(HOOK_POST);
+
     for (const auto& cb : cbs) {
         if (cb.post_fn) {
             cb.post_fn(ret_val, ret_ty);
+        } else if (cb.raw_post_fn) {
+            cb.raw_post_fn(cb.post_data, &ret_val, ret_ty);
         }
     }
+
+    notify_observers(ObserverFrame{args.data(), args.size(), ret_val}, true);
+}
+
+void HookManager::HookedFn::on_pre_observe(const uintptr_t* frame) {
+    notify_observers(ObserverFrame{frame, num_args}, false);
+}
+
+void HookManager::HookedFn::on_post_observe(const uintptr_t* frame) {
+    // The facilitator stores the return value right after the arguments.
+    notify_observers(ObserverFrame{frame, num_args, frame[num_args]}, true);
+}
+
+void HookManager::HookedFn::notify_observers(const ObserverFrame& frame, bool post) {
+    auto& reader = detail::t_observer_reader;
+
+    if (reader.slot == nullptr) {
+        reader.slot = detail::acquire_observer_reader();
+    }
+
+    // Only the outermost call publishes; an observer that calls another observed function
+    // is still covered by the epoch it started in.
+    if (reader.depth++ == 0) {
+        // Published before loading the list (both sequentially consistent), so reclaim_observer_lists either
+        // sees this reader's epoch, or this reader sees the list that replaced the retired one.
+        reader.slot->epoch.store(detail::g_observer_epoch.load(std::memory_order_acquire));
+    }
+
+    struct Leave {
+        detail::ThreadObserverReader& reader;
+
+        ~Leave() {
+            if (--reader.depth == 0) {
+                reader.slot->epoch.store(0, std::memory_order_release);
+            }
+        }
+    } leave{reader};
+
+    if (const auto list = observers.load(); list != nullptr) {
+        for (const auto& cb : *list) {
+            if (post) {
+                if (cb.post_fn) {
+                    cb.post_fn(frame);
+                }
+            } else if (cb.pre_fn) {
+                cb.pre_fn(frame);
+            }
+        }
+    }
+}
+
+void HookManager::HookedFn::set_observers(std::vector<ObserverCallback> new_observers) {
+    std::scoped_lock _{mux};
+
+    auto old_list = std::move(observer_list);
+    observer_list = std::make_unique<std::vector<ObserverCallback>>(std::move(new_observers));
+    observers.store(observer_list.get());
+
+    if (old_list != nullptr) {
+        hookman.retire_observers(std::move(old_list));
+    }
+
+    update_dispatch();
+}
+
+void HookManager::retire_observers(std::unique_ptr<std::vector<ObserverCallback>> list) {
+    // Bumped after the replacement was stored, so any reader that starts in the new epoch sees the new list.
+    const auto epoch = detail::g_observer_epoch.fetch_add(1) + 1;
+
+    {
+        std::scoped_lock _{m_retired_mux};
+        m_retired.emplace_back(epoch, std::move(list));
+    }
+
+    reclaim_observer_lists();
+}
+
+void HookManager::reclaim_observer_lists() {
+    std::scoped_lock _{m_retired_mux};
+
+    if (m_retired.empty()) {
+        return;
+    }
+
+    const auto oldest = detail::oldest_observer_epoch();
+
+    std::erase_if(m_retired, [oldest](const RetiredObservers& retired) { return retired.epoch <= oldest; });
 }
 
-HookManager::HookId HookManager::add(sdk::REMethodDefinition* fn, HookManager::PreHookFn pre_fn, HookManager::PostHookFn post_fn, bool ignore_jmp) {
-    if (fn == nullptr) {
-        //throw std::exception{"[HookManager] Cannot add nullptr function"};
+bool HookManager::HookedFn::has_callbacks() {
+    // Callbacks are only ever added or removed with HookManager::m_mux held, which the caller holds too,
+    // so there's no need to wait on mux, which a thread inside the hooked function would be holding.
+    const auto list = observers.load(std::memory_order_acquire);
+
+    return !cbs.empty() || (list != nullptr && !list->empty());
+}
+
+void HookManager::HookedFn::update_dispatch() {
+    std::scoped_lock _{mux};
+
+    const auto list = observers.load(std::memory_order_acquire);
+    const auto has_observers = list != nullptr && !list->empty();
+
+    // A single raw callback gets called directly by the facilitator, skipping the loops in on_pre_hook/on_post_hook.
+    if (cbs.size() == 1 && cbs[0].is_raw() && !has_observers) {
+        const auto& cb = cbs[0];
+
+        dispatch.pre_fn = cb.raw_pre_fn != nullptr ? cb.raw_pre_fn : &pre_hook_noop;
+        dispatch.pre_data = cb.pre_data;
+        dispatch.post_fn = cb.raw_post_fn != nullptr ? cb.raw_post_fn : &post_hook_noop;
+        dispatch.post_data = cb.post_data;
+    } else {
+        dispatch.pre_fn = &on_pre_hook_static;
+        dispatch.pre_data = this;
+        dispatch.post_fn = &on_post_hook_static;
+        dispatch.post_data = this;
+    }
+}
+
+HookManager::HookId HookManager::add(void* target, const Signature& sig, HookManager::PreHookFn pre_fn, HookManager::PostHookFn post_fn) {
+    if (target == nullptr) {
+        spdlog::error("[HookManager] Cannot add nullptr function");
+        return HookId{};
+    }
+
+    return add_impl(target, fmt::format("{:p}", target), target, sig, HookCallback{{}, std::move(pre_fn), std::move(post_fn)});
+}
+
+HookManager::HookId HookManager::add_raw(void* target, const Signature& sig, RawPreHookFn pre_fn, void* pre_data, RawPostHookFn post_fn, void* post_data) {
+    if (target == nullptr) {
         spdlog::error("[HookManager] Cannot add nullptr function");
         return HookId{};
     }
-    
-    auto target_fn = ignore_jmp ? fn->get_function() : detail::get_actual_function(fn->get_function());
 
-    spdlog::info("[HookManager] Adding hook for '{}' @ {:p}...", fn->get_name(), target_fn);
+    return add_impl(target, fmt::format("{:p}", target), target, sig, HookCallback{{}, {}, {}, pre_fn, post_fn, pre_data, post_data});
+}
+
+HookManager::HookId HookManager::add_impl(void* key, std::string_view name, void* target_fn, const Signature& sig, HookCallback cb) {
+    const auto id = m_next_hook_id++;
+    cb.id = id;
+
+    if (s_dispatch_depth > 0) {
+        defer([this, key, name = std::string{name}, target_fn, sig, cb] { add_callback(key, name, target_fn, sig, cb); });
+        return id;
+    }
 
-    if (auto search = m_hooked_fns.find(fn); search != m_hooked_fns.end()) {
+    std::scoped_lock _{m_mux};
+    const auto standalone = m_transaction_depth == 0;
+    std::optional<HookId> hook_id{};
+
+    {
+        Transaction transaction{*this};
+        hook_id = add_callback(key, name, target_fn, sig, std::move(cb));
+    }
+
+    // Outside of a transaction we already know whether the hook made it in. A hook that failed to install is gone,
+    // and one that failed to switch from observing keeps its observers but drops the new callback.
+    if (!hook_id) {
+        return HookId{};
+    }
+
+    if (standalone) {
+        const auto search = m_hooked_fns.find(key);
+
+        if (search == m_hooked_fns.end() || std::none_of(search->second->cbs.begin(), search->second->cbs.end(), [&](const HookCallback& cb) { return cb.id == *hook_id; })) {
+            return HookId{};
+        }
+    }
+
+    return *hook_id;
+}
+
+std::optional<HookManager::HookId> HookManager::add_callback(void* key, std::string_view name, void* target_fn, const Signature& sig, HookCallback cb) {
+    spdlog::info("[HookManager] Adding hook for '{}' @ {:p}...", name, target_fn);
+
+    if (auto search = m_hooked_fns.find(key); search != m_hooked_fns.end()) {
         spdlog::info("[HookManager] Reusing existing hook...");
 
         auto& hook = search->second;
         std::scoped_lock _{hook->mux};
-        auto hook_id = hook->next_hook_id++;
+        const auto hook_id = cb.id;
 
         spdlog::info("[HookManager] Hook assigned ID {}", hook_id);
 
-        hook->cbs.emplace_back(hook_id, std::move(pre_fn), std::move(post_fn));
+        hook->cbs.emplace_back(std::move(cb));
+        hook->update_dispatch();
+
+        // The observer facilitator has nowhere to run regular callbacks, so it gets replaced
+        // by a regular one, which notifies the observers from on_pre_hook/on_post_hook.
+        if (hook->observer_only) {
+            spdlog::info("[HookManager] '{}' only had observers, switching it to a regular facilitator", name);
+            queue_conversion(key, *hook, sig);
+        }
+
+        touch(*hook);
 
-        spdlog::info("[HookManager] Hook {} added for '{}' @ {:p}", hook_id, fn->get_name(), target_fn);
+        spdlog::info("[HookManager] Hook {} added for '{}' @ {:p}", hook_id, name, target_fn);
 
         return hook_id;
     }
@@ -92,295 +318,358 @@ HookManager::HookId HookManager::add(sdk::REMethodDefinition* fn, HookManager::P
     spdlog::info("[HookManager] Creating a new hook...");
 
     auto hook = std::make_unique<HookedFn>(*this);
-    auto hook_id = hook->next_hook_id++;
+    const auto hook_id = cb.id;
 
     spdlog::info("[HookManager] Hook assigned ID {}", hook_id);
 
+    hook->name = name;
     hook->target_fn = target_fn;
-    hook->cbs.emplace_back(hook_id, std::move(pre_fn), std::move(post_fn));
-    hook->arg_tys = fn->get_param_types();
-    hook->ret_ty = fn->get_return_type();
+    hook->cbs.emplace_back(std::move(cb));
+    hook->update_dispatch();
+    hook->arg_tys = sig.arg_tys;
+    hook->ret_ty = sig.ret_ty;
+    hook->num_args = sig.num_args;
+
+    // Make sure we have room to store the arguments.
+    hook->args.resize(sig.num_args);
 
-    auto& args = hook->args;
-    auto& arg_tys = hook->arg_tys;
-    auto& fn_hook = hook->fn_hook;
+    queue_install(key, *hook, sig);
+    m_hooked_fns.emplace(key, std::move(hook));
 
-    using namespace asmjit;
-    using namespace asmjit::x86;
+    spdlog::info("[HookManager] Hook {} queued for '{}' @ {:p}", hook_id, name, target_fn);
 
-    std::scoped_lock _{m_jit_mux};
-    CodeHolder code{};
-    code.init(m_jit.environment());
+    return hook_id;
+}
+
+void HookManager::queue_install(void* key, HookedFn& hook, const Signature& sig) {
+    m_pending_installs.push_back(PendingInstall{key, Backend::FacilitatorRequest{&hook, sig, hook.observer_only}});
+    touch(hook);
+}
 
-    Assembler a{&code};
+void HookManager::queue_conversion(void* key, HookedFn& hook, const Signature& sig) {
+    hook.observer_only = false;
+    hook.num_args = sig.num_args;
+    hook.args.resize(sig.num_args);
 
-    // Make sure we have room to store the arguments.
-    args.resize(2 + fn->get_num_params());
-
-    // Generate the facilitator function that will store the arguments, call on_hook, 
-    // restore the arguments, and call the original function.
-    auto hook_label = a.newLabel();
-    auto args_label = a.newLabel();
-    auto this_label = a.newLabel();
-    auto on_pre_hook_label = a.newLabel();
-    auto on_post_hook_label = a.newLabel();
-    auto ret_addr_label = a.newLabel();
-    auto ret_val_label = a.newLabel();
-    auto orig_label = a.newLabel();
-    auto lock_label = a.newLabel();
-    auto unlock_label = a.newLabel();
-
-    // Save state.
-    a.push(rcx);
-    a.push(rdx);
-    a.push(r8);
-    a.push(r9);
-
-    // Lock context.
-    a.mov(rcx, ptr(hook_label));
-    a.sub(rsp, 40);
-    a.call(ptr(lock_label));
-    a.add(rsp, 40);
-
-    // Restore state.
-    a.pop(r9);
-    a.pop(r8);
-    a.pop(rdx);
-    a.pop(rcx);
-
-    // Store args.
-    // TODO: Handle all the arguments the function takes.
-    a.mov(rax, ptr(args_label));
-    a.mov(ptr(rax), rcx); // current thread context.
-
-    auto args_start_offset = 8;
-
-    if (!fn->is_static()) {
-        args_start_offset = 16;
-        a.mov(ptr(rax, 8), rdx); // this ptr... probably.
-    }
-
-    for (auto i = 0u; i < fn->get_num_params(); ++i) {
-        auto arg_ty = arg_tys[i];
-        auto args_offset = args_start_offset + (i * 8);
-        auto is_float = false;
-
-        if (arg_ty->get_full_name() == "System.Single") {
-            is_float = true;
+    m_pending_installs.push_back(PendingInstall{key, Backend::FacilitatorRequest{&hook, sig, false, true}});
+}
+
+void HookManager::touch(HookedFn& hook) {
+    if (std::find(m_touched.begin(), m_touched.end(), &hook) == m_touched.end()) {
+        m_touched.push_back(&hook);
+    }
+}
+
+void HookManager::begin_transaction() {
+    // Everything inside is deferred anyway, and run as one transaction.
+    if (s_dispatch_depth > 0) {
+        return;
+    }
+
+    m_mux.lock();
+    ++m_transaction_depth;
+}
+
+bool HookManager::commit_transaction() {
+    if (s_dispatch_depth > 0) {
+        return true;
+    }
+
+    if (m_transaction_depth == 0) {
+        spdlog::error("[HookManager] commit_transaction called without begin_transaction");
+        return false;
+    }
+
+    if (--m_transaction_depth > 0) {
+        m_mux.unlock();
+        return true;
+    }
+
+    auto result = install_pending();
+
+    // Settle every hook that was touched on whether it should be running, so a hook
+    // that was added and emptied again in the same transaction never gets patched in.
+    std::vector<HookedFn*> to_enable{};
+    std::vector<HookedFn*> to_disable{};
+
+    for (auto hook : m_touched) {
+        const auto wanted = hook->original_fn != 0 && hook->has_callbacks();
+
+        if (wanted && !hook->enabled) {
+            to_enable.push_back(hook);
+        } else if (!wanted && hook->enabled) {
+            to_disable.push_back(hook);
         }
+    }
 
-        switch (args_offset) {
-        case 8: // rdx/xmm1
-            if (is_float) {
-                a.movq(ptr(rax, args_offset), xmm1);
-            } else {
-                a.mov(ptr(rax, args_offset), rdx);
-            }
-            break;
+    auto apply = [this](std::vector<HookedFn*>& hooks, bool enable) {
+        if (hooks.empty()) {
+            return true;
+        }
 
-        case 16: // r8/xmm2
-            if (is_float) {
-                a.movq(ptr(rax, args_offset), xmm2);
-            } else {
-                a.mov(ptr(rax, args_offset), r8);
-            }
-            break;
+        std::vector<void*> targets{};
 
-        case 24: // r9/xmm3
-            if (is_float) {
-                a.movq(ptr(rax, args_offset), xmm3);
-            } else {
-                a.mov(ptr(rax, args_offset), r9);
-            }
-            break;
+        for (auto hook : hooks) {
+            targets.push_back(hook->target_fn);
+        }
 
-        default:
-            // stack args
-            if (args_offset >= 32) {
-                a.mov(r10, ptr(rsp, sizeof(void*) + (args_offset)));
-                a.mov(ptr(rax, args_offset), r10);
-            }
+        if (!(enable ? m_backend->enable(targets) : m_backend->disable(targets))) {
+            return false;
+        }
 
-            break;
+        for (auto hook : hooks) {
+            hook->enabled = enable;
         }
+
+        spdlog::info("[HookManager] {} {} hooks", enable ? "Enabled" : "Disabled", hooks.size());
+        return true;
+    };
+
+    result = apply(to_enable, true) && result;
+    result = apply(to_disable, false) && result;
+
+    m_touched.clear();
+    m_pending_installs.clear();
+
+    m_mux.unlock();
+    return result;
+}
+
+void HookManager::defer(std::function<void()> op) {
+    std::scoped_lock _{m_deferred_mux};
+    m_deferred.emplace_back(std::move(op));
+    m_has_deferred.store(true, std::memory_order_release);
+}
+
+void HookManager::run_deferred() {
+    std::vector<std::function<void()>> ops{};
+
+    {
+        std::scoped_lock _{m_deferred_mux};
+        ops.swap(m_deferred);
+        m_has_deferred.store(false, std::memory_order_release);
     }
 
-    // Call on_pre_hook.
-    a.mov(rcx, ptr(hook_label));
-    a.sub(rsp, 40);
-    a.call(ptr(on_pre_hook_label));
-    a.add(rsp, 40);
+    if (ops.empty()) {
+        return;
+    }
+
+    Transaction transaction{*this};
+
+    for (auto& op : ops) {
+        op();
+    }
+}
 
-    // Save the return value so we can see if we need to call the original later.
-    a.mov(r11, rax);
+bool HookManager::install_pending() {
+    if (m_pending_installs.empty()) {
+        return true;
+    }
 
-    // Restore args.
-    a.mov(rax, ptr(args_label));
-    a.mov(rcx, ptr(rax)); // current thread context.
+    auto result = true;
+    std::vector<Backend::FacilitatorRequest> requests{};
 
-    if (!fn->is_static()) {
-        a.mov(rdx, ptr(rax, 8)); // this ptr... probably.
+    for (const auto& pending : m_pending_installs) {
+        requests.push_back(pending.request);
     }
 
-    for (auto i = 0u; i < fn->get_num_params(); ++i) {
-        auto arg_ty = arg_tys[i];
-        auto args_offset = args_start_offset + (i * 8);
-        auto is_float = false;
+    const auto facilitators = m_backend->generate(requests);
+    std::vector<void*> failed{};
 
-        if (arg_ty->get_full_name() == "System.Single") {
-            is_float = true;
-        }
+    // A failed conversion leaves the hook running its observer facilitator. It only had observers
+    // before this transaction, so every regular callback on it is one that just got added.
+    auto keep_observing = [](HookedFn& hook) {
+        std::scoped_lock _{hook.mux};
+
+        spdlog::error("[HookManager] Failed to switch '{}' to a regular facilitator, dropping its {} regular callbacks", hook.name, hook.cbs.size());
+
+        hook.observer_only = true;
+        hook.cbs.clear();
+        hook.update_dispatch();
+    };
 
-        switch (args_offset) {
-        case 8: // rdx/xmm1
-            if (is_float) {
-                a.movq(xmm1, ptr(rax, args_offset));
-            } else {
-                a.mov(rdx, ptr(rax, args_offset));
+    if (facilitators.size() != requests.size()) {
+        spdlog::error("[HookManager] Failed to generate facilitators for {} hooks", m_pending_installs.size());
+
+        for (const auto& pending : m_pending_installs) {
+            auto& hook = *m_hooked_fns[pending.key];
+
+            if (pending.request.replace && hook.original_fn != 0) {
+                keep_observing(hook);
+                result = false;
+            } else if (std::find(failed.begin(), failed.end(), pending.key) == failed.end()) {
+                failed.push_back(pending.key);
             }
-            break;
+        }
+    } else {
+        for (size_t i = 0; i < m_pending_installs.size(); ++i) {
+            const auto& pending = m_pending_installs[i];
+            const auto& facilitator = facilitators[i];
 
-        case 16: // r8/xmm2
-            if (is_float) {
-                a.movq(xmm2, ptr(rax, args_offset));
-            } else {
-                a.mov(r8, ptr(rax, args_offset));
+            // Added and converted in the same transaction, but the install itself failed.
+            if (std::find(failed.begin(), failed.end(), pending.key) != failed.end()) {
+                continue;
             }
-            break;
 
-        case 24: // r9/xmm3
-            if (is_float) {
-                a.movq(xmm3, ptr(rax, args_offset));
-            } else {
-                a.mov(r9, ptr(rax, args_offset));
+            auto& hook = *m_hooked_fns[pending.key];
+
+            if (pending.request.replace) {
+                *facilitator.original_slot = hook.original_fn;
+
+                // Threads already inside the old facilitator finish there, the next call takes the new one.
+                hook.facilitator_fn.store(facilitator.entry, std::memory_order_release);
+                spdlog::info("[HookManager] Switched '{}' to a regular facilitator", hook.name);
+                continue;
             }
-            break;
 
-        default:
-            if (args_offset >= 32) {
-                a.mov(r10, ptr(rax, args_offset));
-                a.mov(ptr(rsp, sizeof(void*) + (args_offset)), r10);
+            // Hook the function to our facilitator.
+            hook.facilitator_fn.store(facilitator.entry, std::memory_order_release);
+            hook.original_fn = m_backend->create(hook.target_fn, (void*)facilitator.stub);
+
+            if (hook.original_fn == 0) {
+                spdlog::error("[HookManager] Failed to hook '{}' @ {:p}", hook.name, hook.target_fn);
+                failed.push_back(pending.key);
+                continue;
             }
 
-            // TODO: handle stack args.
-            break;
+            // Set the facilitators original function pointer.
+            *facilitator.original_slot = hook.original_fn;
         }
     }
 
-    // Call original function.
-    auto ret_label = a.newLabel();
-    auto skip_label = a.newLabel();
+    for (auto key : failed) {
+        auto hook = m_hooked_fns[key].get();
+
+        m_touched.erase(std::remove(m_touched.begin(), m_touched.end(), hook), m_touched.end());
+        m_hooked_fns.erase(key);
+        result = false;
+    }
 
-    // Save return address.
-    a.mov(r10, ptr(rsp));
-    a.mov(rax, ptr(ret_addr_label));
-    a.mov(ptr(rax), r10);
+    return result;
+}
 
-    // Overwrite return address.
-    a.lea(rax, ptr(ret_label));
-    a.mov(ptr(rsp), rax);
+HookManager::HookManager(std::unique_ptr<Backend> backend) : m_backend{std::move(backend)} {
+}
 
-    // Determine if we need to skip the original function or not.
-    a.cmp(r11, (int)PreHookResult::CALL_ORIGINAL);
-    a.jnz(skip_label);
+HookManager::~HookManager() {
+    // Unhooks everything before the backend frees the code the detours point at.
+    m_hooked_fns.clear();
+}
 
-    // Jmp to original function.
-    a.jmp(ptr(orig_label));
+HookManager::HookId HookManager::add_observer(void* target, const Signature& sig, HookManager::PreObserverFn pre_fn, HookManager::PostObserverFn post_fn) {
+    if (target == nullptr) {
+        spdlog::error("[HookManager] Cannot add nullptr function");
+        return HookId{};
+    }
 
-    a.bind(skip_label);
-    a.add(rsp, 8); // pop ret address.
+    return add_observer_impl(target, fmt::format("{:p}", target), target, sig, std::move(pre_fn), std::move(post_fn));
+}
 
-    a.bind(ret_label);
+HookManager::HookId HookManager::add_observer_impl(void* key, std::string_view name, void* target_fn, const Signature& sig, PreObserverFn pre_fn, PostObserverFn post_fn) {
+    const auto id = m_next_hook_id++;
 
-    // Save return value.
-    a.mov(rcx, ptr(ret_val_label));
+    if (s_dispatch_depth > 0) {
+        defer([this, key, name = std::string{name}, target_fn, sig, id, pre_fn, post_fn] { add_observer_callback(key, name, target_fn, sig, id, pre_fn, post_fn); });
+        return id;
+    }
 
-    auto is_ret_ty_float = hook->ret_ty->get_full_name() == "System.Single";
+    std::scoped_lock _{m_mux};
+    const auto standalone = m_transaction_depth == 0;
+    std::optional<HookId> hook_id{};
 
-    if (is_ret_ty_float) {
-        a.movq(ptr(rcx), xmm0);
-    } else {
-        a.mov(ptr(rcx), rax);
+    {
+        Transaction transaction{*this};
+        hook_id = add_observer_callback(key, name, target_fn, sig, id, std::move(pre_fn), std::move(post_fn));
     }
 
-    // Call on_post_hook.
-    a.mov(rcx, ptr(hook_label));
-    a.call(ptr(on_post_hook_label));
+    if (!hook_id || (standalone && !m_hooked_fns.contains(key))) {
+        return HookId{};
+    }
+
+    return *hook_id;
+}
 
-    // Restore return value.
-    a.mov(rcx, ptr(ret_val_label));
+std::optional<HookManager::HookId> HookManager::add_observer_callback(void* key, std::string_view name, void* target_fn, const Signature& sig, HookId hook_id, PreObserverFn pre_fn, PostObserverFn post_fn) {
+    spdlog::info("[HookManager] Adding observer for '{}' @ {:p}...", name, target_fn);
 
-    if (is_ret_ty_float) {
-        a.movq(xmm0, ptr(rcx));
-    } else {
-        a.mov(rax, ptr(rcx));
-    }
-
-    // Store state.
-    a.push(rax);
-    a.mov(r10, ptr(ret_addr_label));
-    a.mov(r10, ptr(r10));
-    a.push(r10);
-
-    // Unlock context.
-    a.mov(rcx, ptr(hook_label));
-    a.sub(rsp, 32);
-    a.call(ptr(unlock_label));
-    a.add(rsp, 32);
-
-    // Restore state.
-    a.pop(r10);
-    a.pop(rax);
-
-    // Return.
-    a.jmp(r10);
-
-    a.bind(hook_label);
-    a.dq((uint64_t)hook.get());
-    a.bind(args_label);
-    a.dq((uint64_t)args.data());
-    a.bind(this_label);
-    a.dq((uint64_t)this);
-    a.bind(on_pre_hook_label);
-    a.dq((uint64_t)&HookedFn::on_pre_hook_static);
-    a.bind(on_post_hook_label);
-    a.dq((uint64_t)&HookedFn::on_post_hook_static);
-    a.bind(lock_label);
-    a.dq((uint64_t)&HookedFn::lock_static);
-    a.bind(unlock_label);
-    a.dq((uint64_t)&HookedFn::unlock_static);
-    a.bind(ret_addr_label);
-    a.dq((uint64_t)&hook->ret_addr);
-    a.bind(ret_val_label);
-    a.dq((uint64_t)&hook->ret_val);
-    a.bind(orig_label);
-    // Can't do the following because the hook hasn't been created yet.
-    //a.dq(fn_hook->get_original());
-    a.dq(0);
-
-    m_jit.add(&hook->facilitator_fn, &code);
-
-    // Hook the function to our facilitator.
-    fn_hook = std::make_unique<FunctionHook>(hook->target_fn, (void*)hook->facilitator_fn);
-
-    // Set the facilitators original function pointer.
-    *(uintptr_t*)(hook->facilitator_fn + code.labelOffsetFromBase(orig_label)) = fn_hook->get_original();
-
-    fn_hook->create();
-    m_hooked_fns.emplace(fn, std::move(hook));
-
-    spdlog::info("[HookManager] Hook {} added for '{}' @ {:p}", hook_id, fn->get_name(), target_fn);
+    if (auto search = m_hooked_fns.find(key); search != m_hooked_fns.end()) {
+        spdlog::info("[HookManager] Reusing existing hook...");
+
+        auto& hook = search->second;
+        std::scoped_lock _{hook->mux};
+        auto observers = hook->observers.load() != nullptr ? *hook->observers.load() : std::vector<ObserverCallback>{};
+
+        observers.emplace_back(hook_id, std::move(pre_fn), std::move(post_fn));
+        hook->set_observers(std::move(observers));
+        touch(*hook);
+
+        spdlog::info("[HookManager] Observer {} added for '{}' @ {:p}", hook_id, name, target_fn);
+
+        return hook_id;
+    }
+
+    spdlog::info("[HookManager] Creating a new observer hook...");
+
+    auto hook = std::make_unique<HookedFn>(*this);
+
+    hook->name = name;
+    hook->target_fn = target_fn;
+    hook->observer_only = true;
+    hook->arg_tys = sig.arg_tys;
+    hook->ret_ty = sig.ret_ty;
+    hook->num_args = sig.num_args;
+    hook->set_observers({ObserverCallback{hook_id, std::move(pre_fn), std::move(post_fn)}});
+
+    queue_install(key, *hook, sig);
+    m_hooked_fns.emplace(key, std::move(hook));
+
+    spdlog::info("[HookManager] Observer {} queued for '{}' @ {:p}", hook_id, name, target_fn);
 
     return hook_id;
 }
 
+bool HookManager::set_backend(std::unique_ptr<Backend> backend) {
+    std::scoped_lock _{m_mux};
+
+    if (!m_hooked_fns.empty() || backend == nullptr) {
+        spdlog::error("[HookManager] Cannot change the backend after functions have been hooked");
+        return false;
+    }
+
+    m_backend = std::move(backend);
+    return true;
+}
+
 void HookManager::remove(sdk::REMethodDefinition* fn, HookId id) {
-    if (auto search = m_hooked_fns.find(fn); search != m_hooked_fns.end()) {
-        spdlog::info("[HookManager] Removing hook ID {} from '{}'", id, fn->get_name());
+    remove((void*)fn, id);
+}
+
+void HookManager::remove(void* target, HookId id) {
+    if (s_dispatch_depth > 0) {
+        defer([this, target, id] { remove(target, id); });
+        return;
+    }
+
+    Transaction transaction{*this};
+
+    if (auto search = m_hooked_fns.find(target); search != m_hooked_fns.end()) {
+        spdlog::info("[HookManager] Removing hook ID {} from '{}'", id, search->second->name);
 
         auto& hook = search->second;
         auto& cbs = hook->cbs;
+        touch(*hook);
+
         std::scoped_lock _{hook->mux};
-        cbs.erase(std::remove_if(cbs.begin(), cbs.end(), [id](const HookCallback& cb) { return cb.id == id; }));
+        cbs.erase(std::remove_if(cbs.begin(), cbs.end(), [id](const HookCallback& cb) { return cb.id == id; }), cbs.end());
+        hook->update_dispatch();
+
+        if (auto list = hook->observers.load(); list != nullptr) {
+            auto new_observers = *list;
+            new_observers.erase(std::remove_if(new_observers.begin(), new_observers.end(), [id](const ObserverCallback& cb) { return cb.id == id; }), new_observers.end());
+
+            if (new_observers.size() != list->size()) {
+                hook->set_observers(std::move(new_observers));
+            }
+        }
     }
 }
@@ -1,16 +1,30 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
 
-#include <asmjit/asmjit.h>
+namespace sdk {
+struct RETypeDefinition;
+struct REMethodDefinition;
+}
 
-#include "utility/FunctionHook.hpp"
-#include "sdk/RETypeDB.hpp"
+// The static dispatchers are called from generated code by address.
+#ifdef _MSC_VER
+#define HOOKMAN_NOINLINE __declspec(noinline)
+#else
+#define HOOKMAN_NOINLINE __attribute__((noinline))
+#endif
 
+// The bookkeeping lives in HookManager.cpp and doesn't need the game, so it can be built and tested anywhere.
+// Generating the facilitators and patching the targets is up to the Backend, and the overloads that take
+// type database methods are in HookManagerBackend.cpp along with the MinHook backend.
 class HookManager {
 public:
     enum class PreHookResult : int {
@@ -23,19 +37,111 @@ public:
     using PostHookFn = std::function<void(uintptr_t& ret_val, sdk::RETypeDefinition* ret_ty)>;
     using HookId = size_t;
 
+    // C-style callbacks. When one of these is the only callback on a function,
+    // the facilitator calls it directly.
+    using RawPreHookFn = PreHookResult (*)(void* user_data, uintptr_t* args, size_t num_args, sdk::RETypeDefinition** arg_tys);
+    using RawPostHookFn = void (*)(void* user_data, uintptr_t* ret_val, sdk::RETypeDefinition* ret_ty);
+
     struct HookCallback {
         HookId id{};
         PreHookFn pre_fn{};
         PostHookFn post_fn{};
+        RawPreHookFn raw_pre_fn{};
+        RawPostHookFn raw_post_fn{};
+        void* pre_data{};
+        void* post_data{};
+
+        bool is_raw() const { return !pre_fn && !post_fn; }
+    };
+
+    // What the facilitator calls before and after the original function.
+    // Points at HookedFn's own dispatchers unless there's a single raw callback.
+    struct Dispatch {
+        RawPreHookFn pre_fn{};
+        void* pre_data{};
+        RawPostHookFn post_fn{};
+        void* post_data{};
+    };
+
+    // Observers can't modify the arguments or return value, and can't skip the original.
+    // In exchange, an observer-only hook keeps its argument/return frame on the calling thread's stack
+    // and takes no locks, so the hooked function can keep running on many threads at once.
+    struct ObserverFrame {
+        const uintptr_t* args{};
+        size_t num_args{};
+        uintptr_t ret_val{}; // only valid in post observers
+    };
+
+    using PreObserverFn = std::function<void(const ObserverFrame& frame)>;
+    using PostObserverFn = std::function<void(const ObserverFrame& frame)>;
+
+    struct ObserverCallback {
+        HookId id{};
+        PreObserverFn pre_fn{};
+        PostObserverFn post_fn{};
+    };
+
+    // Describes how a hooked function takes its arguments, independent of the type database.
+    // This is all the facilitators need, so plain native functions can be hooked too.
+    struct Signature {
+        size_t num_args{};     // Including the thread context and this ptr for managed methods.
+        uint64_t float_args{}; // Bit i is set if argument i is passed in an xmm register.
+        bool float_ret{};
+        std::vector<sdk::RETypeDefinition*> arg_tys{}; // Optional, passed through to pre hooks.
+        sdk::RETypeDefinition* ret_ty{};               // Optional, passed through to post hooks.
+
+        static Signature from_method(sdk::REMethodDefinition* fn);
+
+        bool is_float_arg(size_t i) const { return i < 64 && (float_args & (1ull << i)) != 0; }
+    };
+
+    // Generates the facilitators and patches the target functions to jump to them. The default is asmjit and MinHook
+    // (HookManagerBackend.cpp), but anything that can produce the code and redirect a function will do.
+    class Backend {
+    public:
+        // The code a detour lands on: a stub that jumps through HookedFn::facilitator_fn, followed by the
+        // facilitator, which calls the original function through a slot that's filled in once the hook exists.
+        struct FacilitatorRequest {
+            HookedFn* hook{};
+            Signature sig{};
+            bool observer{}; // the lock-free observer facilitator instead of the regular one
+            bool replace{};  // for a hook that's already installed, which keeps its stub
+        };
+
+        struct Facilitator {
+            uintptr_t stub{}; // 0 when replacing
+            uintptr_t entry{};
+            uintptr_t* original_slot{};
+        };
+
+        virtual ~Backend() = default;
+
+        // A whole transaction's facilitators in one go, in the order requested. Empty on failure.
+        virtual std::vector<Facilitator> generate(const std::vector<FacilitatorRequest>& requests) = 0;
+
+        // Returns the trampoline to the original function, or 0 on failure.
+        virtual uintptr_t create(void* target, void* destination) = 0;
+
+        // Enabling and disabling is batched so all the targets can be patched while
+        // the other threads are suspended once.
+        virtual bool enable(const std::vector<void*>& targets) = 0;
+        virtual bool disable(const std::vector<void*>& targets) = 0;
+
+        // Also frees the trampoline, so only safe once nothing can be executing it.
+        virtual bool remove(void* target) = 0;
     };
 
     struct HookedFn {
         HookManager& hookman;
+        std::string name{};
         void* target_fn{};
         std::vector<HookCallback> cbs{}; 
-        HookId next_hook_id{};
-        std::unique_ptr<FunctionHook> fn_hook{};
-        uintptr_t facilitator_fn{};
+        uintptr_t original_fn{};
+
+        // The detour lands on a stub that jumps through this, so the facilitator can be
+        // swapped out later without repatching the target.
+        std::atomic<uintptr_t> facilitator_fn{};
+        Dispatch dispatch{};
         std::vector<uintptr_t> args{};
         std::vector<sdk::RETypeDefinition*> arg_tys{};
         uintptr_t ret_addr{};
@@ -43,25 +149,152 @@ public:
         sdk::RETypeDefinition* ret_ty{};
         std::recursive_mutex mux{};
 
+        // Set when the facilitator was generated by add_observer. Adding a regular callback
+        // switches the hook over to a regular facilitator.
+        bool observer_only{false};
+        size_t num_args{};
+
+        // Hooks are disabled rather than destroyed once all their callbacks are removed,
+        // since another thread may still be running the facilitator.
+        bool enabled{false};
+
+        // Copy-on-write so the facilitator can read it without locking. Replaced lists are retired
+        // to HookManager, since another thread may still be iterating over them.
+        std::atomic<const std::vector<ObserverCallback>*> observers{nullptr};
+        std::unique_ptr<std::vector<ObserverCallback>> observer_list{};
+
         HookedFn(HookManager& hm);
         ~HookedFn();
 
         PreHookResult on_pre_hook();
         void on_post_hook();
+        void on_pre_observe(const uintptr_t* frame);
+        void on_post_observe(const uintptr_t* frame);
+        void notify_observers(const ObserverFrame& frame, bool post);
+        void set_observers(std::vector<ObserverCallback> new_observers);
+        void update_dispatch();
+        bool has_callbacks();
 
-        __declspec(noinline) static void lock_static(HookedFn* fn) { fn->mux.lock(); }
-        __declspec(noinline) static void unlock_static(HookedFn* fn) { fn->mux.unlock(); }
-        __declspec(noinline) static PreHookResult on_pre_hook_static(HookedFn* fn) { return fn->on_pre_hook(); }
-        __declspec(noinline) static void on_post_hook_static(HookedFn* fn) { fn->on_post_hook(); }
+        HOOKMAN_NOINLINE static void lock_static(HookedFn* fn) { fn->mux.lock(); ++s_dispatch_depth; }
+        HOOKMAN_NOINLINE static void unlock_static(HookedFn* fn);
+        HOOKMAN_NOINLINE static PreHookResult on_pre_hook_static(void* fn, uintptr_t*, size_t, sdk::RETypeDefinition**) { return ((HookedFn*)fn)->on_pre_hook(); }
+        HOOKMAN_NOINLINE static void on_post_hook_static(void* fn, uintptr_t*, sdk::RETypeDefinition*) { ((HookedFn*)fn)->on_post_hook(); }
+        static PreHookResult pre_hook_noop(void*, uintptr_t*, size_t, sdk::RETypeDefinition**) { return PreHookResult::CALL_ORIGINAL; }
+        static void post_hook_noop(void*, uintptr_t*, sdk::RETypeDefinition*) {}
+        HOOKMAN_NOINLINE static void on_pre_observe_static(HookedFn* fn, const uintptr_t* frame) { fn->on_pre_observe(frame); }
+        HOOKMAN_NOINLINE static void on_post_observe_static(HookedFn* fn, const uintptr_t* frame) { fn->on_post_observe(frame); }
     };
 
+    explicit HookManager(std::unique_ptr<Backend> backend);
+
     HookId add(sdk::REMethodDefinition* fn, PreHookFn pre_fn, PostHookFn post_fn, bool ignore_jmp = false);
+
+    // Hooks a plain native function. The target itself is used as the key for remove.
+    HookId add(void* target, const Signature& sig, PreHookFn pre_fn, PostHookFn post_fn);
+
+    // Either callback may be nullptr.
+    HookId add_raw(sdk::REMethodDefinition* fn, RawPreHookFn pre_fn, void* pre_data, RawPostHookFn post_fn, void* post_data, bool ignore_jmp = false);
+    HookId add_raw(void* target, const Signature& sig, RawPreHookFn pre_fn, void* pre_data, RawPostHookFn post_fn, void* post_data);
+
+    // If fn is already hooked with add, the observer is called from the regular facilitator instead.
+    // Likewise, a later add on a function that only has observers switches it to the regular facilitator.
+    HookId add_observer(sdk::REMethodDefinition* fn, PreObserverFn pre_fn, PostObserverFn post_fn, bool ignore_jmp = false);
+    HookId add_observer(void* target, const Signature& sig, PreObserverFn pre_fn, PostObserverFn post_fn);
+
+    // Removes callbacks added with either add or add_observer.
     void remove(sdk::REMethodDefinition* fn, HookId id);
+    void remove(void* target, HookId id);
+
+    // add, add_raw, add_observer and remove called from inside a hooked function (e.g. from a callback) are
+    // deferred until the thread leaves the outermost hooked function, and then run as one transaction.
+    // That thread holds the hook's mux, and taking m_mux under it would deadlock against another thread's
+    // transaction waiting on that same mux. IDs are still handed out immediately.
+
+    // Frees the observer lists replaced since the last call that no thread can still be reading.
+    // Called once a frame by ScriptRunner, and whenever a list gets replaced.
+    void reclaim_observer_lists();
+
+    // Only allowed before anything has been hooked.
+    bool set_backend(std::unique_ptr<Backend> backend);
+
+    // Hooks added or removed inside a transaction take effect when the outermost transaction is committed.
+    // All the new facilitators get assembled into one blob, and every detour is enabled or disabled in a single batch,
+    // instead of suspending the game's threads once per hook. Hook IDs are handed out immediately,
+    // but a hook that fails to install at commit time is dropped, making its ID a no-op for remove.
+    // Calls outside of a transaction behave like a transaction of one.
+    void begin_transaction();
+    bool commit_transaction();
+
+    class Transaction {
+    public:
+        Transaction(HookManager& hookman) : m_hookman{hookman} { m_hookman.begin_transaction(); }
+        ~Transaction() { m_hookman.commit_transaction(); }
+
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+    private:
+        HookManager& m_hookman;
+    };
+
+    ~HookManager();
 
 private:
-    asmjit::JitRuntime m_jit{};
-    std::mutex m_jit_mux{};
-    std::unordered_map<sdk::REMethodDefinition*, std::unique_ptr<HookedFn>> m_hooked_fns{};
+    struct PendingInstall {
+        void* key{};
+        Backend::FacilitatorRequest request{};
+    };
+
+    struct RetiredObservers {
+        uint64_t epoch{};
+        std::unique_ptr<std::vector<ObserverCallback>> list{};
+    };
+
+    HookId add_impl(void* key, std::string_view name, void* target_fn, const Signature& sig, HookCallback cb);
+    HookId add_observer_impl(void* key, std::string_view name, void* target_fn, const Signature& sig, PreObserverFn pre_fn, PostObserverFn post_fn);
+
+    // These expect a transaction to be open. cb.id/hook_id is already assigned.
+    std::optional<HookId> add_callback(void* key, std::string_view name, void* target_fn, const Signature& sig, HookCallback cb);
+    std::optional<HookId> add_observer_callback(void* key, std::string_view name, void* target_fn, const Signature& sig, HookId hook_id, PreObserverFn pre_fn, PostObserverFn post_fn);
+
+    void defer(std::function<void()> op);
+    void run_deferred();
+
+    // Requests the facilitator, which the backend generates along with the rest of the transaction's at commit.
+    void queue_install(void* key, HookedFn& hook, const Signature& sig);
+
+    // Replaces an installed observer-only hook's facilitator with a regular one.
+    void queue_conversion(void* key, HookedFn& hook, const Signature& sig);
+    void retire_observers(std::unique_ptr<std::vector<ObserverCallback>> list);
+
+    // Marks the hook to be enabled or disabled on commit, depending on whether it still has any callbacks.
+    void touch(HookedFn& hook);
+    bool install_pending();
+
+    std::unique_ptr<Backend> m_backend{};
+
+    // How many hooked functions this thread is inside of.
+    static inline thread_local uint32_t s_dispatch_depth{0};
+
+    std::mutex m_deferred_mux{};
+    std::vector<std::function<void()>> m_deferred{};
+    std::atomic<bool> m_has_deferred{false};
+
+    // Unique across all hooks; 0 is never handed out, so HookId{} means failure.
+    std::atomic<HookId> m_next_hook_id{1};
+
+    // Held for the duration of a transaction, and by every call that touches m_hooked_fns.
+    std::recursive_mutex m_mux{};
+    size_t m_transaction_depth{};
+    std::vector<PendingInstall> m_pending_installs{};
+    std::vector<HookedFn*> m_touched{};
+
+    std::mutex m_retired_mux{};
+    std::vector<RetiredObservers> m_retired{};
+
+    // Keyed by the REMethodDefinition for managed methods, or by the target for native functions.
+    std::unordered_map<void*, std::unique_ptr<HookedFn>> m_hooked_fns{};
 };
 
-inline HookManager g_hookman{};
\ No newline at end of file
+// Uses the MinHook backend; defined in HookManagerBackend.cpp.
+extern HookManager g_hookman;
\ No newline at end of file
@@ -0,0 +1,607 @@
+// The parts of HookManager that need the game process: the default backend, which generates the facilitators
+// with asmjit and patches the targets with MinHook, and the overloads that hook type database methods.
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+#include <asmjit/asmjit.h>
+#include <hde64.h>
+#include <MinHook.h>
+#include <spdlog/spdlog.h>
+
+#include "utility/FunctionHook.hpp"
+#include "sdk/RETypeDB.hpp"
+
+#include "HookManager.hpp"
+
+namespace detail {
+void* get_actual_function(void* possible_fn) {
+    auto actual_fn = possible_fn;
+    auto ip = (uintptr_t)possible_fn;
+
+    // Disassemble the first few instructions to see if there is a jmp to an actual function.
+    for (auto i = 0; i < 10; ++i) {
+        hde64s hde{};
+        auto len = hde64_disasm((void*)ip, &hde);
+        ip += len;
+
+        if (hde.opcode == 0xE9) { // jmp.
+            actual_fn = (void*)(ip + hde.imm.imm32);
+            break;
+        }
+    }
+
+    if (possible_fn != actual_fn) {
+        spdlog::info("[HookManager] Using actual function @ {:p} for wrapper function @ {:p}", actual_fn, possible_fn);
+    }
+
+    return actual_fn;
+}
+
+class MinHookBackend : public HookManager::Backend {
+public:
+    using HookedFn = HookManager::HookedFn;
+    using Signature = HookManager::Signature;
+    using Dispatch = HookManager::Dispatch;
+    using PreHookResult = HookManager::PreHookResult;
+
+    ~MinHookBackend() override;
+
+    std::vector<Facilitator> generate(const std::vector<FacilitatorRequest>& requests) override;
+    uintptr_t create(void* target, void* destination) override;
+    bool enable(const std::vector<void*>& targets) override;
+    bool disable(const std::vector<void*>& targets) override;
+    bool remove(void* target) override;
+
+private:
+    // Both emit into the given assembler and return the label of the
+    // slot that receives the trampoline to the original function.
+    asmjit::Label emit_facilitator(asmjit::x86::Assembler& a, HookedFn& hook, const Signature& sig);
+    asmjit::Label emit_observer_facilitator(asmjit::x86::Assembler& a, HookedFn& hook, const Signature& sig);
+
+    asmjit::JitRuntime m_jit{};
+    std::mutex m_jit_mux{};
+    std::vector<uintptr_t> m_blobs{};
+    std::unordered_map<void*, std::unique_ptr<FunctionHook>> m_hooks{};
+};
+
+MinHookBackend::~MinHookBackend() {
+    std::scoped_lock _{m_jit_mux};
+
+    for (auto blob : m_blobs) {
+        m_jit.release(blob);
+    }
+}
+
+std::vector<MinHookBackend::Facilitator> MinHookBackend::generate(const std::vector<FacilitatorRequest>& requests) {
+    using namespace asmjit::x86;
+
+    struct Labels {
+        asmjit::Label stub{};
+        asmjit::Label entry{};
+        asmjit::Label orig{};
+    };
+
+    asmjit::CodeHolder code{};
+    std::vector<Labels> labels{};
+
+    {
+        std::scoped_lock _{m_jit_mux};
+        code.init(m_jit.environment());
+    }
+
+    Assembler a{&code};
+
+    for (const auto& request : requests) {
+        auto& l = labels.emplace_back();
+
+        // rax is free on entry, it's neither an argument nor preserved.
+        if (!request.replace) {
+            l.stub = a.newLabel();
+            a.bind(l.stub);
+            a.mov(rax, (uint64_t)&request.hook->facilitator_fn);
+            a.jmp(ptr(rax));
+        }
+
+        l.entry = a.newLabel();
+        a.bind(l.entry);
+        l.orig = request.observer ? emit_observer_facilitator(a, *request.hook, request.sig) : emit_facilitator(a, *request.hook, request.sig);
+    }
+
+    uintptr_t blob{};
+
+    {
+        std::scoped_lock _{m_jit_mux};
+
+        if (m_jit.add(&blob, &code) != asmjit::kErrorOk) {
+            return {};
+        }
+
+        m_blobs.push_back(blob);
+    }
+
+    std::vector<Facilitator> facilitators{};
+
+    for (const auto& l : labels) {
+        auto& facilitator = facilitators.emplace_back();
+
+        facilitator.stub = l.stub.isValid() ? blob + code.labelOffsetFromBase(l.stub) : 0;
+        facilitator.entry = blob + code.labelOffsetFromBase(l.entry);
+        facilitator.original_slot = (uintptr_t*)(blob + code.labelOffsetFromBase(l.orig));
+    }
+
+    return facilitators;
+}
+
+uintptr_t MinHookBackend::create(void* target, void* destination) {
+    auto fn_hook = std::make_unique<FunctionHook>(target, destination);
+    auto original = fn_hook->get_original();
+
+    if (original != 0) {
+        m_hooks[target] = std::move(fn_hook);
+    }
+
+    return original;
+}
+
+bool MinHookBackend::enable(const std::vector<void*>& targets) {
+    auto result = true;
+
+    for (auto target : targets) {
+        if (auto status = MH_QueueEnableHook(target); status != MH_OK) {
+            spdlog::error("[HookManager] Failed to queue enable for {:p}: {}", target, MH_StatusToString(status));
+            result = false;
+        }
+    }
+
+    if (auto status = MH_ApplyQueued(); status != MH_OK) {
+        spdlog::error("[HookManager] Failed to enable {} hooks: {}", targets.size(), MH_StatusToString(status));
+        return false;
+    }
+
+    return result;
+}
+
+bool MinHookBackend::disable(const std::vector<void*>& targets) {
+    auto result = true;
+
+    for (auto target : targets) {
+        if (auto status = MH_QueueDisableHook(target); status != MH_OK) {
+            spdlog::error("[HookManager] Failed to queue disable for {:p}: {}", target, MH_StatusToString(status));
+            result = false;
+        }
+    }
+
+    if (auto status = MH_ApplyQueued(); status != MH_OK) {
+        spdlog::error("[HookManager] Failed to disable {} hooks: {}", targets.size(), MH_StatusToString(status));
+        return false;
+    }
+
+    return result;
+}
+
+bool MinHookBackend::remove(void* target) {
+    if (auto search = m_hooks.find(target); search != m_hooks.end()) {
+        auto result = search->second->remove();
+        m_hooks.erase(search);
+        return result;
+    }
+
+    return false;
+}
+
+asmjit::Label MinHookBackend::emit_facilitator(asmjit::x86::Assembler& a, HookedFn& hook, const Signature& sig) {
+    using namespace asmjit;
+    using namespace asmjit::x86;
+
+    // Generate the facilitator function that will store the arguments, call on_hook, 
+    // restore the arguments, and call the original function.
+    auto hook_label = a.newLabel();
+    auto args_label = a.newLabel();
+    auto this_label = a.newLabel();
+    auto dispatch_label = a.newLabel();
+    auto arg_tys_label = a.newLabel();
+    auto ret_addr_label = a.newLabel();
+    auto ret_val_label = a.newLabel();
+    auto orig_label = a.newLabel();
+    auto lock_label = a.newLabel();
+    auto unlock_label = a.newLabel();
+
+    // Save state.
+    a.push(rcx);
+    a.push(rdx);
+    a.push(r8);
+    a.push(r9);
+
+    // Lock context.
+    a.mov(rcx, ptr(hook_label));
+    a.sub(rsp, 40);
+    a.call(ptr(lock_label));
+    a.add(rsp, 40);
+
+    // Restore state.
+    a.pop(r9);
+    a.pop(r8);
+    a.pop(rdx);
+    a.pop(rcx);
+
+    // Store args.
+    a.mov(rax, ptr(args_label));
+
+    for (auto i = 0u; i < sig.num_args; ++i) {
+        auto args_offset = i * 8;
+        auto is_float = sig.is_float_arg(i);
+
+        switch (args_offset) {
+        case 0: // rcx/xmm0
+            if (is_float) {
+                a.movq(ptr(rax, args_offset), xmm0);
+            } else {
+                a.mov(ptr(rax, args_offset), rcx);
+            }
+            break;
+
+        case 8: // rdx/xmm1
+            if (is_float) {
+                a.movq(ptr(rax, args_offset), xmm1);
+            } else {
+                a.mov(ptr(rax, args_offset), rdx);
+            }
+            break;
+
+        case 16: // r8/xmm2
+            if (is_float) {
+                a.movq(ptr(rax, args_offset), xmm2);
+            } else {
+                a.mov(ptr(rax, args_offset), r8);
+            }
+            break;
+
+        case 24: // r9/xmm3
+            if (is_float) {
+                a.movq(ptr(rax, args_offset), xmm3);
+            } else {
+                a.mov(ptr(rax, args_offset), r9);
+            }
+            break;
+
+        default:
+            // stack args
+            a.mov(r10, ptr(rsp, sizeof(void*) + (args_offset)));
+            a.mov(ptr(rax, args_offset), r10);
+            break;
+        }
+    }
+
+    // Call the pre dispatcher, which is either on_pre_hook or a single raw callback.
+    a.mov(rax, ptr(dispatch_label));
+    a.mov(rcx, ptr(rax, offsetof(Dispatch, pre_data)));
+    a.mov(rdx, ptr(args_label));
+    a.mov(r8, (uint64_t)sig.num_args);
+    a.mov(r9, ptr(arg_tys_label));
+    a.sub(rsp, 40);
+    a.call(ptr(rax, offsetof(Dispatch, pre_fn)));
+    a.add(rsp, 40);
+
+    // Save the return value so we can see if we need to call the original later.
+    // PreHookResult is an int, so the upper half of rax is garbage.
+    a.mov(r11d, eax);
+
+    // Restore args.
+    a.mov(rax, ptr(args_label));
+
+    for (auto i = 0u; i < sig.num_args; ++i) {
+        auto args_offset = i * 8;
+        auto is_float = sig.is_float_arg(i);
+
+        switch (args_offset) {
+        case 0: // rcx/xmm0
+            if (is_float) {
+                a.movq(xmm0, ptr(rax, args_offset));
+            } else {
+                a.mov(rcx, ptr(rax, args_offset));
+            }
+            break;
+
+        case 8: // rdx/xmm1
+            if (is_float) {
+                a.movq(xmm1, ptr(rax, args_offset));
+            } else {
+                a.mov(rdx, ptr(rax, args_offset));
+            }
+            break;
+
+        case 16: // r8/xmm2
+            if (is_float) {
+                a.movq(xmm2, ptr(rax, args_offset));
+            } else {
+                a.mov(r8, ptr(rax, args_offset));
+            }
+            break;
+
+        case 24: // r9/xmm3
+            if (is_float) {
+                a.movq(xmm3, ptr(rax, args_offset));
+            } else {
+                a.mov(r9, ptr(rax, args_offset));
+            }
+            break;
+
+        default:
+            a.mov(r10, ptr(rax, args_offset));
+            a.mov(ptr(rsp, sizeof(void*) + (args_offset)), r10);
+            break;
+        }
+    }
+
+    // Call original function.
+    auto ret_label = a.newLabel();
+    auto skip_label = a.newLabel();
+
+    // Save return address.
+    a.mov(r10, ptr(rsp));
+    a.mov(rax, ptr(ret_addr_label));
+    a.mov(ptr(rax), r10);
+
+    // Overwrite return address.
+    a.lea(rax, ptr(ret_label));
+    a.mov(ptr(rsp), rax);
+
+    // Determine if we need to skip the original function or not.
+    a.cmp(r11, (int)PreHookResult::CALL_ORIGINAL);
+    a.jnz(skip_label);
+
+    // Jmp to original function.
+    a.jmp(ptr(orig_label));
+
+    a.bind(skip_label);
+    a.add(rsp, 8); // pop ret address.
+
+    a.bind(ret_label);
+
+    // Save return value.
+    a.mov(rcx, ptr(ret_val_label));
+
+    if (sig.float_ret) {
+        a.movq(ptr(rcx), xmm0);
+    } else {
+        a.mov(ptr(rcx), rax);
+    }
+
+    // Call the post dispatcher.
+    a.mov(rax, ptr(dispatch_label));
+    a.mov(rcx, ptr(rax, offsetof(Dispatch, post_data)));
+    a.mov(rdx, ptr(ret_val_label));
+    a.mov(r8, (uint64_t)hook.ret_ty);
+    a.call(ptr(rax, offsetof(Dispatch, post_fn)));
+
+    // Restore return value.
+    a.mov(rcx, ptr(ret_val_label));
+
+    if (sig.float_ret) {
+        a.movq(xmm0, ptr(rcx));
+    } else {
+        a.mov(rax, ptr(rcx));
+    }
+
+    // Store state.
+    a.push(rax);
+    a.mov(r10, ptr(ret_addr_label));
+    a.mov(r10, ptr(r10));
+    a.push(r10);
+
+    // Unlock context.
+    a.mov(rcx, ptr(hook_label));
+    a.sub(rsp, 32);
+    a.call(ptr(unlock_label));
+    a.add(rsp, 32);
+
+    // Restore state.
+    a.pop(r10);
+    a.pop(rax);
+
+    // Return.
+    a.jmp(r10);
+
+    a.bind(hook_label);
+    a.dq((uint64_t)&hook);
+    a.bind(args_label);
+    a.dq((uint64_t)hook.args.data());
+    a.bind(this_label);
+    a.dq((uint64_t)&hook.hookman);
+    a.bind(dispatch_label);
+    a.dq((uint64_t)&hook.dispatch);
+    a.bind(arg_tys_label);
+    a.dq((uint64_t)hook.arg_tys.data());
+    a.bind(lock_label);
+    a.dq((uint64_t)&HookedFn::lock_static);
+    a.bind(unlock_label);
+    a.dq((uint64_t)&HookedFn::unlock_static);
+    a.bind(ret_addr_label);
+    a.dq((uint64_t)&hook.ret_addr);
+    a.bind(ret_val_label);
+    a.dq((uint64_t)&hook.ret_val);
+    a.bind(orig_label);
+    // Can't do the following because the hook hasn't been created yet.
+    //a.dq(original_fn);
+    a.dq(0);
+
+    return orig_label;
+}
+
+asmjit::Label MinHookBackend::emit_observer_facilitator(asmjit::x86::Assembler& a, HookedFn& hook, const Signature& sig) {
+    using namespace asmjit;
+    using namespace asmjit::x86;
+
+    const auto num_args = sig.num_args;
+
+    // Unlike the facilitator in add, this one keeps everything in its own stack frame
+    // and calls the original normally instead of swapping out the return address.
+    // Frame layout, relative to rsp after the prologue:
+    //   [0, outgoing)           shadow space + stack args for the original function
+    //   [gpr_save, +32)         rcx, rdx, r8, r9
+    //   [xmm_save, +32)         xmm0-xmm3
+    //   [frame, +num_args * 8)  arguments as seen by the observers
+    //   [ret, +8)               return value as seen by the observers
+    //   [rax_save, +8)
+    //   [xmm0_save, +8)
+    const auto outgoing = (int32_t)(std::max<size_t>(num_args, 4) * 8);
+    const auto gpr_save = outgoing;
+    const auto xmm_save = gpr_save + 32;
+    const auto frame = xmm_save + 32;
+    const auto ret = frame + (int32_t)(num_args * 8);
+    const auto rax_save = ret + 8;
+    const auto xmm0_save = rax_save + 8;
+
+    // rsp is 8 mod 16 on entry, keep it 16 byte aligned for the calls we make.
+    const auto frame_size = ((xmm0_save + 8 + 15) & ~15) + 8;
+
+    auto hook_label = a.newLabel();
+    auto on_pre_observe_label = a.newLabel();
+    auto on_post_observe_label = a.newLabel();
+    auto orig_label = a.newLabel();
+
+    a.sub(rsp, frame_size);
+
+    // Save state.
+    a.mov(ptr(rsp, gpr_save), rcx);
+    a.mov(ptr(rsp, gpr_save + 8), rdx);
+    a.mov(ptr(rsp, gpr_save + 16), r8);
+    a.mov(ptr(rsp, gpr_save + 24), r9);
+    a.movq(ptr(rsp, xmm_save), xmm0);
+    a.movq(ptr(rsp, xmm_save + 8), xmm1);
+    a.movq(ptr(rsp, xmm_save + 16), xmm2);
+    a.movq(ptr(rsp, xmm_save + 24), xmm3);
+
+    // Store args for the observers, and copy the stack args for the original function.
+    for (auto i = 0u; i < num_args; ++i) {
+        auto is_float = sig.is_float_arg(i);
+
+        if (i < 4) {
+            static const Gp gprs[] = {rcx, rdx, r8, r9};
+            static const Xmm xmms[] = {xmm0, xmm1, xmm2, xmm3};
+
+            if (is_float) {
+                a.movq(ptr(rsp, frame + i * 8), xmms[i]);
+            } else {
+                a.mov(ptr(rsp, frame + i * 8), gprs[i]);
+            }
+        } else {
+            a.mov(r10, ptr(rsp, frame_size + 8 + i * 8));
+            a.mov(ptr(rsp, frame + i * 8), r10);
+            a.mov(ptr(rsp, i * 8), r10);
+        }
+    }
+
+    // Call on_pre_observe.
+    a.mov(rcx, ptr(hook_label));
+    a.lea(rdx, ptr(rsp, frame));
+    a.call(ptr(on_pre_observe_label));
+
+    // Restore state.
+    a.mov(rcx, ptr(rsp, gpr_save));
+    a.mov(rdx, ptr(rsp, gpr_save + 8));
+    a.mov(r8, ptr(rsp, gpr_save + 16));
+    a.mov(r9, ptr(rsp, gpr_save + 24));
+    a.movq(xmm0, ptr(rsp, xmm_save));
+    a.movq(xmm1, ptr(rsp, xmm_save + 8));
+    a.movq(xmm2, ptr(rsp, xmm_save + 16));
+    a.movq(xmm3, ptr(rsp, xmm_save + 24));
+
+    // Call original function.
+    a.call(ptr(orig_label));
+
+    // Save return value.
+    a.mov(ptr(rsp, rax_save), rax);
+    a.movq(ptr(rsp, xmm0_save), xmm0);
+
+    if (sig.float_ret) {
+        a.movq(ptr(rsp, ret), xmm0);
+    } else {
+        a.mov(ptr(rsp, ret), rax);
+    }
+
+    // Call on_post_observe.
+    a.mov(rcx, ptr(hook_label));
+    a.lea(rdx, ptr(rsp, frame));
+    a.call(ptr(on_post_observe_label));
+
+    // Restore return value.
+    a.mov(rax, ptr(rsp, rax_save));
+    a.movq(xmm0, ptr(rsp, xmm0_save));
+
+    // Return.
+    a.add(rsp, frame_size);
+    a.ret();
+
+    a.bind(hook_label);
+    a.dq((uint64_t)&hook);
+    a.bind(on_pre_observe_label);
+    a.dq((uint64_t)&HookedFn::on_pre_observe_static);
+    a.bind(on_post_observe_label);
+    a.dq((uint64_t)&HookedFn::on_post_observe_static);
+    a.bind(orig_label);
+    a.dq(0);
+
+    return orig_label;
+}
+}
+
+HookManager g_hookman{std::make_unique<detail::MinHookBackend>()};
+
+HookManager::Signature HookManager::Signature::from_method(sdk::REMethodDefinition* fn) {
+    Signature sig{};
+
+    // The thread context is always passed first, followed by the this ptr if there is one.
+    const auto params_start = fn->is_static() ? 1u : 2u;
+
+    sig.arg_tys = fn->get_param_types();
+    sig.ret_ty = fn->get_return_type();
+    sig.num_args = 2 + fn->get_num_params();
+
+    for (auto i = 0u; i < sig.arg_tys.size(); ++i) {
+        if (sig.arg_tys[i]->get_full_name() == "System.Single" && params_start + i < 64) {
+            sig.float_args |= 1ull << (params_start + i);
+        }
+    }
+
+    sig.float_ret = sig.ret_ty != nullptr && sig.ret_ty->get_full_name() == "System.Single";
+
+    return sig;
+}
+
+HookManager::HookId HookManager::add(sdk::REMethodDefinition* fn, HookManager::PreHookFn pre_fn, HookManager::PostHookFn post_fn, bool ignore_jmp) {
+    if (fn == nullptr) {
+        //throw std::exception{"[HookManager] Cannot add nullptr function"};
+        spdlog::error("[HookManager] Cannot add nullptr function");
+        return HookId{};
+    }
+    
+    auto target_fn = ignore_jmp ? fn->get_function() : detail::get_actual_function(fn->get_function());
+
+    return add_impl(fn, fn->get_name(), target_fn, Signature::from_method(fn), HookCallback{{}, std::move(pre_fn), std::move(post_fn)});
+}
+
+HookManager::HookId HookManager::add_raw(sdk::REMethodDefinition* fn, RawPreHookFn pre_fn, void* pre_data, RawPostHookFn post_fn, void* post_data, bool ignore_jmp) {
+    if (fn == nullptr) {
+        spdlog::error("[HookManager] Cannot add nullptr function");
+        return HookId{};
+    }
+
+    auto target_fn = ignore_jmp ? fn->get_function() : detail::get_actual_function(fn->get_function());
+
+    return add_impl(fn, fn->get_name(), target_fn, Signature::from_method(fn), HookCallback{{}, {}, {}, pre_fn, post_fn, pre_data, post_data});
+}
+
+HookManager::HookId HookManager::add_observer(sdk::REMethodDefinition* fn, HookManager::PreObserverFn pre_fn, HookManager::PostObserverFn post_fn, bool ignore_jmp) {
+    if (fn == nullptr) {
+        spdlog::error("[HookManager] Cannot add nullptr function");
+        return HookId{};
+    }
+
+    auto target_fn = ignore_jmp ? fn->get_function() : detail::get_actual_function(fn->get_function());
+
+    return add_observer_impl(fn, fn->get_name(), target_fn, Signature::from_method(fn), std::move(pre_fn), std::move(post_fn));
+}
@@ -332,6 +332,32 @@ protected:
     bool m_waiting_for_new_key{ false };
 };
 
+// The game-specific callbacks in Mod. Hooks only calls these on the mods subscribed to them.
+enum class ModCallback : uint8_t {
+    PRE_UPDATE_TRANSFORM,
+    UPDATE_TRANSFORM,
+    PRE_UPDATE_CAMERA_CONTROLLER,
+    UPDATE_CAMERA_CONTROLLER,
+    PRE_UPDATE_CAMERA_CONTROLLER2,
+    UPDATE_CAMERA_CONTROLLER2,
+    PRE_GUI_DRAW_ELEMENT,
+    GUI_DRAW_ELEMENT,
+    PRE_UPDATE_BEFORE_LOCK_SCENE,
+    UPDATE_BEFORE_LOCK_SCENE,
+    PRE_LIGHTSHAFT_DRAW,
+    LIGHTSHAFT_DRAW,
+    PRE_APPLICATION_ENTRY,
+    APPLICATION_ENTRY,
+    COUNT,
+};
+
+struct ModSubscription {
+    ModCallback callback{};
+
+    // Only used by the application entry callbacks, as "Name"_fnv hashes. Empty means every entry.
+    std::vector<size_t> entry_hashes{};
+};
+
 class Mod {
 protected:
     using ValueList = std::vector<std::reference_wrapper<IModValue>>;
@@ -365,6 +391,10 @@ public:
     virtual void on_config_load(const utility::Config& cfg) {};
     virtual void on_config_save(utility::Config& cfg) {};
 
+    // Which of the game-specific callbacks below this mod implements. Gathered once after every mod
+    // has been initialized; a mod that overrides one of them without subscribing never gets it called.
+    virtual std::vector<ModSubscription> get_subscriptions() const { return {}; };
+
     // Game-specific callbacks
     virtual void on_pre_update_transform(RETransform* transform) {};
     virtual void on_update_transform(RETransform* transform) {};
@@ -380,6 +410,7 @@ public:
     virtual void on_lightshaft_draw(void* shaft, void* render_context) {};
     // via.application entry hooks
     // For a list of possible entries, see via.ModuleEntry enum
-    virtual void on_pre_application_entry(void* entry, const char* name, size_t hash) {};
-    virtual void on_application_entry(void* entry, const char* name, size_t hash) {};
+    // id is the dense index from Hooks::get_application_entry_id, for callers that keep per-entry arrays
+    virtual void on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) {};
+    virtual void on_application_entry(void* entry, const char* name, size_t hash, size_t id) {};
 };
\ No newline at end of file
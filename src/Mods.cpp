@@ -70,7 +70,7 @@ Mods::Mods() {
     m_mods.emplace_back(ScriptRunner::get());
 }
 
-std::optional<std::string> Mods::on_initialize() const {
+std::optional<std::string> Mods::on_initialize() {
     for (auto& mod : m_mods) {
         spdlog::info("{:s}::on_initialize()", mod->get_name().data());
 
@@ -87,9 +87,76 @@ std::optional<std::string> Mods::on_initialize() const {
         mod->on_config_load(cfg);
     }
 
+    build_subscriptions();
+
     return std::nullopt;
 }
 
+const std::vector<Mod*>& Mods::get_entry_subscribers(ModCallback cb, size_t hash) const {
+    const auto& entries = m_entry_subscribers[cb == ModCallback::PRE_APPLICATION_ENTRY ? 0 : 1];
+
+    if (auto it = entries.find(hash); it != entries.end()) {
+        return it->second;
+    }
+
+    // Nobody filtered on this entry, so it's just the mods that take every entry.
+    return get_subscribers(cb);
+}
+
+void Mods::build_subscriptions() {
+    std::vector<std::pair<Mod*, std::vector<ModSubscription>>> all_subscriptions{};
+
+    for (auto& mod : m_mods) {
+        all_subscriptions.emplace_back(mod.get(), mod->get_subscriptions());
+    }
+
+    auto entry_index = [](ModCallback cb) -> std::optional<size_t> {
+        switch (cb) {
+        case ModCallback::PRE_APPLICATION_ENTRY:
+            return 0;
+        case ModCallback::APPLICATION_ENTRY:
+            return 1;
+        default:
+            return std::nullopt;
+        }
+    };
+
+    // Every entry someone filtered on gets its own list, so create those first.
+    for (const auto& [mod, subscriptions] : all_subscriptions) {
+        for (const auto& sub : subscriptions) {
+            if (auto index = entry_index(sub.callback); index) {
+                for (auto hash : sub.entry_hashes) {
+                    m_entry_subscribers[*index][hash];
+                }
+            }
+        }
+    }
+
+    for (const auto& [mod, subscriptions] : all_subscriptions) {
+        for (const auto& sub : subscriptions) {
+            auto index = entry_index(sub.callback);
+
+            if (!index || sub.entry_hashes.empty()) {
+                m_subscribers[(size_t)sub.callback].push_back(mod);
+            }
+
+            if (!index) {
+                continue;
+            }
+
+            for (auto& [hash, subscribers] : m_entry_subscribers[*index]) {
+                if (sub.entry_hashes.empty() || std::find(sub.entry_hashes.begin(), sub.entry_hashes.end(), hash) != sub.entry_hashes.end()) {
+                    subscribers.push_back(mod);
+                }
+            }
+        }
+    }
+
+    for (auto i = 0; i < (int)ModCallback::COUNT; ++i) {
+        spdlog::info("[Mods] Callback {} has {} subscribers", i, m_subscribers[i].size());
+    }
+}
+
 void Mods::on_pre_imgui_frame() const {
     for (auto& mod : m_mods) {
         mod->on_pre_imgui_frame();
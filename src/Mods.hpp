@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <unordered_map>
+
 #include "Mod.hpp"
 
 class Mods {
@@ -7,7 +10,7 @@ public:
     Mods();
     virtual ~Mods() {}
 
-    std::optional<std::string> on_initialize() const;
+    std::optional<std::string> on_initialize();
 
     void on_pre_imgui_frame() const;
     void on_frame() const;
@@ -20,6 +23,20 @@ public:
         return m_mods;
     }
 
+    // Mods subscribed to the callback, in the same order as get_mods.
+    const std::vector<Mod*>& get_subscribers(ModCallback cb) const {
+        return m_subscribers[(size_t)cb];
+    }
+
+    // For PRE_APPLICATION_ENTRY and APPLICATION_ENTRY. Includes the mods subscribed to every entry.
+    const std::vector<Mod*>& get_entry_subscribers(ModCallback cb, size_t hash) const;
+
 private:
+    void build_subscriptions();
+
     std::vector<std::shared_ptr<Mod>> m_mods;
+
+    // Built once in on_initialize, before the hooks start calling into mods, and never modified afterwards.
+    std::array<std::vector<Mod*>, (size_t)ModCallback::COUNT> m_subscribers{};
+    std::array<std::unordered_map<size_t, std::vector<Mod*>>, 2> m_entry_subscribers{};
 };
\ No newline at end of file
@@ -23,8 +23,11 @@ extern "C" {
 #include "utility/Thread.hpp"
 
 #include "Mods.hpp"
+#include "mods/FileWorker.hpp"
 #include "mods/PluginLoader.hpp"
 #include "sdk/REGlobals.hpp"
+#include "sdk/Renderer.hpp"
+#include "sdk/SceneSnapshot.hpp"
 #include "sdk/SDK.hpp"
 
 #include "ExceptionHandler.hpp"
@@ -653,6 +656,12 @@ void REFramework::on_reset() {
 bool REFramework::on_message(HWND wnd, UINT message, WPARAM w_param, LPARAM l_param) {
     m_last_message_time = std::chrono::steady_clock::now();
 
+    // The game is shutting down. Flush script file writes while it's still safe to wait on a thread;
+    // by the time static destructors run, it isn't.
+    if (message == WM_DESTROY && wnd == m_wnd) {
+        g_file_worker.shutdown();
+    }
+
     if (!m_initialized) {
         return true;
     }
@@ -1306,10 +1315,57 @@ bool REFramework::initialize_windows_message_hook() {
     return false;
 }
 
+#ifdef DEVELOPER
+namespace detail {
+// world_to_screen replaced calls to via.math.worldPos2ScreenPos; check that it still lands on the same pixels
+// for a few points in front of the camera, once per frame. Warnings are throttled so a mismatch doesn't flood the log.
+void check_world_to_screen_parity() {
+    constexpr auto TOLERANCE = 0.5f; // pixels
+    static auto s_next_warning = std::chrono::steady_clock::time_point{};
+
+    const auto camera = sdk::renderer::get_camera_snapshot();
+
+    if (!camera) {
+        return;
+    }
+
+    const auto ahead = Vector3f{camera->origin - camera->forward * 10.0f};
+    const Vector3f probes[] = {ahead, ahead + Vector3f{2.0f, 0.0f, 0.0f}, ahead + Vector3f{0.0f, 2.0f, 0.0f}, ahead + Vector3f{0.0f, 0.0f, 2.0f}};
+
+    for (const auto& probe : probes) {
+        const auto native = sdk::renderer::world_to_screen(*camera, probe);
+        const auto managed = sdk::renderer::world_to_screen_managed(*camera, probe);
+
+        const auto matches = native.has_value() == managed.has_value() &&
+            (!native || glm::length(*native - *managed) <= TOLERANCE);
+
+        if (matches || std::chrono::steady_clock::now() < s_next_warning) {
+            continue;
+        }
+
+        spdlog::warn("[REFramework] world_to_screen disagrees with via.math.worldPos2ScreenPos at ({}, {}, {}): native {}, managed {}",
+            probe.x, probe.y, probe.z,
+            native ? fmt::format("({}, {})", native->x, native->y) : "behind",
+            managed ? fmt::format("({}, {})", managed->x, managed->y) : "behind");
+
+        s_next_warning = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    }
+}
+}
+#endif
+
 void REFramework::call_on_frame() {
     const bool is_init_ok = m_error.empty() && m_game_data_initialized;
 
     if (is_init_ok) {
+        // Everything walking the scene this frame shares one walk of it.
+        // The camera snapshot is handled by the application entry hook instead, since the camera can change between entries.
+        sdk::invalidate_scene_snapshot();
+
+#ifdef DEVELOPER
+        detail::check_world_to_screen_parity();
+#endif
+
         // Run mod frame callbacks.
         m_mods->on_frame();
     }
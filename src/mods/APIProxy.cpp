@@ -1,5 +1,6 @@
 #include "utility/String.hpp"
 
+#include "Hooks.hpp"
 #include "ScriptRunner.hpp"
 
 #include "PluginLoader.hpp"
@@ -15,10 +16,10 @@ bool APIProxy::add_on_lua_state_created(APIProxy::REFLuaStateCreatedCb cb) {
 
     m_on_lua_state_created_cbs.push_back(cb);
 
-    auto& state = ScriptRunner::get()->get_state();
-
-    if (state != nullptr && state->lua().lua_state() != nullptr) {
-        cb(state->lua());
+    for (auto& state : ScriptRunner::get()->get_states()) {
+        if (state->lua().lua_state() != nullptr) {
+            cb(state->lua());
+        }
     }
 
     return true;
@@ -45,9 +46,18 @@ bool APIProxy::add_on_pre_application_entry(std::string_view name, REFOnPreAppli
         return false;
     }
 
-    const auto name_hash = utility::hash(name);
+    const auto id = Hooks::get_application_entry_id(name);
+
+    // Entries that were never hooked can't fire.
+    if (!id) {
+        return false;
+    }
+
+    if (*id >= m_on_pre_application_entry_cbs.size()) {
+        m_on_pre_application_entry_cbs.resize(*id + 1);
+    }
 
-    m_on_pre_application_entry_cbs[name_hash].push_back(cb);
+    m_on_pre_application_entry_cbs[*id].push_back(cb);
     return true;
 }
 
@@ -58,9 +68,18 @@ bool APIProxy::add_on_post_application_entry(std::string_view name, REFOnPostApp
         return false;
     }
 
-    const auto name_hash = utility::hash(name);
+    const auto id = Hooks::get_application_entry_id(name);
 
-    m_on_post_application_entry_cbs[name_hash].push_back(cb);
+    // Entries that were never hooked can't fire.
+    if (!id) {
+        return false;
+    }
+
+    if (*id >= m_on_post_application_entry_cbs.size()) {
+        m_on_post_application_entry_cbs.resize(*id + 1);
+    }
+
+    m_on_post_application_entry_cbs[*id].push_back(cb);
     return true;
 }
 
@@ -129,11 +148,19 @@ void APIProxy::on_present() {
     }
 }
 
-void APIProxy::on_pre_application_entry(void* entry, const char* name, size_t hash) {
+std::vector<ModSubscription> APIProxy::get_subscriptions() const {
+    // Plugins can register for any entry at any time.
+    return {
+        {ModCallback::PRE_APPLICATION_ENTRY},
+        {ModCallback::APPLICATION_ENTRY},
+    };
+}
+
+void APIProxy::on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     std::shared_lock _{m_api_cb_mtx};
 
-    if (auto it = m_on_pre_application_entry_cbs.find(hash); it != m_on_pre_application_entry_cbs.end()) {
-        for (auto&& cb : it->second) {
+    if (id < m_on_pre_application_entry_cbs.size()) {
+        for (auto&& cb : m_on_pre_application_entry_cbs[id]) {
             try {
                 cb();
             } catch(...) {
@@ -143,11 +170,11 @@ void APIProxy::on_pre_application_entry(void* entry, const char* name, size_t ha
     }
 }
 
-void APIProxy::on_application_entry(void* entry, const char* name, size_t hash) {
+void APIProxy::on_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     std::shared_lock _{m_api_cb_mtx};
 
-    if (auto it = m_on_post_application_entry_cbs.find(hash); it != m_on_post_application_entry_cbs.end()) {
-        for (auto&& cb : it->second) {
+    if (id < m_on_post_application_entry_cbs.size()) {
+        for (auto&& cb : m_on_post_application_entry_cbs[id]) {
             try {
                 cb();
             } catch(...) {
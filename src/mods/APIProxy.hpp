@@ -17,8 +17,9 @@ public:
     void on_present() override;
     void on_lua_state_created(sol::state& state) override;
     void on_lua_state_destroyed(sol::state& state) override;
-    void on_pre_application_entry(void* entry, const char* name, size_t hash) override;
-    void on_application_entry(void* entry, const char* name, size_t hash) override;
+    std::vector<ModSubscription> get_subscriptions() const override;
+    void on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
+    void on_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
     void on_device_reset() override;
     bool on_message(HWND wnd, UINT message, WPARAM w_param, LPARAM l_param) override;
 
@@ -48,7 +49,7 @@ private:
     std::vector<APIProxy::REFOnDeviceResetCb> m_on_device_reset_cbs{};
     std::vector<APIProxy::REFOnMessageCb> m_on_message_cbs{};
 
-    // Application Entry Callbacks
-    std::unordered_map<size_t, std::vector<APIProxy::REFOnPreApplicationEntryCb>> m_on_pre_application_entry_cbs{};
-    std::unordered_map<size_t, std::vector<APIProxy::REFOnPostApplicationEntryCb>> m_on_post_application_entry_cbs{};
+    // Application Entry Callbacks, indexed by Hooks::get_application_entry_id
+    std::vector<std::vector<APIProxy::REFOnPreApplicationEntryCb>> m_on_pre_application_entry_cbs{};
+    std::vector<std::vector<APIProxy::REFOnPostApplicationEntryCb>> m_on_post_application_entry_cbs{};
 };
\ No newline at end of file
@@ -50,6 +50,16 @@ void Camera::on_draw_ui() {
     m_global_fov->draw("Global FOV");
 }
 
+std::vector<ModSubscription> Camera::get_subscriptions() const {
+    return {
+#ifdef RE8
+        {ModCallback::UPDATE_TRANSFORM},
+#endif
+        {ModCallback::PRE_APPLICATION_ENTRY, {"BeginRendering"_fnv}},
+        {ModCallback::APPLICATION_ENTRY, {"LockScene"_fnv}},
+    };
+}
+
 void Camera::on_update_transform(RETransform* transform) {
 #ifdef RE8
     if (!m_enabled->value()) {
@@ -79,7 +89,7 @@ void Camera::on_update_transform(RETransform* transform) {
 #endif
 }
 
-void Camera::on_pre_application_entry(void* entry, const char* name, size_t hash) {
+void Camera::on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     if (hash == "BeginRendering"_fnv) {
         if (m_use_custom_global_fov->value()) {
             auto camera = sdk::get_primary_camera();
@@ -95,7 +105,7 @@ void Camera::on_pre_application_entry(void* entry, const char* name, size_t hash
     }
 }
 
-void Camera::on_application_entry(void* entry, const char* name, size_t hash) {
+void Camera::on_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     if (!m_enabled->value()) {
         return;
     }
@@ -63,9 +63,10 @@ public:
 
     void on_draw_ui() override;
 
+    std::vector<ModSubscription> get_subscriptions() const override;
     void on_update_transform(RETransform* transform);
-    void on_pre_application_entry(void* entry, const char* name, size_t hash) override;
-    void on_application_entry(void* entry, const char* name, size_t hash) override;
+    void on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
+    void on_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
 
 private:
     const ModToggle::Ptr m_enabled{ ModToggle::create(generate_name("Enabled"), false) };
@@ -1,6 +1,8 @@
 #include "tools/GameObjectsDisplay.hpp"
 #include "tools/ChainViewer.hpp"
 #include "tools/ObjectExplorer.hpp"
+#include "tools/HookBenchmark.hpp"
+#include "tools/SdkTrace.hpp"
 
 #include "DeveloperTools.hpp"
 
@@ -8,6 +10,8 @@ DeveloperTools::DeveloperTools() {
     m_tools.emplace_back(std::make_shared<ChainViewer>());
     m_tools.emplace_back(std::make_shared<GameObjectsDisplay>());
     m_tools.emplace_back(ObjectExplorer::get());
+    m_tools.emplace_back(std::make_shared<HookBenchmark>());
+    m_tools.emplace_back(std::make_shared<SdkTrace>());
 }
 
 void DeveloperTools::on_draw_ui() {
@@ -0,0 +1,261 @@
+#include <fstream>
+#include <iterator>
+
+#include <spdlog/spdlog.h>
+
+#include "FileWorker.hpp"
+
+FileWorker::~FileWorker() {
+    // No joining here (see the class comment). By now the process is exiting and the thread is gone or about to be;
+    // detaching just keeps std::thread from terminating over it.
+    if (m_thread != nullptr && m_thread->joinable()) {
+        m_thread->detach();
+    }
+}
+
+void FileWorker::shutdown() {
+    std::unique_ptr<std::thread> thread{};
+
+    {
+        std::scoped_lock _{m_mtx};
+        m_stop = true;
+        thread = std::move(m_thread);
+    }
+
+    m_cv.notify_all();
+
+    // Queued writes still get written; that's usually someone's save data.
+    if (thread != nullptr && thread->joinable()) {
+        thread->join();
+    }
+}
+
+void FileWorker::cancel_pending_write(const std::filesystem::path& path) {
+    const auto key = get_key(path);
+    std::shared_ptr<Job> cancelled{};
+
+    {
+        std::unique_lock lock{m_mtx};
+
+        auto it = m_writes.find(key);
+
+        if (it == m_writes.end()) {
+            return;
+        }
+
+        if (it->second->started) {
+            const auto job = it->second;
+            m_done_cv.wait(lock, [&]() {
+                const auto current = m_writes.find(key);
+                return current == m_writes.end() || current->second != job;
+            });
+
+            return;
+        }
+
+        cancelled = std::move(it->second);
+        m_writes.erase(it);
+        std::erase(m_jobs, cancelled);
+    }
+
+    for (auto& on_done : cancelled->completions) {
+        try {
+            on_done(false, {}, "superseded by a synchronous write to " + cancelled->path.string());
+        } catch (const std::exception& e) {
+            spdlog::error("[FileWorker] Completion for {} threw: {}", cancelled->path.string(), e.what());
+        }
+    }
+}
+
+void FileWorker::read(std::filesystem::path path, bool binary, Completion on_done) {
+    auto job = std::make_shared<Job>();
+    job->binary = binary;
+    job->path = std::move(path);
+    job->completions.push_back(std::move(on_done));
+
+    enqueue(std::move(job));
+}
+
+void FileWorker::write(std::filesystem::path path, std::string data, bool binary, Completion on_done) {
+    const auto key = get_key(path);
+
+    {
+        std::scoped_lock _{m_mtx};
+
+        if (auto it = m_writes.find(key); it != m_writes.end() && !it->second->started) {
+            auto& job = *it->second;
+            job.data = std::move(data);
+            job.binary = binary;
+            job.completions.push_back(std::move(on_done));
+            return;
+        }
+    }
+
+    auto job = std::make_shared<Job>();
+    job->is_write = true;
+    job->binary = binary;
+    job->path = std::move(path);
+    job->data = std::move(data);
+    job->completions.push_back(std::move(on_done));
+
+    enqueue(std::move(job));
+}
+
+void FileWorker::write(std::filesystem::path path, std::function<std::string()> make_data, bool binary, Completion on_done) {
+    auto job = std::make_shared<Job>();
+    job->is_write = true;
+    job->binary = binary;
+    job->path = std::move(path);
+    job->make_data = std::move(make_data);
+    job->completions.push_back(std::move(on_done));
+
+    enqueue(std::move(job));
+}
+
+std::optional<std::string> FileWorker::get_pending_write(const std::filesystem::path& path) {
+    std::scoped_lock _{m_mtx};
+
+    if (auto it = m_writes.find(get_key(path)); it != m_writes.end()) {
+        return it->second->data;
+    }
+
+    return std::nullopt;
+}
+
+size_t FileWorker::get_num_queued() {
+    std::scoped_lock _{m_mtx};
+    return m_jobs.size();
+}
+
+std::string FileWorker::get_key(const std::filesystem::path& path) {
+    return path.lexically_normal().string();
+}
+
+void FileWorker::enqueue(std::shared_ptr<Job> job) {
+    {
+        std::unique_lock lock{m_mtx};
+
+        if (m_stop) {
+            lock.unlock();
+
+            for (auto& on_done : job->completions) {
+                on_done(false, {}, "the file worker has shut down");
+            }
+
+            return;
+        }
+
+        if (job->is_write && !job->make_data) {
+            m_writes[get_key(job->path)] = job;
+        }
+
+        m_jobs.push_back(std::move(job));
+
+        // Started on first use rather than during static initialization.
+        if (m_thread == nullptr) {
+            m_thread = std::make_unique<std::thread>(&FileWorker::run, this);
+        }
+    }
+
+    m_cv.notify_one();
+}
+
+void FileWorker::run() {
+    while (true) {
+        std::shared_ptr<Job> job{};
+
+        {
+            std::unique_lock lock{m_mtx};
+            m_cv.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+
+            if (m_jobs.empty()) {
+                return; // stopping, and nothing left to do
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            job->started = true;
+        }
+
+        bool ok{};
+        std::string data{};
+        std::string error{};
+
+        try {
+            if (job->make_data) {
+                job->data = job->make_data();
+            }
+
+            execute(*job, ok, data, error);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+
+        if (job->is_write) {
+            std::scoped_lock _{m_mtx};
+
+            if (auto it = m_writes.find(get_key(job->path)); it != m_writes.end() && it->second == job) {
+                m_writes.erase(it);
+            }
+
+            m_done_cv.notify_all();
+        }
+
+        for (auto& on_done : job->completions) {
+            try {
+                on_done(ok, data, error);
+            } catch (const std::exception& e) {
+                spdlog::error("[FileWorker] Completion for {} threw: {}", job->path.string(), e.what());
+            }
+        }
+    }
+}
+
+void FileWorker::execute(Job& job, bool& ok, std::string& data, std::string& error) {
+    const auto mode = job.binary ? std::ios::binary : std::ios::openmode{};
+
+    if (!job.is_write) {
+        std::ifstream file{job.path, std::ios::in | mode};
+
+        if (!file) {
+            error = "could not open " + job.path.string();
+            return;
+        }
+
+        data.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+        ok = true;
+        return;
+    }
+
+    std::error_code ec{};
+    std::filesystem::create_directories(job.path.parent_path(), ec);
+
+    auto temp_path = job.path;
+    temp_path += ".tmp";
+
+    {
+        std::ofstream file{temp_path, std::ios::out | std::ios::trunc | mode};
+
+        if (!file) {
+            error = "could not open " + temp_path.string();
+            return;
+        }
+
+        file.write(job.data.data(), job.data.size());
+
+        if (!file.good()) {
+            error = "could not write " + temp_path.string();
+            return;
+        }
+    }
+
+    std::filesystem::rename(temp_path, job.path, ec);
+
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        error = "could not replace " + job.path.string();
+        return;
+    }
+
+    ok = true;
+}
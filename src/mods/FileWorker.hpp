@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// One background thread that does file reads and writes for scripts, so saving doesn't stall the frame.
+//
+// Jobs run in the order they were queued. Writes go to a temporary file that's renamed over the target,
+// so a crash mid-write never leaves a truncated file behind. A write to a path that already has a write waiting
+// replaces that write's data instead of queueing another one; every caller still gets its completion.
+//
+// shutdown() has to be called before the DLL goes away. The destructor runs during static teardown,
+// under the loader lock, where waiting for the thread to exit would deadlock, so it doesn't.
+class FileWorker {
+public:
+    // Called on the worker thread, or on the thread that cancels the job.
+    using Completion = std::function<void(bool ok, std::string data, std::string error)>;
+
+    FileWorker() = default;
+    ~FileWorker();
+
+    void read(std::filesystem::path path, bool binary, Completion on_done);
+    void write(std::filesystem::path path, std::string data, bool binary, Completion on_done);
+
+    // For output that's too big to build on the calling thread. make_data runs on the worker thread.
+    // These aren't merged with other writes, and get_pending_write doesn't see them.
+    void write(std::filesystem::path path, std::function<std::string()> make_data, bool binary, Completion on_done);
+
+    // The data of a write that's queued or in progress, so synchronous reads see it before it lands.
+    std::optional<std::string> get_pending_write(const std::filesystem::path& path);
+
+    // For synchronous writes, which would otherwise be clobbered by an older queued write landing after them.
+    // A write to path that hasn't started is dropped and its callers are told it was superseded;
+    // one that's in progress is waited for.
+    void cancel_pending_write(const std::filesystem::path& path);
+
+    // Writes out everything still queued and stops the thread. Anything queued afterwards fails right away.
+    void shutdown();
+
+    size_t get_num_queued();
+
+private:
+    struct Job {
+        bool is_write{};
+        bool binary{};
+        bool started{};
+        std::filesystem::path path{};
+        std::string data{};
+        std::function<std::string()> make_data{};
+        std::vector<Completion> completions{};
+    };
+
+    static std::string get_key(const std::filesystem::path& path);
+
+    void enqueue(std::shared_ptr<Job> job);
+    void run();
+    void execute(Job& job, bool& ok, std::string& data, std::string& error);
+
+    std::mutex m_mtx{};
+    std::condition_variable m_cv{};
+    std::condition_variable m_done_cv{}; // a write finished and left m_writes
+    std::deque<std::shared_ptr<Job>> m_jobs{};
+    std::unordered_map<std::string, std::shared_ptr<Job>> m_writes{}; // by path, until they complete
+    std::unique_ptr<std::thread> m_thread{};
+    bool m_stop{false};
+};
+
+inline FileWorker g_file_worker{};
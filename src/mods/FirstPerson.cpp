@@ -299,6 +299,17 @@ void FirstPerson::on_config_save(utility::Config& cfg) {
     }
 }
 
+std::vector<ModSubscription> FirstPerson::get_subscriptions() const {
+    return {
+        {ModCallback::PRE_UPDATE_TRANSFORM},
+        {ModCallback::UPDATE_TRANSFORM},
+        {ModCallback::UPDATE_CAMERA_CONTROLLER},
+        {ModCallback::UPDATE_CAMERA_CONTROLLER2},
+        {ModCallback::PRE_APPLICATION_ENTRY, {"UpdateBehavior"_fnv, "LateUpdateBehavior"_fnv, "UnlockScene"_fnv}},
+        {ModCallback::APPLICATION_ENTRY, {"UpdateMotion"_fnv, "LateUpdateBehavior"_fnv}},
+    };
+}
+
 thread_local bool g_in_player_transform = false;
 thread_local bool g_first_time = true;
 thread_local glm::quat g_old_rotation{};
@@ -477,7 +488,7 @@ void FirstPerson::on_update_camera_controller2(RopewayPlayerCameraController* co
     m_last_controller_rotation = *(glm::quat*) & controller->worldRotation;
 }
 
-void FirstPerson::on_pre_application_entry(void* entry, const char* name, size_t hash) {
+void FirstPerson::on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     switch (hash) {
         case "UpdateBehavior"_fnv:
             on_pre_update_behavior(entry);
@@ -493,7 +504,7 @@ void FirstPerson::on_pre_application_entry(void* entry, const char* name, size_t
     }
 }
 
-void FirstPerson::on_application_entry(void* entry, const char* name, size_t hash) {
+void FirstPerson::on_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     switch (hash) {
         case "UpdateMotion"_fnv:
             on_post_update_motion(entry, true); // fixes like literally every problem ever to exist
@@ -35,13 +35,14 @@ public:
     void on_config_load(const utility::Config& cfg) override;
     void on_config_save(utility::Config& cfg) override;
 
+    std::vector<ModSubscription> get_subscriptions() const override;
     void on_pre_update_transform(RETransform* transform) override;
     void on_update_transform(RETransform* transform) override;
     void on_update_camera_controller(RopewayPlayerCameraController* controller) override;
     void on_update_camera_controller2(RopewayPlayerCameraController* controller) override;
 
-    void on_pre_application_entry(void* entry, const char* name, size_t hash) override;
-    void on_application_entry(void* entry, const char* name, size_t hash) override;
+    void on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
+    void on_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
 
     // non-virtual callbacks
     void on_pre_update_behavior(void* entry);
@@ -87,6 +87,12 @@ std::unordered_map<int32_t, MoveDirection> g_vk_to_movedir{
     { DIK_RIGHT, MoveDirection::RIGHT },
 };
 
+std::vector<ModSubscription> FreeCam::get_subscriptions() const {
+    return {
+        {ModCallback::UPDATE_TRANSFORM},
+    };
+}
+
 void FreeCam::on_update_transform(RETransform* transform) {
     if (!m_enabled->value() && !m_first_time) {
         m_was_disabled = false;
@@ -16,6 +16,7 @@ public:
 
     void on_frame() override;
     void on_draw_ui() override;
+    std::vector<ModSubscription> get_subscriptions() const override;
     void on_update_transform(RETransform* transform) override;
 
 private:
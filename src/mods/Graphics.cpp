@@ -38,7 +38,15 @@ void Graphics::on_draw_ui() {
     m_disable_gui->draw("Hide GUI");
 }
 
-void Graphics::on_pre_application_entry(void* entry, const char* name, size_t hash) {
+std::vector<ModSubscription> Graphics::get_subscriptions() const {
+    return {
+        {ModCallback::PRE_GUI_DRAW_ELEMENT},
+        {ModCallback::PRE_APPLICATION_ENTRY, {"UpdateBehavior"_fnv, "UnlockScene"_fnv}},
+        {ModCallback::APPLICATION_ENTRY, {"UpdateBehavior"_fnv, "LockScene"_fnv}},
+    };
+}
+
+void Graphics::on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     // To fix the world-space GUI icons.
     if (hash == "UpdateBehavior"_fnv) {
         do_ultrawide_fix();
@@ -49,7 +57,7 @@ void Graphics::on_pre_application_entry(void* entry, const char* name, size_t ha
     }
 }
 
-void Graphics::on_application_entry(void* entry, const char* name, size_t hash) {
+void Graphics::on_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     if (hash == "UpdateBehavior"_fnv) {
         do_ultrawide_fov_restore();
     }
@@ -11,8 +11,9 @@ public:
 
     void on_draw_ui() override;
 
-    void on_pre_application_entry(void* entry, const char* name, size_t hash) override;
-    void on_application_entry(void* entry, const char* name, size_t hash) override;
+    std::vector<ModSubscription> get_subscriptions() const override;
+    void on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
+    void on_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
 
     bool on_pre_gui_draw_element(REComponent* gui_element, void* primitive_context) override;
 
@@ -5,11 +5,42 @@
 #include "utility/String.hpp"
 
 #include "sdk/Application.hpp"
+#include "sdk/Renderer.hpp"
+#include "sdk/SceneSnapshot.hpp"
 
 #include "Hooks.hpp"
 
 Hooks* g_hook = nullptr;
 
+namespace detail {
+const std::vector<FrameProfiler::ScopeId> no_scopes{};
+
+// Calls fn for each subscriber, timing each one against the matching scope when the profiler is on.
+template <typename F>
+void call_subscribers(const std::vector<Mod*>& subscribers, const std::vector<FrameProfiler::ScopeId>& scopes, F&& fn) {
+#ifndef REF_TRACING
+    if (!g_profiler.is_enabled()) {
+        for (auto mod : subscribers) {
+            fn(mod);
+        }
+
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < subscribers.size(); ++i) {
+        FrameProfiler::Scope _{g_profiler, i < scopes.size() ? scopes[i] : FrameProfiler::INVALID_SCOPE};
+        fn(subscribers[i]);
+    }
+}
+
+template <typename F>
+decltype(auto) call_profiled(FrameProfiler::ScopeId scope, F&& fn) {
+    FrameProfiler::Scope _{g_profiler, scope};
+    return fn();
+}
+}
+
 Hooks::Hooks() {
     g_hook = this;
 }
@@ -39,56 +70,110 @@ std::optional<std::string> Hooks::on_initialize() {
     return Mod::on_initialize();
 }
 
+void Hooks::on_frame() {
+    if (!m_profiler_scopes_ready.load(std::memory_order_acquire)) {
+        resolve_profiler_scopes();
+    }
+
+    g_profiler.on_frame();
+}
+
 void Hooks::on_draw_ui() {
     if (!ImGui::CollapsingHeader("Performance")) {
         return;
     }
 
-    ImGui::Checkbox("Enable Profiling", &m_profiling_enabled);
+    g_profiler.on_draw_ui();
+}
 
-    if (!m_profiling_enabled) {
-        return;
+void Hooks::resolve_profiler_scopes() {
+    static constexpr std::array<const char*, (size_t)ModCallback::COUNT> callback_names{
+        "PreUpdateTransform",
+        "UpdateTransform",
+        "PreUpdateCameraController",
+        "UpdateCameraController",
+        "PreUpdateCameraController2",
+        "UpdateCameraController2",
+        "PreGUIDrawElement",
+        "GUIDrawElement",
+        "PreUpdateBeforeLockScene",
+        "UpdateBeforeLockScene",
+        "PreLightShaftDraw",
+        "LightShaftDraw",
+        "PreApplicationEntry",
+        "ApplicationEntry",
+    };
+
+    auto& mods = g_framework->get_mods();
+
+    auto make_scopes = [](std::string_view group, const std::vector<Mod*>& subscribers) {
+        std::vector<FrameProfiler::ScopeId> scopes{};
+
+        for (auto mod : subscribers) {
+            scopes.push_back(g_profiler.register_scope(group, mod->get_name(), FrameProfiler::ScopeKind::REFRAMEWORK));
+        }
+
+        return scopes;
+    };
+
+    for (size_t i = 0; i < (size_t)ModCallback::COUNT; ++i) {
+        const auto callback = (ModCallback)i;
+
+        if (callback == ModCallback::PRE_APPLICATION_ENTRY || callback == ModCallback::APPLICATION_ENTRY) {
+            continue;
+        }
+
+        m_callback_scopes[i] = make_scopes(callback_names[i], mods->get_subscribers(callback));
+        m_original_scopes[i] = g_profiler.register_scope(callback_names[i], "Game", FrameProfiler::ScopeKind::GAME);
     }
 
-    ImGui::Text("Application Entry Times");
+    for (auto& app_entry : m_application_entries) {
+        const auto pre_name = std::string{"Pre"} + app_entry.name;
 
-    std::vector<const char*> sorted_times{};
-    std::scoped_lock _{m_profiler_mutex};
+        app_entry.pre_scopes = make_scopes(pre_name, mods->get_entry_subscribers(ModCallback::PRE_APPLICATION_ENTRY, app_entry.hash));
+        app_entry.post_scopes = make_scopes(app_entry.name, mods->get_entry_subscribers(ModCallback::APPLICATION_ENTRY, app_entry.hash));
+        app_entry.original_scope = g_profiler.register_scope(app_entry.name, "Game", FrameProfiler::ScopeKind::GAME);
+    }
 
-    std::chrono::high_resolution_clock::duration total_reframework_time{};
-    std::chrono::high_resolution_clock::duration total_game_time{};
+    m_profiler_scopes_ready.store(true, std::memory_order_release);
+}
 
-    for (auto& entry : m_application_entry_times) {
-        sorted_times.emplace_back(entry.first);
-        total_reframework_time += entry.second.reframework_pre_time + entry.second.reframework_post_time;
-        total_game_time += entry.second.callback_time;
+const std::vector<FrameProfiler::ScopeId>& Hooks::get_callback_scopes(ModCallback callback) const {
+    if (!m_profiler_scopes_ready.load(std::memory_order_acquire)) {
+        return detail::no_scopes;
     }
 
-    std::sort(sorted_times.begin(), sorted_times.end(), [&](const char* a, const char* b) {
-        const auto& a_entry = m_application_entry_times[a];
-        const auto& b_entry = m_application_entry_times[b];
+    return m_callback_scopes[(size_t)callback];
+}
 
-        return a_entry.callback_time + a_entry.reframework_pre_time + a_entry.reframework_post_time 
-                > b_entry.callback_time + b_entry.reframework_pre_time + b_entry.reframework_post_time;
-    });
+FrameProfiler::ScopeId Hooks::get_original_scope(ModCallback callback) const {
+    if (!m_profiler_scopes_ready.load(std::memory_order_acquire)) {
+        return FrameProfiler::INVALID_SCOPE;
+    }
 
-    ImGui::Text("Total REFramework Time: %.3fms", std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(total_reframework_time).count());
-    ImGui::Text("Total Game Time: %.3fms", std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(total_game_time).count());
+    return m_original_scopes[(size_t)callback];
+}
 
-    for (auto name : sorted_times) {
-        auto& entry = m_application_entry_times[name];
-        
-        ImGui::SetNextItemOpen(true);
-
-        if (ImGui::TreeNode(name)) {
-            ImGui::Text("Game Time: %s: %.2fms", name, entry.callback_time.count() / 1000000.0f);
-            ImGui::Text("REFramework Pre Time: %.2fms", entry.reframework_pre_time.count() / 1000000.0f);
-            ImGui::Text("REFramework Post Time: %.2fms", entry.reframework_post_time.count() / 1000000.0f);
-            ImGui::Text("Total Time: %.2fms", (entry.callback_time + entry.reframework_pre_time + entry.reframework_post_time).count() / 1000000.0f);
-            
-            ImGui::TreePop();
-        }
+std::optional<size_t> Hooks::get_application_entry_id(std::string_view name) {
+    if (g_hook == nullptr) {
+        return std::nullopt;
+    }
+
+    auto it = g_hook->m_application_entry_ids.find(utility::hash(name));
+
+    if (it == g_hook->m_application_entry_ids.end()) {
+        return std::nullopt;
+    }
+
+    return it->second;
+}
+
+size_t Hooks::get_num_application_entries() {
+    if (g_hook == nullptr) {
+        return 0;
     }
+
+    return g_hook->m_application_entries.size();
 }
 
 std::optional<std::string> Hooks::hook_update_transform() {
@@ -321,30 +406,41 @@ std::optional<std::string> Hooks::hook_all_application_entries() {
         return mov_r9;
     };
 
-    auto generate_jmp_r9 = []() {
-        std::vector<uint8_t> jmp_r8{ 0x41, 0xFF, 0xE1 };
-        return jmp_r8;
+    auto generate_mov_rax = [](uintptr_t target) {
+        std::vector<uint8_t> mov_rax{ 0x48, 0xB8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+        *(uintptr_t*)&mov_rax[2] = target;
+
+        return mov_rax;
+    };
+
+    auto generate_jmp_rax = []() {
+        std::vector<uint8_t> jmp_rax{ 0xFF, 0xE0 };
+        return jmp_rax;
     };
 
     // movabs rdx, entry_name_addr
     // movabs r8, entry_name_hash
-    // movabs r9, hook_addr
-    // jmp r9 (Hooks::global_application_entry_hook)
+    // movabs r9, entry_id
+    // movabs rax, hook_addr
+    // jmp rax (Hooks::global_application_entry_hook)
     // The purpose of this is so we can pass some state to the hook callback
     // So we can know which hook is being called, as a global hook handler
     // gets called for every hook (Hooks::global_application_entry_hook)
-    auto generate_hook_func = [&](const char* name, uintptr_t target) {
+    // The ID is a dense index into m_application_entries, so the handler never has to hash or search.
+    auto generate_hook_func = [&](const char* name, size_t id, uintptr_t target) {
         auto mov_rdx = generate_mov_rdx((uintptr_t)name);
         auto mov_r8 = generate_mov_r8(utility::hash(name));
-        auto mov_r9 = generate_mov_r9(target);
-        auto jmp_r9 = generate_jmp_r9();
+        auto mov_r9 = generate_mov_r9(id);
+        auto mov_rax = generate_mov_rax(target);
+        auto jmp_rax = generate_jmp_rax();
 
         // Concats the above vectors into a single vector.
         std::vector<uint8_t> hook{};
         hook.insert(hook.end(), mov_rdx.begin(), mov_rdx.end());
         hook.insert(hook.end(), mov_r8.begin(), mov_r8.end());
         hook.insert(hook.end(), mov_r9.begin(), mov_r9.end());
-        hook.insert(hook.end(), jmp_r9.begin(), jmp_r9.end());
+        hook.insert(hook.end(), mov_rax.begin(), mov_rax.end());
+        hook.insert(hook.end(), jmp_rax.begin(), jmp_rax.end());
 
         // Allocate some permanent memory for the hook
         // and copy the hook into it. Set the permissions to RWX.
@@ -378,6 +474,8 @@ std::optional<std::string> Hooks::hook_all_application_entries() {
         }
     }*/
 
+    std::vector<sdk::Application::Function*> entries_to_hook{};
+
     for (auto i = 0; i < 1024; ++i) {
         auto entry = application->get_function(i);
 
@@ -396,19 +494,34 @@ std::optional<std::string> Hooks::hook_all_application_entries() {
             continue;
         }*/
 
-        spdlog::info("{} {} entry: {:x}", i, entry->description, (uintptr_t)entry);
+        entries_to_hook.push_back(entry);
+    }
+
+    // Size everything up front so the stubs never see the entry table move.
+    m_application_entries.resize(entries_to_hook.size());
 
-        auto generated_hook = generate_hook_func((const char*)entry->description, (uintptr_t)&global_application_entry_hook);
+    for (size_t id = 0; id < entries_to_hook.size(); ++id) {
+        auto entry = entries_to_hook[id];
+        auto func = entry->func;
+        const auto name = (const char*)entry->description;
+        const auto hash = utility::hash(name);
 
-        //m_application_entry_hooks[entry->description] = std::make_unique<FunctionHook>(func, generated_hook);
+        spdlog::info("{} {} entry: {:x}", id, name, (uintptr_t)entry);
+
+        auto& app_entry = m_application_entries[id];
+        app_entry.name = name;
+        app_entry.hash = hash;
+        app_entry.id = m_application_entry_ids.emplace(hash, id).first->second;
+        app_entry.original = func;
+
+        auto generated_hook = generate_hook_func(name, id, (uintptr_t)&global_application_entry_hook);
         
         // We are just going to replace the pointer to the function for now
         // Doing a full hook with FunctionHook eats up a lot of initialization time because of
         // the constant thread suspension. 
-        m_application_entry_hooks[entry->description] = func;
         entry->func = (void (*)(void*))generated_hook;
 
-        spdlog::info("Hooked {} {:x}->{:x}", entry->description, (uintptr_t)func, (uintptr_t)generated_hook);
+        spdlog::info("Hooked {} {:x}->{:x}", name, (uintptr_t)func, (uintptr_t)generated_hook);
     }
 
     /*for (auto& entry : m_application_entry_hooks) {
@@ -486,17 +599,26 @@ void* Hooks::update_transform_hook_internal(RETransform* t, uint8_t a2, uint32_t
         return m_update_transform_hook->get_original<decltype(update_transform_hook)>()(t, a2, a3);
     }
 
-    auto& mods = g_framework->get_mods()->get_mods();
+    auto& mods = g_framework->get_mods();
+    const auto& pre_subscribers = mods->get_subscribers(ModCallback::PRE_UPDATE_TRANSFORM);
+    const auto& post_subscribers = mods->get_subscribers(ModCallback::UPDATE_TRANSFORM);
 
-    for (auto& mod : mods) {
-        mod->on_pre_update_transform(t);
+    // This gets called for every transform in the scene, so skip straight to the original when nobody's listening.
+    if (pre_subscribers.empty() && post_subscribers.empty()) {
+        return m_update_transform_hook->get_original<decltype(update_transform_hook)>()(t, a2, a3);
     }
 
-    auto ret = m_update_transform_hook->get_original<decltype(update_transform_hook)>()(t, a2, a3);
+    detail::call_subscribers(pre_subscribers, get_callback_scopes(ModCallback::PRE_UPDATE_TRANSFORM), [&](Mod* mod) {
+        mod->on_pre_update_transform(t);
+    });
+
+    auto ret = detail::call_profiled(get_original_scope(ModCallback::UPDATE_TRANSFORM), [&]() {
+        return m_update_transform_hook->get_original<decltype(update_transform_hook)>()(t, a2, a3);
+    });
 
-    for (auto& mod : mods) {
+    detail::call_subscribers(post_subscribers, get_callback_scopes(ModCallback::UPDATE_TRANSFORM), [&](Mod* mod) {
         mod->on_update_transform(t);
-    }
+    });
 
     return ret;
 }
@@ -510,17 +632,25 @@ void* Hooks::update_camera_controller_hook_internal(void* a1, RopewayPlayerCamer
         return m_update_camera_controller_hook->get_original<decltype(update_camera_controller_hook)>()(a1, camera_controller);
     }
 
-    auto& mods = g_framework->get_mods()->get_mods();
+    auto& mods = g_framework->get_mods();
+    const auto& pre_subscribers = mods->get_subscribers(ModCallback::PRE_UPDATE_CAMERA_CONTROLLER);
+    const auto& post_subscribers = mods->get_subscribers(ModCallback::UPDATE_CAMERA_CONTROLLER);
 
-    for (auto& mod : mods) {
-        mod->on_pre_update_camera_controller(camera_controller);
+    if (pre_subscribers.empty() && post_subscribers.empty()) {
+        return m_update_camera_controller_hook->get_original<decltype(update_camera_controller_hook)>()(a1, camera_controller);
     }
 
-    auto ret = m_update_camera_controller_hook->get_original<decltype(update_camera_controller_hook)>()(a1, camera_controller);
+    detail::call_subscribers(pre_subscribers, get_callback_scopes(ModCallback::PRE_UPDATE_CAMERA_CONTROLLER), [&](Mod* mod) {
+        mod->on_pre_update_camera_controller(camera_controller);
+    });
+
+    auto ret = detail::call_profiled(get_original_scope(ModCallback::UPDATE_CAMERA_CONTROLLER), [&]() {
+        return m_update_camera_controller_hook->get_original<decltype(update_camera_controller_hook)>()(a1, camera_controller);
+    });
 
-    for (auto& mod : mods) {
+    detail::call_subscribers(post_subscribers, get_callback_scopes(ModCallback::UPDATE_CAMERA_CONTROLLER), [&](Mod* mod) {
         mod->on_update_camera_controller(camera_controller);
-    }
+    });
 
     return ret;
 }
@@ -534,17 +664,25 @@ void* Hooks::update_camera_controller2_hook_internal(void* a1, RopewayPlayerCame
         return m_update_camera_controller2_hook->get_original<decltype(update_camera_controller2_hook)>()(a1, camera_controller);
     }
 
-    auto& mods = g_framework->get_mods()->get_mods();
+    auto& mods = g_framework->get_mods();
+    const auto& pre_subscribers = mods->get_subscribers(ModCallback::PRE_UPDATE_CAMERA_CONTROLLER2);
+    const auto& post_subscribers = mods->get_subscribers(ModCallback::UPDATE_CAMERA_CONTROLLER2);
 
-    for (auto& mod : mods) {
-        mod->on_pre_update_camera_controller2(camera_controller);
+    if (pre_subscribers.empty() && post_subscribers.empty()) {
+        return m_update_camera_controller2_hook->get_original<decltype(update_camera_controller2_hook)>()(a1, camera_controller);
     }
 
-    auto ret = m_update_camera_controller2_hook->get_original<decltype(update_camera_controller2_hook)>()(a1, camera_controller);
+    detail::call_subscribers(pre_subscribers, get_callback_scopes(ModCallback::PRE_UPDATE_CAMERA_CONTROLLER2), [&](Mod* mod) {
+        mod->on_pre_update_camera_controller2(camera_controller);
+    });
+
+    auto ret = detail::call_profiled(get_original_scope(ModCallback::UPDATE_CAMERA_CONTROLLER2), [&]() {
+        return m_update_camera_controller2_hook->get_original<decltype(update_camera_controller2_hook)>()(a1, camera_controller);
+    });
 
-    for (auto& mod : mods) {
+    detail::call_subscribers(post_subscribers, get_callback_scopes(ModCallback::UPDATE_CAMERA_CONTROLLER2), [&](Mod* mod) {
         mod->on_update_camera_controller2(camera_controller);
-    }
+    });
 
     return ret;
 }
@@ -560,25 +698,33 @@ void* Hooks::gui_draw_hook_internal(REComponent* gui_element, void* primitive_co
         return original_func(gui_element, primitive_context);
     }
 
-    auto& mods = g_framework->get_mods()->get_mods();
+    auto& mods = g_framework->get_mods();
+    const auto& pre_subscribers = mods->get_subscribers(ModCallback::PRE_GUI_DRAW_ELEMENT);
+    const auto& post_subscribers = mods->get_subscribers(ModCallback::GUI_DRAW_ELEMENT);
+
+    if (pre_subscribers.empty() && post_subscribers.empty()) {
+        return original_func(gui_element, primitive_context);
+    }
 
     bool any_false = false;
 
-    for (auto& mod : mods) {
+    detail::call_subscribers(pre_subscribers, get_callback_scopes(ModCallback::PRE_GUI_DRAW_ELEMENT), [&](Mod* mod) {
         if (!mod->on_pre_gui_draw_element(gui_element, primitive_context)) {
             any_false = true;
         }
-    }
+    });
 
     void* ret = nullptr;
 
     if (!any_false) {
-        ret = original_func(gui_element, primitive_context);
+        ret = detail::call_profiled(get_original_scope(ModCallback::GUI_DRAW_ELEMENT), [&]() {
+            return original_func(gui_element, primitive_context);
+        });
     }
 
-    for (auto& mod : mods) {
+    detail::call_subscribers(post_subscribers, get_callback_scopes(ModCallback::GUI_DRAW_ELEMENT), [&](Mod* mod) {
         mod->on_gui_draw_element(gui_element, primitive_context);
-    }
+    });
 
     return ret;
 }
@@ -594,17 +740,21 @@ void Hooks::update_before_lock_scene_hook_internal(void* ctx) {
         return original(ctx);
     }
 
-    auto& mods = g_framework->get_mods()->get_mods();
+    auto& mods = g_framework->get_mods();
+    const auto& pre_subscribers = mods->get_subscribers(ModCallback::PRE_UPDATE_BEFORE_LOCK_SCENE);
+    const auto& post_subscribers = mods->get_subscribers(ModCallback::UPDATE_BEFORE_LOCK_SCENE);
 
-    for (auto& mod : mods) {
+    detail::call_subscribers(pre_subscribers, get_callback_scopes(ModCallback::PRE_UPDATE_BEFORE_LOCK_SCENE), [&](Mod* mod) {
         mod->on_pre_update_before_lock_scene(ctx);
-    }
+    });
 
-    original(ctx);
+    detail::call_profiled(get_original_scope(ModCallback::UPDATE_BEFORE_LOCK_SCENE), [&]() {
+        original(ctx);
+    });
 
-    for (auto& mod : mods) {
+    detail::call_subscribers(post_subscribers, get_callback_scopes(ModCallback::UPDATE_BEFORE_LOCK_SCENE), [&](Mod* mod) {
         mod->on_update_before_lock_scene(ctx);
-    }
+    });
 }
 
 void Hooks::update_before_lock_scene_hook(void* ctx) {
@@ -618,83 +768,81 @@ void Hooks::lightshaft_draw_hook_internal(void* shaft, void* render_context) {
         return original(shaft, render_context);
     }
 
-    auto& mods = g_framework->get_mods()->get_mods();
+    auto& mods = g_framework->get_mods();
+    const auto& pre_subscribers = mods->get_subscribers(ModCallback::PRE_LIGHTSHAFT_DRAW);
+    const auto& post_subscribers = mods->get_subscribers(ModCallback::LIGHTSHAFT_DRAW);
 
-    for (auto& mod : mods) {
+    detail::call_subscribers(pre_subscribers, get_callback_scopes(ModCallback::PRE_LIGHTSHAFT_DRAW), [&](Mod* mod) {
         mod->on_pre_lightshaft_draw(shaft, render_context);
-    }
+    });
 
-    original(shaft, render_context);
+    detail::call_profiled(get_original_scope(ModCallback::LIGHTSHAFT_DRAW), [&]() {
+        original(shaft, render_context);
+    });
 
-    for (auto& mod : mods) {
+    detail::call_subscribers(post_subscribers, get_callback_scopes(ModCallback::LIGHTSHAFT_DRAW), [&](Mod* mod) {
         mod->on_lightshaft_draw(shaft, render_context);
-    }
+    });
 }
 
 void Hooks::lightshaft_draw_hook(void* shaft, void* render_context) {
     g_hook->lightshaft_draw_hook_internal(shaft, render_context);
 }
 
-void Hooks::global_application_entry_hook_internal(void* entry, const char* name, size_t hash) {
+void Hooks::global_application_entry_hook_internal(void* entry, const char* name, size_t hash, size_t id) {
     //spdlog::info("{}", name);
 
-    auto original = m_application_entry_hooks[name];
+    auto& app_entry = m_application_entries[id];
+    auto original = app_entry.original;
 
     if (!g_framework->is_ready()) {
         return original(entry);
     }
 
-    if (m_profiling_enabled) {
-        Hooks::ApplicationEntryData profiler_entry{};
-        
-        auto now = std::chrono::high_resolution_clock::now();
-        auto& mods = g_framework->get_mods()->get_mods();
-
-        if (hash == "BeginRendering"_fnv) {
-            g_framework->run_imgui_frame(false);
-        }
+    // The subscriber lists don't exist until the mods are initialized, so look them up on the first call after that.
+    std::call_once(m_application_entry_subscribers_resolved, [this]() {
+        auto& mods = g_framework->get_mods();
 
-        for (auto& mod : mods) {
-            mod->on_pre_application_entry(entry, name, hash);
+        for (auto& data : m_application_entries) {
+            data.pre_subscribers = &mods->get_entry_subscribers(ModCallback::PRE_APPLICATION_ENTRY, data.hash);
+            data.post_subscribers = &mods->get_entry_subscribers(ModCallback::APPLICATION_ENTRY, data.hash);
         }
+    });
 
-        profiler_entry.reframework_pre_time = std::chrono::high_resolution_clock::now() - now;
-
-        now = std::chrono::high_resolution_clock::now();
-        
-        original(entry);
-
-        profiler_entry.callback_time = std::chrono::high_resolution_clock::now() - now;
-
-        now = std::chrono::high_resolution_clock::now();
+    const auto& pre_subscribers = *app_entry.pre_subscribers;
+    const auto& post_subscribers = *app_entry.post_subscribers;
+    const auto name_id = app_entry.id;
+    const auto scopes_ready = m_profiler_scopes_ready.load(std::memory_order_acquire);
+    const auto& pre_scopes = scopes_ready ? app_entry.pre_scopes : detail::no_scopes;
+    const auto& post_scopes = scopes_ready ? app_entry.post_scopes : detail::no_scopes;
 
-        for (auto& mod : mods) {
-            mod->on_application_entry(entry, name, hash);
-        }
+    // Objects can be destroyed between present and here, and scripts hooked on UpdateBehavior are the first
+    // to see the new game tick, so the scene is walked again for them.
+    if (hash == "UpdateBehavior"_fnv) {
+        sdk::invalidate_scene_snapshot();
+    }
 
-        profiler_entry.reframework_post_time = std::chrono::high_resolution_clock::now() - now;
-        
-        std::scoped_lock _{m_profiler_mutex};
-        m_application_entry_times[name] = profiler_entry;
-    } else {
-        if (hash == "BeginRendering"_fnv) {
-            g_framework->run_imgui_frame(false);
-        }
+    if (hash == "BeginRendering"_fnv) {
+        g_framework->run_imgui_frame(false);
+    }
 
-        auto& mods = g_framework->get_mods()->get_mods();
+    detail::call_subscribers(pre_subscribers, pre_scopes, [&](Mod* mod) {
+        mod->on_pre_application_entry(entry, name, hash, name_id);
+    });
 
-        for (auto& mod : mods) {
-            mod->on_pre_application_entry(entry, name, hash);
-        }
-        
+    detail::call_profiled(scopes_ready ? app_entry.original_scope : FrameProfiler::INVALID_SCOPE, [&]() {
         original(entry);
+    });
 
-        for (auto& mod : mods) {
-            mod->on_application_entry(entry, name, hash);
-        }
-    }
+    // Any entry can move the camera or switch to another one. Whoever projects next reads it again;
+    // until then this is just a flag.
+    sdk::renderer::invalidate_camera_snapshot();
+
+    detail::call_subscribers(post_subscribers, post_scopes, [&](Mod* mod) {
+        mod->on_application_entry(entry, name, hash, name_id);
+    });
 }
 
-void Hooks::global_application_entry_hook(void* entry, const char* name, size_t hash) {
-    g_hook->global_application_entry_hook_internal(entry, name, hash);
+void Hooks::global_application_entry_hook(void* entry, const char* name, size_t hash, size_t id) {
+    g_hook->global_application_entry_hook_internal(entry, name, hash, id);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Mod.hpp"
+#include "FrameProfiler.hpp"
 #include "utility/FunctionHook.hpp"
 
 class Hooks : public Mod {
@@ -9,11 +10,13 @@ public:
 
     std::string_view get_name() const override { return "PositionHooks"; };
     std::optional<std::string> on_initialize() override;
+    void on_frame() override;
     void on_draw_ui() override;
 
-    auto& get_application_entry_times() {
-        return m_application_entry_times;
-    }
+    // Dense IDs assigned to each via.Application entry when it gets hooked.
+    // Anything that dispatches per-entry can index a plain array with these instead of hashing the name.
+    static std::optional<size_t> get_application_entry_id(std::string_view name);
+    static size_t get_num_application_entries();
 
 protected:
     void* update_transform_hook_internal(RETransform* t, uint8_t a2, uint32_t a3);
@@ -46,8 +49,8 @@ protected:
     void lightshaft_draw_hook_internal(void* shaft, void* render_context);
     static void lightshaft_draw_hook(void* shaft, void* render_context);
     
-    void global_application_entry_hook_internal(void* entry, const char* name, size_t hash);
-    static void global_application_entry_hook(void* entry, const char* name, size_t hash);
+    void global_application_entry_hook_internal(void* entry, const char* name, size_t hash, size_t id);
+    static void global_application_entry_hook(void* entry, const char* name, size_t hash, size_t id);
 
 private:
     std::optional<std::string> hook_update_transform();
@@ -61,6 +64,10 @@ private:
     std::optional<std::string> hook_application_entry(std::string name, std::unique_ptr<FunctionHook>& hook, void (*hook_fn)(void*));
     std::optional<std::string> hook_all_application_entries();
 
+    void resolve_profiler_scopes();
+    const std::vector<FrameProfiler::ScopeId>& get_callback_scopes(ModCallback callback) const;
+    FrameProfiler::ScopeId get_original_scope(ModCallback callback) const; // indexed by the post callback
+
     #define HOOK_LAMBDA(func) [&]() -> std::optional<std::string> { return this->func(); }
 
     std::vector<std::function<std::optional<std::string>()>> m_hook_list{
@@ -85,16 +92,28 @@ protected:
     std::unique_ptr<FunctionHook> m_update_before_lock_scene_hook;
     std::unique_ptr<FunctionHook> m_lightshaft_draw_hook;
 
-    std::unordered_map<const char*, void (*)(void*)> m_application_entry_hooks;
-
-    struct ApplicationEntryData {
-        std::chrono::nanoseconds callback_time;
-        std::chrono::nanoseconds reframework_pre_time;
-        std::chrono::nanoseconds reframework_post_time;
+    struct ApplicationEntry {
+        const char* name{};
+        size_t hash{};
+        size_t id{}; // Same as the slot unless the name was already taken by an earlier entry
+        void (*original)(void*){};
+        const std::vector<Mod*>* pre_subscribers{};
+        const std::vector<Mod*>* post_subscribers{};
+
+        // Parallel to the subscriber lists, filled in by resolve_profiler_scopes.
+        FrameProfiler::ScopeId original_scope{FrameProfiler::INVALID_SCOPE};
+        std::vector<FrameProfiler::ScopeId> pre_scopes{};
+        std::vector<FrameProfiler::ScopeId> post_scopes{};
     };
 
-    bool m_profiling_enabled{false};
+    // Indexed by the ID baked into each entry's stub. Only written during hook_all_application_entries.
+    std::vector<ApplicationEntry> m_application_entries{};
+    std::unordered_map<size_t, size_t> m_application_entry_ids{};
+    std::once_flag m_application_entry_subscribers_resolved{};
 
-    std::recursive_mutex m_profiler_mutex{};
-    std::unordered_map<const char*, ApplicationEntryData> m_application_entry_times;
+    // Parallel to Mods::get_subscribers for each callback, plus one scope per hook for the hooked function itself.
+    // Built once on the first frame; the hooks only read them after m_profiler_scopes_ready is set.
+    std::array<std::vector<FrameProfiler::ScopeId>, (size_t)ModCallback::COUNT> m_callback_scopes{};
+    std::array<FrameProfiler::ScopeId, (size_t)ModCallback::COUNT> m_original_scopes{};
+    std::atomic<bool> m_profiler_scopes_ready{false};
 };
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "LuaAllocator.hpp"
+
+LuaAllocator::~LuaAllocator() {
+    for (const auto& slab : m_slabs) {
+        std::free(slab.base);
+    }
+}
+
+void* LuaAllocator::alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+    auto allocator = (LuaAllocator*)ud;
+
+    if (ptr == nullptr) {
+        // osize is a type tag rather than a size here.
+        return nsize != 0 ? allocator->allocate(nsize) : nullptr;
+    }
+
+    if (nsize == 0) {
+        allocator->deallocate(ptr, osize);
+        return nullptr;
+    }
+
+    return allocator->reallocate(ptr, osize, nsize);
+}
+
+LuaAllocator::Stats LuaAllocator::get_stats() const {
+    Stats stats{};
+
+    stats.live_bytes = m_live_bytes.load(std::memory_order_relaxed);
+    stats.peak_bytes = m_peak_bytes.load(std::memory_order_relaxed);
+    stats.live_blocks = m_live_blocks.load(std::memory_order_relaxed);
+    stats.small_bytes = m_small_bytes.load(std::memory_order_relaxed);
+    stats.large_bytes = stats.live_bytes - std::min(stats.small_bytes, stats.live_bytes);
+    stats.slab_bytes = m_slab_bytes.load(std::memory_order_relaxed);
+    stats.allocations = m_allocations.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+void LuaAllocator::reset_peak() {
+    m_peak_bytes.store(m_live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+size_t LuaAllocator::trim() {
+    if (m_slabs.empty()) {
+        return 0;
+    }
+
+    std::sort(m_slabs.begin(), m_slabs.end(), [](const Slab& a, const Slab& b) { return a.base < b.base; });
+
+    const auto slab_of = [this](const FreeBlock* block) {
+        auto it = std::upper_bound(m_slabs.begin(), m_slabs.end(), (const uint8_t*)block, [](const uint8_t* p, const Slab& slab) {
+            return p < slab.base;
+        });
+
+        return (size_t)(it - m_slabs.begin()) - 1;
+    };
+
+    std::vector<size_t> free_blocks(m_slabs.size());
+
+    for (auto head : m_free) {
+        for (auto block = head; block != nullptr; block = block->next) {
+            ++free_blocks[slab_of(block)];
+        }
+    }
+
+    std::vector<bool> empty(m_slabs.size());
+    size_t num_empty{};
+
+    for (size_t i = 0; i < m_slabs.size(); ++i) {
+        if (free_blocks[i] == SLAB_SIZE / block_size_of(m_slabs[i].cls)) {
+            empty[i] = true;
+            ++num_empty;
+        }
+    }
+
+    if (num_empty == 0) {
+        return 0;
+    }
+
+    // Unlink the empty slabs' blocks, leaving the rest of each list in order.
+    for (auto& head : m_free) {
+        for (auto link = &head; *link != nullptr;) {
+            if (empty[slab_of(*link)]) {
+                *link = (*link)->next;
+            } else {
+                link = &(*link)->next;
+            }
+        }
+    }
+
+    size_t kept{};
+
+    for (size_t i = 0; i < m_slabs.size(); ++i) {
+        if (empty[i]) {
+            std::free(m_slabs[i].base);
+        } else {
+            m_slabs[kept++] = m_slabs[i];
+        }
+    }
+
+    m_slabs.resize(kept);
+
+    const auto freed = num_empty * SLAB_SIZE;
+    add(m_slab_bytes, -(ptrdiff_t)freed);
+
+    return freed;
+}
+
+void LuaAllocator::maybe_trim() {
+    const auto free_bytes = m_slabs.size() * SLAB_SIZE - m_pooled_bytes;
+
+    if (free_bytes < m_trim_threshold) {
+        return;
+    }
+
+    m_trim_threshold = trim() > 0 ? MIN_TRIM_BYTES : free_bytes + MIN_TRIM_BYTES;
+}
+
+void* LuaAllocator::allocate(size_t size) {
+    void* result = size <= MAX_SMALL_SIZE ? allocate_small(class_of(size)) : std::malloc(size);
+
+    if (result != nullptr) {
+        on_allocated(size);
+    }
+
+    return result;
+}
+
+void LuaAllocator::deallocate(void* ptr, size_t size) {
+    if (size <= MAX_SMALL_SIZE) {
+        auto& head = m_free[class_of(size)];
+        auto block = (FreeBlock*)ptr;
+
+        block->next = head;
+        head = block;
+    } else {
+        std::free(ptr);
+    }
+
+    on_freed(size);
+}
+
+void* LuaAllocator::reallocate(void* ptr, size_t osize, size_t nsize) {
+    const auto old_small = osize <= MAX_SMALL_SIZE;
+    const auto new_small = nsize <= MAX_SMALL_SIZE;
+
+    // Same size class; the block already fits.
+    if (old_small && new_small && class_of(osize) == class_of(nsize)) {
+        on_freed(osize);
+        on_allocated(nsize);
+        return ptr;
+    }
+
+    if (!old_small && !new_small) {
+        auto result = std::realloc(ptr, nsize);
+
+        // Lua keeps the old block when a reallocation fails.
+        if (result != nullptr) {
+            on_freed(osize);
+            on_allocated(nsize);
+        }
+
+        return result;
+    }
+
+    auto result = allocate(nsize);
+
+    if (result == nullptr) {
+        return nullptr;
+    }
+
+    std::memcpy(result, ptr, std::min(osize, nsize));
+    deallocate(ptr, osize);
+
+    return result;
+}
+
+void* LuaAllocator::allocate_small(size_t cls) {
+    if (m_free[cls] == nullptr) {
+        refill(cls);
+
+        if (m_free[cls] == nullptr) {
+            return nullptr;
+        }
+    }
+
+    auto block = m_free[cls];
+    m_free[cls] = block->next;
+
+    return block;
+}
+
+void LuaAllocator::refill(size_t cls) {
+    auto slab = (uint8_t*)std::malloc(SLAB_SIZE);
+
+    if (slab == nullptr) {
+        return;
+    }
+
+    m_slabs.push_back(Slab{slab, cls});
+    add(m_slab_bytes, SLAB_SIZE);
+
+    // Thread the slab onto the free list front to back so consecutive allocations are adjacent in memory.
+    const auto block_size = block_size_of(cls);
+    const auto num_blocks = SLAB_SIZE / block_size;
+
+    for (size_t i = num_blocks; i > 0; --i) {
+        auto block = (FreeBlock*)(slab + (i - 1) * block_size);
+
+        block->next = m_free[cls];
+        m_free[cls] = block;
+    }
+}
+
+void LuaAllocator::on_allocated(size_t size) {
+    add(m_live_bytes, size);
+    add(m_live_blocks, 1);
+    m_allocations.store(m_allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (size <= MAX_SMALL_SIZE) {
+        add(m_small_bytes, size);
+        m_pooled_bytes += block_size_of(class_of(size));
+    }
+
+    if (const auto live = m_live_bytes.load(std::memory_order_relaxed); live > m_peak_bytes.load(std::memory_order_relaxed)) {
+        m_peak_bytes.store(live, std::memory_order_relaxed);
+    }
+}
+
+void LuaAllocator::on_freed(size_t size) {
+    add(m_live_bytes, -(ptrdiff_t)size);
+    add(m_live_blocks, -1);
+
+    if (size <= MAX_SMALL_SIZE) {
+        add(m_small_bytes, -(ptrdiff_t)size);
+        m_pooled_bytes -= block_size_of(class_of(size));
+    }
+}
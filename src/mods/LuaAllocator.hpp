@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// lua_Alloc for a single Lua state.
+//
+// Blocks up to MAX_SMALL_SIZE come from size-class free lists carved out of 64KB slabs. Tables, strings,
+// closures and userdata are almost all that small, so scripts that churn through them every frame
+// stop hitting the process heap (which the game also contends on). Bigger blocks go straight to realloc/free.
+// Slabs whose blocks have all come free are handed back by trim, which ScriptState calls after the GC runs.
+//
+// Lua only calls the allocator from whichever thread currently runs the state, and ScriptState serializes those
+// through its execution mutex, so the pools are owned by the state and need no locking of their own.
+class LuaAllocator {
+public:
+    static constexpr size_t GRANULARITY = 16;
+    static constexpr size_t MAX_SMALL_SIZE = 256;
+    static constexpr size_t NUM_CLASSES = MAX_SMALL_SIZE / GRANULARITY;
+    static constexpr size_t SLAB_SIZE = 64 * 1024;
+    static constexpr size_t MIN_TRIM_BYTES = 4 * SLAB_SIZE;
+
+    struct Stats {
+        size_t live_bytes{};
+        size_t peak_bytes{};
+        size_t live_blocks{};
+        size_t small_bytes{};
+        size_t large_bytes{};
+        size_t slab_bytes{}; // reserved for small blocks, used or not
+        uint64_t allocations{};
+    };
+
+    LuaAllocator() = default;
+    ~LuaAllocator();
+
+    LuaAllocator(const LuaAllocator&) = delete;
+    LuaAllocator& operator=(const LuaAllocator&) = delete;
+
+    // Pass this to lua_newstate / sol::state with the allocator as the userdata.
+    static void* alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+    // Safe to call from any thread; the numbers may lag slightly behind the Lua thread.
+    Stats get_stats() const;
+    void reset_peak();
+
+    // Frees every slab with no live blocks and returns how many bytes that gave back.
+    // Walks all the free lists, so only call it from the Lua thread, and not on every allocation.
+    size_t trim();
+
+    // Calls trim once at least MIN_TRIM_BYTES of the slabs are free. If that can't return anything
+    // (the free blocks are spread over slabs that are still in use), it waits for another MIN_TRIM_BYTES.
+    void maybe_trim();
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Slab {
+        uint8_t* base{};
+        size_t cls{};
+    };
+
+    static size_t class_of(size_t size) {
+        return (size + GRANULARITY - 1) / GRANULARITY - 1;
+    }
+
+    static size_t block_size_of(size_t cls) {
+        return (cls + 1) * GRANULARITY;
+    }
+
+    void* allocate(size_t size);
+    void deallocate(void* ptr, size_t size);
+    void* reallocate(void* ptr, size_t osize, size_t nsize);
+
+    void* allocate_small(size_t cls);
+    void refill(size_t cls);
+
+    // Only the Lua thread writes, so a plain load/store pair is enough; readers load relaxed.
+    static void add(std::atomic<size_t>& counter, ptrdiff_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    void on_allocated(size_t size);
+    void on_freed(size_t size);
+
+    std::array<FreeBlock*, NUM_CLASSES> m_free{};
+    std::vector<Slab> m_slabs{};
+
+    // Lua thread only. Small blocks in use, rounded up to their size class, so the slabs' free space is exact.
+    size_t m_pooled_bytes{};
+    size_t m_trim_threshold{MIN_TRIM_BYTES};
+
+    std::atomic<size_t> m_live_bytes{};
+    std::atomic<size_t> m_peak_bytes{};
+    std::atomic<size_t> m_live_blocks{};
+    std::atomic<size_t> m_small_bytes{};
+    std::atomic<size_t> m_slab_bytes{};
+    std::atomic<uint64_t> m_allocations{};
+};
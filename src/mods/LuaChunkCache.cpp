@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <spdlog/spdlog.h>
+
+#include "utility/String.hpp"
+
+#include "LuaChunkCache.hpp"
+
+int LuaChunkCache::load(lua_State* l, const std::string& path, std::string_view source) {
+    const auto chunk_name = get_chunk_name(path);
+
+    // Already bytecode; nothing to cache.
+    if (source.starts_with(LUA_SIGNATURE)) {
+        return luaL_loadbufferx(l, source.data(), source.size(), chunk_name.c_str(), "b");
+    }
+
+    const auto key = make_key(source);
+
+    {
+        std::scoped_lock _{m_mtx};
+
+        if (auto it = m_entries.find(path); it != m_entries.end() && it->second.key == key) {
+            const auto& bytecode = it->second.bytecode;
+
+            if (luaL_loadbufferx(l, bytecode.data(), bytecode.size(), chunk_name.c_str(), "b") == LUA_OK) {
+                ++m_hits;
+                return LUA_OK;
+            }
+
+            // Shouldn't happen, but a bad entry is no reason to fail the script.
+            spdlog::warn("[LuaChunkCache] Failed to load cached bytecode for {}: {}", path, lua_tostring(l, -1));
+            lua_pop(l, 1);
+            m_entries.erase(it);
+        }
+
+        ++m_misses;
+    }
+
+    const auto status = luaL_loadbufferx(l, source.data(), source.size(), chunk_name.c_str(), "t");
+
+    if (status == LUA_OK) {
+        if (auto bytecode = dump(l)) {
+            store(path, key, std::move(*bytecode));
+        }
+    }
+
+    return status;
+}
+
+bool LuaChunkCache::precompile(const std::string& path) {
+    const auto source = read_file(path);
+
+    if (!source) {
+        return false;
+    }
+
+    if (source->starts_with(LUA_SIGNATURE)) {
+        return false;
+    }
+
+    const auto key = make_key(*source);
+
+    {
+        std::scoped_lock _{m_mtx};
+
+        if (auto it = m_entries.find(path); it != m_entries.end() && it->second.key == key) {
+            return true;
+        }
+    }
+
+    auto l = luaL_newstate();
+
+    if (l == nullptr) {
+        return false;
+    }
+
+    bool result = false;
+
+    if (luaL_loadbufferx(l, source->data(), source->size(), get_chunk_name(path).c_str(), "t") == LUA_OK) {
+        if (auto bytecode = dump(l)) {
+            store(path, key, std::move(*bytecode));
+            result = true;
+        }
+    } else {
+        // The error is reported properly when the script actually runs.
+        spdlog::info("[LuaChunkCache] Skipping {}: {}", path, lua_tostring(l, -1));
+    }
+
+    lua_close(l);
+    return result;
+}
+
+void LuaChunkCache::clear() {
+    std::scoped_lock _{m_mtx};
+
+    m_entries.clear();
+    m_hits = 0;
+    m_misses = 0;
+}
+
+LuaChunkCache::Stats LuaChunkCache::get_stats() {
+    std::scoped_lock _{m_mtx};
+
+    Stats stats{};
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.entries = m_entries.size();
+
+    for (const auto& [path, entry] : m_entries) {
+        stats.bytes += entry.bytecode.size();
+    }
+
+    return stats;
+}
+
+std::optional<std::string> LuaChunkCache::read_file(const std::string& path) {
+    std::ifstream file{path, std::ios::binary};
+
+    if (!file) {
+        return std::nullopt;
+    }
+
+    std::stringstream ss{};
+    ss << file.rdbuf();
+
+    auto source = ss.str();
+
+    // Same as luaL_loadfile: skip a UTF-8 BOM and a leading "#!" line, keeping the newline so line numbers match.
+    if (source.starts_with("\xEF\xBB\xBF")) {
+        source.erase(0, 3);
+    }
+
+    if (source.starts_with('#')) {
+        source.erase(0, std::min(source.find('\n'), source.size()));
+    }
+
+    return source;
+}
+
+size_t LuaChunkCache::make_key(std::string_view source) {
+    // Bytecode is only valid for the exact Lua version (and build) that produced it.
+    constexpr auto version = utility::hash(LUA_RELEASE);
+
+    return utility::hash(source) ^ (version + source.size() * 0x9e3779b97f4a7c15);
+}
+
+std::optional<std::string> LuaChunkCache::dump(lua_State* l) {
+    std::string bytecode{};
+
+    const auto writer = [](lua_State*, const void* p, size_t sz, void* ud) -> int {
+        ((std::string*)ud)->append((const char*)p, sz);
+        return 0;
+    };
+
+    if (lua_dump(l, writer, &bytecode, 0) != 0 || bytecode.empty()) {
+        return std::nullopt;
+    }
+
+    return bytecode;
+}
+
+void LuaChunkCache::store(const std::string& path, size_t key, std::string bytecode) {
+    std::scoped_lock _{m_mtx};
+
+    auto& entry = m_entries[path];
+    entry.key = key;
+    entry.bytecode = std::move(bytecode);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <sol/sol.hpp>
+
+// Compiled bytecode for the scripts ScriptRunner loads, so resetting scripts doesn't re-parse every one of them.
+//
+// Entries are keyed by path and checked against a hash of the source and the Lua version,
+// so an edited script simply misses and gets recompiled. Bytecode keeps its debug info;
+// error messages and the profiler still see the original file and line numbers.
+class LuaChunkCache {
+public:
+    struct Stats {
+        uint64_t hits{};
+        uint64_t misses{};
+        size_t entries{};
+        size_t bytes{};
+    };
+
+    // Loads the chunk for path onto the stack like luaL_loadbuffer does, from the cache when the source matches
+    // and by compiling (and caching) it otherwise. Returns the luaL_loadbuffer status.
+    int load(lua_State* l, const std::string& path, std::string_view source);
+
+    // Compiles a script into the cache in a throwaway state. Safe to call from any thread.
+    bool precompile(const std::string& path);
+
+    void clear();
+    Stats get_stats();
+
+    static std::optional<std::string> read_file(const std::string& path);
+
+private:
+    struct Entry {
+        size_t key{};
+        std::string bytecode{};
+    };
+
+    static size_t make_key(std::string_view source);
+    static std::string get_chunk_name(const std::string& path) { return "@" + path; }
+
+    // Dumps the function on top of the stack, leaving it there.
+    static std::optional<std::string> dump(lua_State* l);
+
+    void store(const std::string& path, size_t key, std::string bytecode);
+
+    std::mutex m_mtx{};
+    std::unordered_map<std::string, Entry> m_entries{};
+    uint64_t m_hits{};
+    uint64_t m_misses{};
+};
@@ -0,0 +1,142 @@
+#include <algorithm>
+
+#include "LuaTaskScheduler.hpp"
+
+LuaTaskScheduler::LuaTaskScheduler(lua_State* l)
+    : m_lua{l}
+{
+}
+
+LuaTaskScheduler::~LuaTaskScheduler() {
+    clear();
+}
+
+void LuaTaskScheduler::open(int table_index) {
+    table_index = lua_absindex(m_lua, table_index);
+
+    lua_pushlightuserdata(m_lua, this);
+    lua_pushcclosure(m_lua, &LuaTaskScheduler::spawn_fn, 1);
+    lua_setfield(m_lua, table_index, "spawn");
+
+    lua_pushcfunction(m_lua, &LuaTaskScheduler::yield_fn);
+    lua_setfield(m_lua, table_index, "yield");
+
+    lua_pushcfunction(m_lua, &LuaTaskScheduler::wait_frames_fn);
+    lua_setfield(m_lua, table_index, "wait_frames");
+}
+
+void LuaTaskScheduler::spawn(lua_State* l, int fn_index) {
+    fn_index = lua_absindex(l, fn_index);
+
+    // Threads share the registry, so it doesn't matter which thread (main or task) creates the new one.
+    Task task{};
+    task.thread = lua_newthread(l);
+    task.ref = luaL_ref(l, LUA_REGISTRYINDEX);
+
+    // The function waits on the new thread's stack until the first resume.
+    lua_pushvalue(l, fn_index);
+    lua_xmove(l, task.thread, 1);
+
+    task.wake_frame = m_frame + 1;
+    m_tasks.push_back(task);
+}
+
+void LuaTaskScheduler::run_frame(std::chrono::microseconds budget, const ErrorFn& on_error) {
+    ++m_frame;
+
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    m_stats.resumed = 0;
+    m_stats.deferred = 0;
+
+    // Tasks spawned by other tasks this frame go to the back and wait for the next one.
+    const auto num_tasks = m_tasks.size();
+
+    for (size_t i = 0; i < num_tasks; ++i) {
+        auto task = m_tasks.front();
+        m_tasks.pop_front();
+
+        if (task.wake_frame > m_frame) {
+            m_tasks.push_back(task);
+            continue;
+        }
+
+        // At least one task always runs, or a budget smaller than any task would starve them all.
+        if (m_stats.resumed > 0 && std::chrono::high_resolution_clock::now() - start >= budget) {
+            // The ones that haven't had a turn are still at the front, so they go first next frame.
+            m_tasks.push_front(task);
+
+            m_stats.deferred = num_tasks - i;
+            break;
+        }
+
+        int num_results = 0;
+        const auto status = lua_resume(task.thread, m_lua, 0, &num_results);
+        ++m_stats.resumed;
+
+        if (status == LUA_YIELD) {
+            // wait_frames passes the frame count along; a plain yield passes nothing.
+            uint64_t frames = 1;
+
+            if (num_results > 0 && lua_isinteger(task.thread, -num_results)) {
+                frames = (uint64_t)std::max<lua_Integer>(lua_tointeger(task.thread, -num_results), 1);
+            }
+
+            lua_pop(task.thread, num_results);
+            task.wake_frame = m_frame + frames;
+            m_tasks.push_back(task);
+            continue;
+        }
+
+        if (status != LUA_OK) {
+            luaL_traceback(m_lua, task.thread, lua_tostring(task.thread, -1), 0);
+            on_error(lua_tostring(m_lua, -1));
+            lua_pop(m_lua, 1);
+        }
+
+        release(task);
+    }
+
+    m_stats.tasks = m_tasks.size();
+    m_stats.time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+}
+
+void LuaTaskScheduler::clear() {
+    for (auto& task : m_tasks) {
+        release(task);
+    }
+
+    m_tasks.clear();
+    m_stats = {};
+}
+
+int LuaTaskScheduler::spawn_fn(lua_State* l) {
+    luaL_checktype(l, 1, LUA_TFUNCTION);
+
+    auto scheduler = (LuaTaskScheduler*)lua_touserdata(l, lua_upvalueindex(1));
+    scheduler->spawn(l, 1);
+
+    return 0;
+}
+
+int LuaTaskScheduler::yield_fn(lua_State* l) {
+    return lua_yield(l, 0);
+}
+
+int LuaTaskScheduler::wait_frames_fn(lua_State* l) {
+    const auto frames = luaL_checkinteger(l, 1);
+
+    lua_settop(l, 0);
+    lua_pushinteger(l, frames);
+
+    return lua_yield(l, 1);
+}
+
+void LuaTaskScheduler::release(Task& task) {
+    if (task.ref != LUA_NOREF) {
+        luaL_unref(m_lua, LUA_REGISTRYINDEX, task.ref);
+        task.ref = LUA_NOREF;
+    }
+
+    task.thread = nullptr;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+
+#include <sol/sol.hpp>
+
+// Runs script tasks (coroutines) a little at a time, so heavy work can be spread over several frames.
+//
+// re.spawn(fn)         starts fn as a task; it first runs on the next run_frame
+// re.yield()           gives up the rest of this frame
+// re.wait_frames(n)    sleeps for n frames
+//
+// run_frame resumes each task at most once, round robin, and stops starting new resumes once the budget is spent.
+// Tasks that didn't get a turn go first on the next frame. Only plain Lua API is used here, nothing from the game.
+class LuaTaskScheduler {
+public:
+    using ErrorFn = std::function<void(const std::string&)>;
+
+    struct Stats {
+        size_t tasks{};
+        size_t resumed{};  // last frame
+        size_t deferred{}; // last frame, ran out of budget before their turn
+        std::chrono::microseconds time{}; // last frame
+    };
+
+    LuaTaskScheduler(lua_State* l);
+    ~LuaTaskScheduler();
+
+    LuaTaskScheduler(const LuaTaskScheduler&) = delete;
+    LuaTaskScheduler& operator=(const LuaTaskScheduler&) = delete;
+
+    // Adds spawn, yield and wait_frames to the table at table_index.
+    void open(int table_index);
+
+    // Spawns the function at fn_index on l's stack as a task. l is the main state or one of its threads.
+    void spawn(lua_State* l, int fn_index);
+
+    void run_frame(std::chrono::microseconds budget, const ErrorFn& on_error);
+    void clear();
+
+    const Stats& get_stats() const {
+        return m_stats;
+    }
+
+private:
+    struct Task {
+        lua_State* thread{};
+        int ref{LUA_NOREF}; // keeps the thread alive
+        uint64_t wake_frame{};
+    };
+
+    static int spawn_fn(lua_State* l);
+    static int yield_fn(lua_State* l);
+    static int wait_frames_fn(lua_State* l);
+
+    void release(Task& task);
+
+    lua_State* m_lua{};
+    std::deque<Task> m_tasks{};
+    uint64_t m_frame{};
+    Stats m_stats{};
+};
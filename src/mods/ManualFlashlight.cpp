@@ -52,6 +52,12 @@ void ManualFlashlight::on_config_save(utility::Config& cfg) {
     }
 }
 
+std::vector<ModSubscription> ManualFlashlight::get_subscriptions() const {
+    return {
+        {ModCallback::UPDATE_TRANSFORM},
+    };
+}
+
 void ManualFlashlight::on_update_transform(RETransform* transform) {
     if (!m_enabled->value()) {
         return;
@@ -35,6 +35,7 @@ public:
     void on_config_load(const utility::Config& cfg) override;
     void on_config_save(utility::Config& cfg) override;
 
+    std::vector<ModSubscription> get_subscriptions() const override;
     void on_update_transform(RETransform* transform) override;
 
 private:
@@ -10,6 +10,9 @@
 
 #include "sdk/ResourceManager.hpp"
 #include "sdk/Memory.hpp"
+#include "sdk/RETypeDB.hpp"
+#include "sdk/Renderer.hpp"
+#include "sdk/SceneSnapshot.hpp"
 
 #include "APIProxy.hpp"
 #include "ScriptRunner.hpp"
@@ -161,24 +164,70 @@ REFrameworkSDKFunctions g_sdk_functions {
         return (REFrameworkManagedObjectHandle)sdk::VM::create_managed_string(utility::widen(str));
     },
     [](REFrameworkMethodHandle fn, REFPreHookFn pre_fn, REFPostHookFn post_fn, bool ignore_jmp) -> unsigned int {
-        return g_hookman.add((sdk::REMethodDefinition*)fn, [pre_fn](auto& args, auto& arg_tys) {
-                if (pre_fn != nullptr) {
-                    return (HookManager::PreHookResult)pre_fn((int)args.size(),
-                        (void**)args.data(), (REFrameworkTypeDefinitionHandle*)arg_tys.data());
-                } else {
-                    return (HookManager::PreHookResult)REFRAMEWORK_HOOK_CALL_ORIGINAL;
-                }
-            },
-            [post_fn](auto& ret_val, auto* ret_ty) {
-                if (post_fn != nullptr) {
-                    post_fn((void**)&ret_val, (REFrameworkTypeDefinitionHandle)ret_ty);
-                }
-            },
+        // The plugin's callbacks are passed through as the user data, so a lone plugin hook
+        // gets called straight from the facilitator without going through any std::function.
+        return g_hookman.add_raw((sdk::REMethodDefinition*)fn, 
+            pre_fn != nullptr ? +[](void* pre_fn, uintptr_t* args, size_t num_args, sdk::RETypeDefinition** arg_tys) {
+                return (HookManager::PreHookResult)((REFPreHookFn)pre_fn)((int)num_args, 
+                    (void**)args, (REFrameworkTypeDefinitionHandle*)arg_tys);
+            } : nullptr,
+            (void*)pre_fn,
+            post_fn != nullptr ? +[](void* post_fn, uintptr_t* ret_val, sdk::RETypeDefinition* ret_ty) {
+                ((REFPostHookFn)post_fn)((void**)ret_val, (REFrameworkTypeDefinitionHandle)ret_ty);
+            } : nullptr,
+            (void*)post_fn,
             ignore_jmp);
     },
     [](REFrameworkMethodHandle fn, unsigned int id) { g_hookman.remove((sdk::REMethodDefinition*)fn, (HookManager::HookId)id); },
     &sdk::via::memory::allocate,
-    &sdk::via::memory::deallocate
+    &sdk::via::memory::deallocate,
+    [](const float* world_pos, unsigned int count, float* out, bool* visible) -> REFrameworkResult {
+        const auto camera = sdk::renderer::get_camera_snapshot();
+
+        if (!camera) {
+            return REFRAMEWORK_ERROR_UNKNOWN;
+        }
+
+        static_assert(sizeof(Vector3f) == sizeof(float) * 3 && sizeof(Vector2f) == sizeof(float) * 2);
+        sdk::renderer::world_to_screen(*camera, (const Vector3f*)world_pos, count, (Vector2f*)out, visible);
+
+        return REFRAMEWORK_ERROR_NONE;
+    },
+    [](REFrameworkTypeDefinitionHandle component_type, REFrameworkSceneEntry* out, unsigned int out_size, unsigned int* out_count) -> REFrameworkResult {
+        const auto scene = sdk::get_scene_snapshot();
+        const auto capacity = out_size / sizeof(REFrameworkSceneEntry);
+
+        uint32_t needed = 0;
+
+        const auto add_entry = [&](const sdk::SceneEntry& entry, ::REComponent* component) {
+            if (needed < capacity) {
+                auto& dst = out[needed];
+                dst.transform = (REFrameworkManagedObjectHandle)entry.transform;
+                dst.game_object = (REFrameworkManagedObjectHandle)entry.game_object;
+                dst.component = (REFrameworkManagedObjectHandle)component;
+                dst.position[0] = entry.position.x;
+                dst.position[1] = entry.position.y;
+                dst.position[2] = entry.position.z;
+                dst.depth = entry.depth;
+            }
+
+            ++needed;
+        };
+
+        if (component_type != nullptr) {
+            scene->for_each_with_component(((sdk::RETypeDefinition*)component_type)->get_type(), add_entry);
+        } else {
+            for (const auto& entry : scene->get_entries()) {
+                add_entry(entry, nullptr);
+            }
+        }
+
+        if (out_count != nullptr) {
+            *out_count = needed;
+        }
+
+        return needed > capacity ? REFRAMEWORK_ERROR_OUT_TOO_SMALL : REFRAMEWORK_ERROR_NONE;
+    }
 };
 
 #define RETYPEDEF(var) ((sdk::RETypeDefinition*)var)
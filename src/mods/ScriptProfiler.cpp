@@ -0,0 +1,480 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <optional>
+
+#include <imgui.h>
+#include <spdlog/spdlog.h>
+
+#include "utility/Module.hpp"
+
+#include "REFramework.hpp"
+
+#include "ScriptProfiler.hpp"
+
+#include <lstate.h> // weird include order because of sol
+
+namespace detail {
+constexpr int MAX_SAMPLE_DEPTH = 64;
+
+uint64_t line_key(uint32_t function, int line) {
+    return ((uint64_t)function << 32) | (uint32_t)line;
+}
+
+// The main thread and every coroutine that hasn't been swept yet: suspended re.spawn tasks, coroutine.create/wrap
+// and sol's own. Threads can't have finalizers, so they're all on allgc (the generational lists are part of it).
+// Only safe while the state isn't running.
+template <typename F>
+void for_each_thread(lua_State* l, F&& fn) {
+    const auto g = G(l);
+
+    fn(g->mainthread);
+
+    for (auto o = g->allgc; o != nullptr; o = o->next) {
+        if (o->tt == LUA_VTHREAD) {
+            fn(gco2th(o));
+        }
+    }
+}
+}
+
+size_t ScriptProfiler::StackHash::operator()(const std::vector<LineKey>& stack) const {
+    size_t hash = stack.size();
+
+    for (auto key : stack) {
+        hash ^= std::hash<LineKey>{}(key) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    }
+
+    return hash;
+}
+
+ScriptProfiler::~ScriptProfiler() {
+    std::scoped_lock _{m_mtx};
+
+    for (auto& attachment : m_attachments) {
+        unhook(*attachment);
+    }
+}
+
+void ScriptProfiler::attach(lua_State* l) {
+    std::scoped_lock _{m_mtx};
+
+    auto& attachment = m_attachments.emplace_back(std::make_unique<Attachment>());
+    attachment->profiler = this;
+    attachment->l = l;
+
+    if (m_running) {
+        hook(*attachment);
+    }
+}
+
+void ScriptProfiler::detach(lua_State* l) {
+    std::scoped_lock _{m_mtx};
+
+    auto it = std::find_if(m_attachments.begin(), m_attachments.end(), [l](const auto& a) { return a->l == l; });
+
+    if (it == m_attachments.end()) {
+        return;
+    }
+
+    unhook(**it);
+    m_attachments.erase(it);
+}
+
+void ScriptProfiler::start() {
+    std::scoped_lock _{m_mtx};
+
+    if (m_running) {
+        return;
+    }
+
+    m_running = true;
+    m_start_time = std::chrono::steady_clock::now();
+
+    for (auto& attachment : m_attachments) {
+        hook(*attachment);
+    }
+}
+
+void ScriptProfiler::stop() {
+    std::scoped_lock _{m_mtx};
+
+    if (!m_running) {
+        return;
+    }
+
+    m_running = false;
+    m_elapsed += std::chrono::steady_clock::now() - m_start_time;
+
+    for (auto& attachment : m_attachments) {
+        unhook(*attachment);
+    }
+}
+
+void ScriptProfiler::clear() {
+    std::scoped_lock _{m_mtx};
+
+    m_total_samples = 0;
+    m_total_alloc_bytes = 0;
+    m_start_time = std::chrono::steady_clock::now();
+    m_elapsed = {};
+    m_functions.clear();
+    m_function_ids.clear();
+    m_scripts.clear();
+    m_script_ids.clear();
+    m_lines.clear();
+    m_folded.clear();
+}
+
+void ScriptProfiler::hook(Attachment& attachment) {
+    if (attachment.hooked) {
+        return;
+    }
+
+    // The caller holds the state's lock (or the state isn't running yet), so swapping the allocator is safe.
+    // Blocks allocated before this still get freed through the wrapper, which just forwards to the original.
+    attachment.original_alloc = lua_getallocf(attachment.l, &attachment.original_ud);
+    lua_setallocf(attachment.l, &ScriptProfiler::alloc_hook, &attachment);
+
+    // Each thread has its own hook. Coroutines created from here on copy it from their creator,
+    // but the ones that already exist have to be hooked one by one or their time goes unsampled.
+    detail::for_each_thread(attachment.l, [this](lua_State* thread) {
+        lua_sethook(thread, &ScriptProfiler::count_hook, LUA_MASKCOUNT, m_instruction_interval);
+    });
+
+    attachment.hooked = true;
+}
+
+void ScriptProfiler::unhook(Attachment& attachment) {
+    if (!attachment.hooked) {
+        return;
+    }
+
+    // Likewise, or coroutines that outlive the profiling session keep paying for the hook.
+    detail::for_each_thread(attachment.l, [](lua_State* thread) { lua_sethook(thread, nullptr, 0, 0); });
+    lua_setallocf(attachment.l, attachment.original_alloc, attachment.original_ud);
+
+    attachment.hooked = false;
+}
+
+void* ScriptProfiler::alloc_hook(void* ud, void* ptr, size_t osize, size_t nsize) {
+    auto attachment = (Attachment*)ud;
+
+    // osize is a type tag rather than a size when ptr is null.
+    const auto old_size = ptr != nullptr ? osize : 0;
+
+    if (nsize > old_size) {
+        attachment->pending_bytes += nsize - old_size;
+        ++attachment->pending_allocs;
+    }
+
+    return attachment->original_alloc(attachment->original_ud, ptr, osize, nsize);
+}
+
+void ScriptProfiler::count_hook(lua_State* l, lua_Debug* ar) {
+    void* ud = nullptr;
+
+    // Coroutines share the allocator of their main state, which is how the hook finds its attachment.
+    if (lua_getallocf(l, &ud) != &ScriptProfiler::alloc_hook || ud == nullptr) {
+        return;
+    }
+
+    auto attachment = (Attachment*)ud;
+    attachment->profiler->sample(l, *attachment);
+}
+
+void ScriptProfiler::sample(lua_State* l, Attachment& attachment) {
+    std::array<FunctionRef, detail::MAX_SAMPLE_DEPTH> functions{};
+    std::array<int, detail::MAX_SAMPLE_DEPTH> lines{};
+    int depth = 0;
+
+    lua_Debug ar{};
+
+    // Only the current line is asked for here. "S" and "n" format strings, so they wait until a function is first seen.
+    for (; depth < detail::MAX_SAMPLE_DEPTH && lua_getstack(l, depth, &ar) != 0; ++depth) {
+        if (lua_getinfo(l, "l", &ar) == 0) {
+            break;
+        }
+
+        const auto func = s2v(ar.i_ci->func);
+        auto& ref = functions[depth];
+
+        if (ttisLclosure(func)) {
+            const auto proto = clLvalue(func)->p;
+            ref.ptr = proto;
+            ref.source = proto->source;
+            ref.linedefined = proto->linedefined;
+        } else {
+            ref.ptr = ttislcf(func) ? (const void*)fvalue(func) : ttisCclosure(func) ? (const void*)clCvalue(func)->f : nullptr;
+            ref.is_c = true;
+        }
+
+        lines[depth] = ref.is_c ? 0 : ar.currentline;
+    }
+
+    if (depth == 0) {
+        return;
+    }
+
+    const auto pending_bytes = attachment.pending_bytes;
+    const auto pending_allocs = attachment.pending_allocs;
+    attachment.pending_bytes = 0;
+    attachment.pending_allocs = 0;
+
+    std::scoped_lock _{m_mtx};
+
+    ++m_total_samples;
+    m_total_alloc_bytes += pending_bytes;
+
+    // Level 0 is the innermost. Self time goes to it, and the script is whichever Lua function is innermost.
+    m_stack.clear();
+
+    std::optional<uint32_t> script{};
+
+    for (auto level = depth - 1; level >= 0; --level) {
+        const auto function = get_function_id(l, level, functions[level]);
+        const auto key = detail::line_key(function, lines[level]);
+
+        if (!functions[level].is_c) {
+            script = m_functions[function].script;
+        }
+
+        // Recursion; only count a line once per sample.
+        const auto seen = std::find(m_stack.begin(), m_stack.end(), key) != m_stack.end();
+        m_stack.push_back(key);
+
+        if (seen) {
+            continue;
+        }
+
+        auto& stats = m_lines[key];
+        stats.function = function;
+        stats.line = lines[level];
+        ++stats.total_samples;
+    }
+
+    auto& top = m_lines[m_stack.back()];
+    ++top.self_samples;
+    top.alloc_bytes += pending_bytes;
+    top.allocs += pending_allocs;
+
+    auto& script_stats = m_scripts[script.value_or(m_functions[top.function].script)];
+    ++script_stats.self_samples;
+    script_stats.alloc_bytes += pending_bytes;
+
+    ++m_folded[m_stack];
+}
+
+uint32_t ScriptProfiler::get_function_id(lua_State* l, int level, const FunctionRef& ref) {
+    if (auto it = m_function_ids.find(ref.ptr); it != m_function_ids.end()) {
+        const auto& known = m_functions[it->second].ref;
+
+        if (known.source == ref.source && known.linedefined == ref.linedefined && known.is_c == ref.is_c) {
+            return it->second;
+        }
+    }
+
+    FunctionInfo info{};
+    info.ref = ref;
+
+    lua_Debug ar{};
+
+    if (lua_getstack(l, level, &ar) != 0 && lua_getinfo(l, "Sn", &ar) != 0) {
+        info.file = ar.short_src;
+
+        // Named after whoever called it first; the name is a property of the call site in Lua.
+        if (ar.name != nullptr) {
+            info.name = ar.name;
+        } else if (ar.what != nullptr && strcmp(ar.what, "main") == 0) {
+            info.name = "main chunk";
+        } else {
+            info.name = "function@" + std::to_string(ar.linedefined);
+        }
+    } else {
+        info.file = "?";
+        info.name = "?";
+    }
+
+    if (auto it = m_script_ids.find(info.file); it != m_script_ids.end()) {
+        info.script = it->second;
+    } else {
+        info.script = (uint32_t)m_scripts.size();
+        m_scripts.push_back(ScriptStats{info.file});
+        m_script_ids.emplace(info.file, info.script);
+    }
+
+    const auto id = (uint32_t)m_functions.size();
+    m_functions.push_back(std::move(info));
+    m_function_ids[ref.ptr] = id;
+
+    return id;
+}
+
+std::string ScriptProfiler::get_frame_name(LineKey key) const {
+    const auto& function = m_functions[(uint32_t)(key >> 32)];
+    return function.file + ":" + function.name + ":" + std::to_string((int)(uint32_t)key);
+}
+
+bool ScriptProfiler::export_folded(const std::string& path) {
+    std::scoped_lock _{m_mtx};
+
+    std::ofstream out{path};
+
+    if (!out) {
+        m_export_result = "Failed to open " + path;
+        return false;
+    }
+
+    for (const auto& [stack, count] : m_folded) {
+        for (size_t i = 0; i < stack.size(); ++i) {
+            if (i > 0) {
+                out << ';';
+            }
+
+            out << get_frame_name(stack[i]);
+        }
+
+        out << ' ' << count << '\n';
+    }
+
+    m_export_result = "Wrote " + std::to_string(m_folded.size()) + " stacks to " + path;
+    spdlog::info("[ScriptProfiler] {}", m_export_result);
+
+    return true;
+}
+
+void ScriptProfiler::on_draw_ui() {
+    if (!ImGui::TreeNode("Script Profiler")) {
+        return;
+    }
+
+    if (!m_running) {
+        if (ImGui::Button("Start")) {
+            start();
+        }
+    } else if (ImGui::Button("Stop")) {
+        stop();
+    }
+
+    ImGui::SameLine();
+
+    if (ImGui::Button("Clear")) {
+        clear();
+    }
+
+    ImGui::SameLine();
+
+    if (ImGui::Button("Export Folded Stacks")) {
+        const auto dir = utility::get_module_directory(g_framework->get_module().as<HMODULE>()).value_or(".");
+        export_folded(dir + "/reframework_lua_profile.folded");
+    }
+
+    if (!m_running) {
+        ImGui::SliderInt("Instructions per Sample", &m_instruction_interval, 100, 100000);
+    }
+
+    std::scoped_lock _{m_mtx};
+
+    if (!m_export_result.empty()) {
+        ImGui::TextWrapped("%s", m_export_result.c_str());
+    }
+
+    const auto elapsed = m_elapsed + (m_running ? std::chrono::steady_clock::now() - m_start_time : std::chrono::steady_clock::duration{});
+    const auto seconds = std::chrono::duration<float>(elapsed).count();
+
+    ImGui::Text("Samples: %llu over %.1fs", m_total_samples, seconds);
+    ImGui::Text("Allocated: %.2f MB (%.2f MB/s)", (float)m_total_alloc_bytes / 1024.0f / 1024.0f,
+        seconds > 0.0f ? (float)m_total_alloc_bytes / 1024.0f / 1024.0f / seconds : 0.0f);
+
+    if (m_total_samples == 0) {
+        ImGui::TreePop();
+        return;
+    }
+
+    const auto percent = [&](uint64_t samples) { return (float)samples * 100.0f / (float)m_total_samples; };
+
+    if (ImGui::TreeNode("By Script")) {
+        std::vector<const ScriptStats*> scripts{};
+        scripts.reserve(m_scripts.size());
+
+        for (const auto& stats : m_scripts) {
+            if (stats.self_samples > 0) {
+                scripts.push_back(&stats);
+            }
+        }
+
+        std::sort(scripts.begin(), scripts.end(), [](const ScriptStats* a, const ScriptStats* b) {
+            return a->self_samples > b->self_samples;
+        });
+
+        if (ImGui::BeginTable("##scripts", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Script");
+            ImGui::TableSetupColumn("Samples %");
+            ImGui::TableSetupColumn("Alloc KB");
+            ImGui::TableHeadersRow();
+
+            for (const auto stats : scripts) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(stats->file.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", percent(stats->self_samples));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", (float)stats->alloc_bytes / 1024.0f);
+            }
+
+            ImGui::EndTable();
+        }
+
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("By Line")) {
+        std::vector<const LineStats*> lines{};
+        lines.reserve(m_lines.size());
+
+        for (const auto& [key, stats] : m_lines) {
+            lines.push_back(&stats);
+        }
+
+        std::sort(lines.begin(), lines.end(), [](const LineStats* a, const LineStats* b) {
+            return a->self_samples != b->self_samples ? a->self_samples > b->self_samples : a->total_samples > b->total_samples;
+        });
+
+        if (ImGui::BeginTable("##lines", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY, ImVec2{0, 400})) {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("File");
+            ImGui::TableSetupColumn("Function");
+            ImGui::TableSetupColumn("Line");
+            ImGui::TableSetupColumn("Self %");
+            ImGui::TableSetupColumn("Total %");
+            ImGui::TableSetupColumn("Alloc KB");
+            ImGui::TableHeadersRow();
+
+            for (const auto stats : lines) {
+                const auto& function = m_functions[stats->function];
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(function.file.c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(function.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", stats->line);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", percent(stats->self_samples));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", percent(stats->total_samples));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", (float)stats->alloc_bytes / 1024.0f);
+            }
+
+            ImGui::EndTable();
+        }
+
+        ImGui::TreePop();
+    }
+
+    ImGui::TreePop();
+}
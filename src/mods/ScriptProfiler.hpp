@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sol/sol.hpp>
+
+// Sampling profiler for the Lua states ScriptRunner owns.
+//
+// A count hook takes a sample every N VM instructions and records the whole Lua stack, so results can be
+// broken down by (file, function, line) or exported as folded stacks for flamegraph.pl / speedscope.
+// Samples are keyed by (function, line); names are only turned into strings when the UI or the export asks.
+// While attached, the state's allocator is wrapped too. Allocations aren't attributed exactly (the allocator
+// doesn't know which coroutine is running); instead the bytes allocated since the previous sample are
+// charged to the stack of the next one, which is close enough to spot the scripts that churn the heap.
+class ScriptProfiler {
+public:
+    ScriptProfiler() = default;
+    ~ScriptProfiler();
+
+    // Hooks the state if the profiler is running, and remembers it for when it starts.
+    void attach(lua_State* l);
+    void detach(lua_State* l);
+
+    void start();
+    void stop();
+    void clear();
+
+    bool is_running() const {
+        return m_running;
+    }
+
+    // One line per unique stack, "frame;frame;frame count", root first.
+    bool export_folded(const std::string& path);
+
+    void on_draw_ui();
+
+private:
+    struct Attachment {
+        ScriptProfiler* profiler{};
+        lua_State* l{};
+        lua_Alloc original_alloc{};
+        void* original_ud{};
+        bool hooked{false};
+
+        // Allocation since the last sample; only touched by the thread running this state.
+        uint64_t pending_bytes{};
+        uint64_t pending_allocs{};
+    };
+
+    // A Lua function's Proto, or a C function. The chunk name and linedefined are kept alongside the pointer
+    // to tell a function apart from a new one that reuses its address after being collected.
+    struct FunctionRef {
+        const void* ptr{};
+        const void* source{};
+        int linedefined{};
+        bool is_c{};
+    };
+
+    // Copied once per function, the first time a sample lands in it.
+    struct FunctionInfo {
+        FunctionRef ref{};
+        std::string file{};
+        std::string name{};
+        uint32_t script{};
+    };
+
+    struct LineStats {
+        uint32_t function{};
+        int line{};
+        uint64_t self_samples{};
+        uint64_t total_samples{};
+        uint64_t alloc_bytes{};
+        uint64_t allocs{};
+    };
+
+    struct ScriptStats {
+        std::string file{};
+        uint64_t self_samples{};
+        uint64_t alloc_bytes{};
+    };
+
+    // Function ID in the high half, line in the low half.
+    using LineKey = uint64_t;
+
+    struct StackHash {
+        size_t operator()(const std::vector<LineKey>& stack) const;
+    };
+
+    static void* alloc_hook(void* ud, void* ptr, size_t osize, size_t nsize);
+    static void count_hook(lua_State* l, lua_Debug* ar);
+
+    void hook(Attachment& attachment);
+    void unhook(Attachment& attachment);
+    void sample(lua_State* l, Attachment& attachment);
+    uint32_t get_function_id(lua_State* l, int level, const FunctionRef& ref);
+    std::string get_frame_name(LineKey key) const;
+
+    std::mutex m_mtx{};
+    std::vector<std::unique_ptr<Attachment>> m_attachments{};
+
+    bool m_running{false};
+    int m_instruction_interval{1000};
+
+    // Everything below is guarded by m_mtx.
+    uint64_t m_total_samples{};
+    uint64_t m_total_alloc_bytes{};
+    std::chrono::steady_clock::time_point m_start_time{};
+    std::chrono::steady_clock::duration m_elapsed{};
+
+    std::vector<FunctionInfo> m_functions{};
+    std::unordered_map<const void*, uint32_t> m_function_ids{};
+    std::vector<ScriptStats> m_scripts{};
+    std::unordered_map<std::string, uint32_t> m_script_ids{};
+
+    std::unordered_map<LineKey, LineStats> m_lines{};
+    std::unordered_map<std::vector<LineKey>, uint64_t, StackHash> m_folded{};
+    std::vector<LineKey> m_stack{}; // scratch for sample, root first
+
+    std::string m_export_result{};
+};
@@ -1,5 +1,6 @@
 #define NOMINMAX
 
+#include <algorithm>
 #include <cstdint>
 #include <filesystem>
 
@@ -14,12 +15,15 @@
 #include "utility/String.hpp"
 
 #include "Mods.hpp"
+#include "Hooks.hpp"
 
 #include "bindings/Sdk.hpp"
 #include "bindings/ImGui.hpp"
 #include "bindings/Json.hpp"
 #include "bindings/FS.hpp"
+#include "bindings/Channel.hpp"
 
+#include "ValueTypeStorage.hpp"
 #include "ScriptRunner.hpp"
 
 #include <lstate.h> // weird include order because of sol
@@ -51,7 +55,88 @@ void debug(const char* str) {
 }
 }
 
-ScriptState::ScriptState(const ScriptState::GarbageCollectionData& gc_data) {
+namespace detail {
+struct ObserverEvent {
+    size_t observer_id{};
+    bool post{};
+    uintptr_t ret_val{};
+    size_t args_start{};
+    size_t num_args{};
+};
+
+// One per thread that calls an observed function, so those threads never contend with each other.
+// The Lua thread swaps the contents out when dispatching.
+struct ObserverQueue {
+    std::mutex mtx{};
+    std::vector<ObserverEvent> events{};
+    std::vector<uintptr_t> args{};
+};
+
+// Per thread. Only reached when frames stop being drained (a hitch, a loading screen) while an observed
+// function keeps getting called; past this, new events are dropped rather than growing without bound.
+constexpr size_t MAX_QUEUED_OBSERVER_EVENTS = 1 << 16;
+
+std::atomic<size_t> g_next_observer_id{1};
+std::mutex g_observer_queues_mtx{};
+std::vector<std::unique_ptr<ObserverQueue>> g_observer_queues{};
+std::atomic<uint64_t> g_dropped_observer_events{0};
+uint64_t g_last_dropped_observer_events{0}; // as of the last drain
+
+void enqueue_observer_event(size_t observer_id, bool post, const HookManager::ObserverFrame& frame) {
+    thread_local ObserverQueue* queue = nullptr;
+
+    if (queue == nullptr) {
+        std::scoped_lock _{g_observer_queues_mtx};
+        queue = g_observer_queues.emplace_back(std::make_unique<ObserverQueue>()).get();
+    }
+
+    std::scoped_lock _{queue->mtx};
+
+    if (queue->events.size() >= MAX_QUEUED_OBSERVER_EVENTS) {
+        g_dropped_observer_events.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    queue->events.emplace_back(observer_id, post, frame.ret_val, queue->args.size(), frame.num_args);
+    queue->args.insert(queue->args.end(), frame.args, frame.args + frame.num_args);
+}
+
+// Every queue drained into one batch at the start of ScriptRunner::on_frame. Each state then picks out the events
+// for its own observers, so the batch is only read until the next frame.
+std::vector<ObserverEvent> g_drained_events{};
+std::vector<uintptr_t> g_drained_args{};
+
+void drain_observer_events() {
+    g_drained_events.clear();
+    g_drained_args.clear();
+
+    std::scoped_lock _{g_observer_queues_mtx};
+
+    for (auto& queue : g_observer_queues) {
+        std::scoped_lock __{queue->mtx};
+
+        const auto args_offset = g_drained_args.size();
+
+        for (auto& event : queue->events) {
+            event.args_start += args_offset;
+            g_drained_events.push_back(event);
+        }
+
+        g_drained_args.insert(g_drained_args.end(), queue->args.begin(), queue->args.end());
+        queue->events.clear();
+        queue->args.clear();
+    }
+
+    if (const auto dropped = g_dropped_observer_events.load(std::memory_order_relaxed); dropped != g_last_dropped_observer_events) {
+        spdlog::warn("[ScriptRunner] Dropped {} hook observer events; the queue was full", dropped - g_last_dropped_observer_events);
+        g_last_dropped_observer_events = dropped;
+    }
+}
+}
+
+ScriptState::ScriptState(const ScriptState::GarbageCollectionData& gc_data, std::string name)
+    : m_name{std::move(name)}
+{
     std::scoped_lock _{ m_execution_mutex };
 
     m_lua.registry()["state"] = this;
@@ -74,17 +159,27 @@ ScriptState::ScriptState(const ScriptState::GarbageCollectionData& gc_data) {
     bindings::open_imgui(this);
     bindings::open_json(this);
     bindings::open_fs(this);
+    bindings::open_channel(this);
+
+    // Sized once so the hooks can index these without locking; entries are never hooked after startup.
+    m_pre_application_entry_fns.resize(Hooks::get_num_application_entries());
+    m_application_entry_fns.resize(Hooks::get_num_application_entries());
 
     auto re = m_lua.create_table();
     re["msg"] = api::re::msg;
-    re["on_pre_application_entry"] = [this](const char* name, sol::function fn) { m_pre_application_entry_fns.emplace(utility::hash(name), fn); };
-    re["on_application_entry"] = [this](const char* name, sol::function fn) { m_application_entry_fns.emplace(utility::hash(name), fn); };
+    re["on_pre_application_entry"] = [this](const char* name, sol::function fn) { add_application_entry_fn(m_pre_application_entry_fns, std::string{"Pre"} + name, name, fn); };
+    re["on_application_entry"] = [this](const char* name, sol::function fn) { add_application_entry_fn(m_application_entry_fns, name, name, fn); };
     re["on_pre_gui_draw_element"] = [this](sol::function fn) { m_pre_gui_draw_element_fns.emplace_back(fn); };
     re["on_gui_draw_element"] = [this](sol::function fn) { m_gui_draw_element_fns.emplace_back(fn); };
     re["on_draw_ui"] = [this](sol::function fn) { m_on_draw_ui_fns.emplace_back(fn); };
     re["on_frame"] = [this](sol::function fn) { m_on_frame_fns.emplace_back(fn); };
     re["on_script_reset"] = [this](sol::function fn) { m_on_script_reset_fns.emplace_back(fn); };
     re["on_config_save"] = [this](sol::function fn) { m_on_config_save_fns.emplace_back(fn); };
+
+    re.push();
+    m_tasks.open(-1);
+    lua_pop(m_lua, 1);
+
     m_lua["re"] = re;
 
 
@@ -289,6 +384,10 @@ ScriptState::ScriptState(const ScriptState::GarbageCollectionData& gc_data) {
 
 ScriptState::~ScriptState() {
     std::scoped_lock _{m_execution_mutex};
+
+    // Functions left without any callbacks get unhooked together when this is committed.
+    HookManager::Transaction transaction{g_hookman};
+
     for (auto&& [fn, hook_ids] : m_hooks) {
         for (auto&& id : hook_ids) {
             g_hookman.remove(fn, id);
@@ -314,7 +413,28 @@ void ScriptState::run_script(const std::string& p) {
         package_path = package_path + ";" + dir.string() + "/?.dll";
 
         m_lua["package"]["path"] = package_path;
-        m_lua.safe_script_file(p);
+
+        const auto source = LuaChunkCache::read_file(p);
+
+        if (!source) {
+            throw std::runtime_error{"Failed to open " + p};
+        }
+
+        auto l = m_lua.lua_state();
+
+        if (ScriptRunner::get()->get_chunk_cache().load(l, p, *source) != LUA_OK) {
+            std::string error = lua_tostring(l, -1);
+            lua_pop(l, 1);
+            throw std::runtime_error{error};
+        }
+
+        auto fn = sol::stack::pop<sol::protected_function>(l);
+        auto result = fn();
+
+        if (!result.valid()) {
+            sol::error e = result;
+            throw e;
+        }
     } catch (const std::exception& e) {
         ScriptRunner::get()->spew_error(e.what());
         api::re::msg(e.what());
@@ -340,9 +460,17 @@ void ScriptState::on_frame() {
     try {
         std::scoped_lock _{ m_execution_mutex };
 
+        dispatch_observer_events();
+        m_file_requests.dispatch(m_lua.lua_state());
+
         for (auto& fn : m_on_frame_fns) {
             handle_protected_result(fn());
         }
+
+        m_tasks.run_frame(m_task_budget, [](const std::string& e) { ScriptRunner::get()->spew_error(e); });
+
+        // Hands back the slabs the GC emptied, whichever way it's being driven.
+        m_allocator.maybe_trim();
     } catch (const std::exception& e) {
         ScriptRunner::get()->spew_error(e.what());
     } catch (...) {
@@ -351,10 +479,6 @@ void ScriptState::on_frame() {
 }
 
 void ScriptState::on_draw_ui() {
-    if (!ImGui::CollapsingHeader("Script Generated UI")) {
-        return;
-    }
-
     try {
         std::scoped_lock _{ m_execution_mutex };
 
@@ -368,19 +492,39 @@ void ScriptState::on_draw_ui() {
     }
 }
 
-void ScriptState::on_pre_application_entry(size_t hash) {
+void ScriptState::add_application_entry_fn(std::vector<std::vector<ApplicationEntryFn>>& fns, std::string_view group, const char* name, sol::function fn) {
+    const auto id = Hooks::get_application_entry_id(name);
+
+    if (!id) {
+        spdlog::warn("[ScriptRunner] {} is not a hooked application entry", name);
+        return;
+    }
+
+    // Profile each callback under the script and line it was defined on.
+    lua_Debug ar{};
+    fn.push();
+    lua_getinfo(m_lua, ">S", &ar);
+
+    const auto scope_name = fmt::format("{}:{}", ar.short_src, ar.linedefined);
+    const auto scope = g_profiler.register_scope(group, scope_name, FrameProfiler::ScopeKind::SCRIPT);
+
+    fns[*id].emplace_back(ApplicationEntryFn{fn, scope});
+}
+
+void ScriptState::on_pre_application_entry(size_t id) {
     try {
-        if (m_pre_application_entry_fns.empty()) {
+        if (id >= m_pre_application_entry_fns.size()) {
             return;
         }
 
-        auto range = m_pre_application_entry_fns.equal_range(hash);
+        auto& fns = m_pre_application_entry_fns[id];
 
-        if (range.first != range.second) {
+        if (!fns.empty()) {
             std::scoped_lock _{ m_execution_mutex };
 
-            for (auto it = range.first; it != range.second; ++it) {
-                handle_protected_result(it->second());
+            for (auto& entry_fn : fns) {
+                FrameProfiler::Scope _{g_profiler, entry_fn.scope};
+                handle_protected_result(entry_fn.fn());
             }
         }
     } catch (const std::exception& e) {
@@ -390,19 +534,20 @@ void ScriptState::on_pre_application_entry(size_t hash) {
     }
 }
 
-void ScriptState::on_application_entry(size_t hash) {
+void ScriptState::on_application_entry(size_t id, size_t hash) {
     try {
-        if (m_application_entry_fns.empty()) {
+        if (id >= m_application_entry_fns.size()) {
             return;
         }
 
-        auto range = m_application_entry_fns.equal_range(hash);
+        auto& fns = m_application_entry_fns[id];
 
-        if (range.first != range.second) {
+        if (!fns.empty()) {
             std::scoped_lock _{ m_execution_mutex };
 
-            for (auto it = range.first; it != range.second; ++it) {
-                handle_protected_result(it->second());
+            for (auto& entry_fn : fns) {
+                FrameProfiler::Scope _{g_profiler, entry_fn.scope};
+                handle_protected_result(entry_fn.fn());
             }
         }
     } catch (const std::exception& e) {
@@ -412,6 +557,8 @@ void ScriptState::on_application_entry(size_t hash) {
     }
 
     if (hash == "EndRendering"_fnv && m_gc_data.gc_handler == ScriptState::GarbageCollectionHandler::REFRAMEWORK_MANAGED) {
+        std::scoped_lock _{ m_execution_mutex };
+
         switch (m_gc_data.gc_type) {
             case ScriptState::GarbageCollectionType::FULL:
                 lua_gc(m_lua, LUA_GCCOLLECT);
@@ -507,16 +654,56 @@ void ScriptState::add_hook(
     m_hooks_to_add.emplace_back(fn, pre_cb, post_cb, ignore_jmp_obj);
 }
 
+void ScriptState::add_observer(
+    sdk::REMethodDefinition* fn, sol::protected_function pre_cb, sol::protected_function post_cb, sol::object ignore_jmp_obj) {
+    m_hooks_to_add.emplace_back(fn, pre_cb, post_cb, ignore_jmp_obj, true);
+}
+
 void ScriptState::install_hooks() {
+    if (m_hooks_to_add.empty()) {
+        return;
+    }
+
+    // Installs everything that was queued with one JIT allocation and one round of thread suspension.
+    HookManager::Transaction transaction{g_hookman};
+
     for (; !m_hooks_to_add.empty(); m_hooks_to_add.pop_front()) {
         auto hookdef = m_hooks_to_add.front();
         auto fn = hookdef.fn;
         auto pre_cb = hookdef.pre_cb;
         auto post_cb = hookdef.post_cb;
         auto ignore_jmp_object = hookdef.ignore_jmp_obj;
+
+        if (hookdef.observer) {
+            const auto observer_id = detail::g_next_observer_id++;
+            auto script_args = sol::make_object(m_lua, api::sdk::HookArgs{fn});
+            auto script_args_view = &script_args.as<api::sdk::HookArgs&>();
+
+            m_observers.emplace(observer_id, ObserverDef{fn, pre_cb, post_cb, script_args, script_args_view, fn->get_param_types()});
+
+            HookManager::PreObserverFn pre_fn{};
+            HookManager::PostObserverFn post_fn{};
+
+            if (!pre_cb.is<sol::nil_t>()) {
+                pre_fn = [observer_id](const HookManager::ObserverFrame& frame) { detail::enqueue_observer_event(observer_id, false, frame); };
+            }
+
+            if (!post_cb.is<sol::nil_t>()) {
+                post_fn = [observer_id](const HookManager::ObserverFrame& frame) { detail::enqueue_observer_event(observer_id, true, frame); };
+            }
+
+            auto id = g_hookman.add_observer(fn, pre_fn, post_fn, ignore_jmp_object.is<bool>() ? ignore_jmp_object.as<bool>() : false);
+            m_hooks[fn].emplace_back(id);
+            continue;
+        }
+
+        // Reused for every call of this hook so calling into the script doesn't allocate.
+        auto script_args = sol::make_object(m_lua, api::sdk::HookArgs{fn});
+        auto script_args_view = &script_args.as<api::sdk::HookArgs&>();
+
         auto id = g_hookman.add(
             fn,
-            [pre_cb, state = this](auto& args, auto& arg_tys) -> HookManager::PreHookResult {
+            [pre_cb, script_args, script_args_view, state = this](auto& args, auto& arg_tys) -> HookManager::PreHookResult {
                 using PreHookResult = HookManager::PreHookResult;
 
                 auto _ = state->scoped_lock();
@@ -527,30 +714,16 @@ void ScriptState::install_hooks() {
                         return result;
                     }
 
-                    auto script_args = state->lua().create_table();
-
                     // Call the script function.
-                    // Convert the args to a table that we pass to the script function.
-                    for (auto i = 0u; i < args.size(); ++i) {
-                        script_args[i + 1] = (void*)args[i];
-                    }
+                    // The script reads and modifies the args directly through the view.
+                    script_args_view->begin_call(&args, &arg_tys);
 
                     auto script_result = pre_cb(script_args);
 
                     if (!script_result.valid()) {
                         sol::script_default_on_error(state->lua(), std::move(script_result));
-                    }
-
-                    auto script_result_obj = script_result.get<sol::object>();
-
-                    if (script_result_obj.is<PreHookResult>()) {
-                        result = script_result_obj.as<PreHookResult>();
-                    }
-
-                    // Apply the changes to arguments that the script function may have made.
-                    for (auto i = 0u; i < args.size(); ++i) {
-                        auto arg = script_args[i + 1];
-                        args[i] = (uintptr_t)arg.get<void*>();
+                    } else if (script_result.get_type() == sol::type::number) {
+                        result = (PreHookResult)script_result.get<int>();
                     }
                 } catch (const std::exception& e) {
                     ScriptRunner::get()->spew_error(e.what());
@@ -558,6 +731,7 @@ void ScriptState::install_hooks() {
                     ScriptRunner::get()->spew_error("Unknown exception in pre_hook");
                 }
 
+                script_args_view->end_call();
                 return result;
             },
             [post_cb, state = this](auto& ret_val, auto* ret_ty) {
@@ -586,6 +760,38 @@ void ScriptState::install_hooks() {
     }
 }
 
+void ScriptState::dispatch_observer_events() {
+    const auto& args = detail::g_drained_args;
+
+    for (const auto& event : detail::g_drained_events) {
+        auto it = m_observers.find(event.observer_id);
+
+        if (it == m_observers.end()) {
+            continue;
+        }
+
+        auto& def = it->second;
+
+        // The values are the ones the function was called with. Objects they point to may be gone by now.
+        m_observer_args.assign(args.begin() + event.args_start, args.begin() + event.args_start + event.num_args);
+        def.script_args_view->begin_call(&m_observer_args, &def.arg_tys);
+
+        try {
+            if (event.post) {
+                handle_protected_result(def.post_cb((void*)event.ret_val, def.script_args));
+            } else {
+                handle_protected_result(def.pre_cb(def.script_args));
+            }
+        } catch (const std::exception& e) {
+            ScriptRunner::get()->spew_error(e.what());
+        } catch (...) {
+            ScriptRunner::get()->spew_error("Unknown exception in hook observer");
+        }
+
+        def.script_args_view->end_call();
+    }
+}
+
 void ScriptState::gc_data_changed(GarbageCollectionData data) {
     // Handler
     switch (data.gc_handler) {
@@ -632,6 +838,12 @@ std::shared_ptr<ScriptRunner>& ScriptRunner::get() {
     return instance;
 }
 
+ScriptRunner::~ScriptRunner() {
+    if (m_precompile_thread != nullptr && m_precompile_thread->joinable()) {
+        m_precompile_thread->join();
+    }
+}
+
 std::optional<std::string> ScriptRunner::on_initialize() {
     return Mod::on_initialize();
 }
@@ -643,8 +855,29 @@ void ScriptRunner::on_config_load(const utility::Config& cfg) {
         option.config_load(cfg);
     }
 
-    if (m_state != nullptr) {
-        m_state->gc_data_changed(make_gc_data());
+    for (auto& state : m_states) {
+        state->gc_data_changed(make_gc_data());
+    }
+
+    apply_task_budget();
+
+    // Config is loaded right after initialization, well before the first reset_scripts, which will then find
+    // most of the autorun scripts already compiled. Scripts it gets to first are just compiled there instead.
+    if (m_precompile_autorun->value() && m_precompile_thread == nullptr) {
+        m_precompile_thread = std::make_unique<std::thread>([this]() {
+            const auto autorun_path = get_autorun_path();
+            std::error_code ec{};
+
+            for (auto&& entry : std::filesystem::directory_iterator{autorun_path, ec}) {
+                auto&& path = entry.path();
+
+                if (path.has_extension() && path.extension() == ".lua") {
+                    m_chunk_cache.precompile(path.string());
+                }
+            }
+
+            spdlog::info("[ScriptRunner] Precompiled {} autorun scripts", m_chunk_cache.get_stats().entries);
+        });
     }
 }
 
@@ -655,8 +888,8 @@ void ScriptRunner::on_config_save(utility::Config& cfg) {
         option.config_save(cfg);
     }
 
-    if (m_state != nullptr) {
-        m_state->on_config_save();
+    for (auto& state : m_states) {
+        state->on_config_save();
     }
 }
 
@@ -673,15 +906,18 @@ void ScriptRunner::on_frame() {
         spdlog::info("[ScriptRunner] Lua state initialized.");
     }
 
-    if (m_state == nullptr) {
-        return;
-    }
+    detail::drain_observer_events();
 
-    m_state->on_frame();
+    // Once a frame, so lists replaced while a reader was still inside one don't linger until the next change.
+    g_hookman.reclaim_observer_lists();
+
+    for_each_state([](ScriptState& state) { state.on_frame(); });
 
     // install_hooks gets called here because it ensures hooks get installed the next frame after they've been 
     // enqueued. This prevents a race that can occur if hooks were installed immediately during script loading.
-    m_state->install_hooks();
+    for (auto& state : m_states) {
+        state->install_hooks();
+    }
 }
 
 void ScriptRunner::on_draw_ui() {
@@ -701,8 +937,16 @@ void ScriptRunner::on_draw_ui() {
 
             if (GetOpenFileName(&ofn) != FALSE) {
                 std::scoped_lock _{ m_access_mutex };
-                m_state->run_script(file);
-                m_loaded_scripts.emplace_back(std::filesystem::path{file}.filename().string());
+                const auto filename = std::filesystem::path{file}.filename().string();
+
+                if (m_isolate_scripts->value() || m_states.empty()) {
+                    create_state(filename).run_script(file);
+                } else {
+                    m_states.front()->run_script(file);
+                }
+
+                m_loaded_scripts.emplace_back(filename);
+                apply_task_budget();
             }
         }
 
@@ -728,51 +972,141 @@ void ScriptRunner::on_draw_ui() {
         if (ImGui::TreeNode("Garbage Collection Stats")) {
             std::scoped_lock _{ m_access_mutex };
 
-            auto g = G(m_state->lua().lua_state());
-            const auto bytes_in_use = g->totalbytes + g->GCdebt;
+            const auto to_mb = [](size_t bytes) { return (float)bytes / 1024.0f / 1024.0f; };
+
+            for (auto& state : m_states) {
+                ImGui::PushID(state.get());
 
-            ImGui::Text("Megabytes in use: %.2f", (float)bytes_in_use / 1024.0f / 1024.0f);
+                if (m_states.size() > 1) {
+                    ImGui::Text("%s", state->get_name().c_str());
+                    ImGui::Indent();
+                }
+
+                auto g = G(state->lua().lua_state());
+                const auto bytes_in_use = g->totalbytes + g->GCdebt;
+
+                ImGui::Text("Megabytes in use: %.2f", (float)bytes_in_use / 1024.0f / 1024.0f);
+
+                const auto stats = state->get_allocator_stats();
+
+                ImGui::Text("Allocator live: %.2f MB in %zu blocks (peak %.2f MB)", to_mb(stats.live_bytes), stats.live_blocks, to_mb(stats.peak_bytes));
+                ImGui::Text("Small blocks: %.2f MB of %.2f MB in slabs", to_mb(stats.small_bytes), to_mb(stats.slab_bytes));
+                ImGui::Text("Large blocks: %.2f MB", to_mb(stats.large_bytes));
+                ImGui::Text("Total allocations: %llu", stats.allocations);
+
+                if (ImGui::Button("Reset Peak")) {
+                    state->reset_allocator_peak();
+                }
+
+                if (m_states.size() > 1) {
+                    ImGui::Unindent();
+                }
+
+                ImGui::PopID();
+            }
+
+            const auto value_type_stats = ValueTypeStorage::get_stats();
+
+            ImGui::Text("Pooled ValueType blocks: %zu in use, %zu free", value_type_stats.live_blocks, value_type_stats.pooled_blocks);
 
             ImGui::TreePop();
         }
 
         if (m_gc_handler->draw("Garbage Collection Handler")) {
             std::scoped_lock _{ m_access_mutex };
-            m_state->gc_data_changed(make_gc_data());
+            for_each_state([this](ScriptState& state) { state.gc_data_changed(make_gc_data()); });
         }
 
         if (m_gc_mode->draw("Garbage Collection Mode")) {
             std::scoped_lock _{ m_access_mutex };
-            m_state->gc_data_changed(make_gc_data());
+            for_each_state([this](ScriptState& state) { state.gc_data_changed(make_gc_data()); });
         }
 
         if ((uint32_t)m_gc_mode->value() == (uint32_t)ScriptState::GarbageCollectionMode::GENERATIONAL) {
             if (m_gc_minor_multiplier->draw("Minor GC Multiplier")) {
                 std::scoped_lock _{ m_access_mutex };
-                m_state->gc_data_changed(make_gc_data());
+                for_each_state([this](ScriptState& state) { state.gc_data_changed(make_gc_data()); });
             }
 
             if (m_gc_major_multiplier->draw("Major GC Multiplier")) {
                 std::scoped_lock _{ m_access_mutex };
-                m_state->gc_data_changed(make_gc_data());
+                for_each_state([this](ScriptState& state) { state.gc_data_changed(make_gc_data()); });
             }
         }
 
         if (m_gc_handler->value() == (int32_t)ScriptState::GarbageCollectionHandler::REFRAMEWORK_MANAGED) {
             if (m_gc_type->draw("Garbage Collection Type")) {
                 std::scoped_lock _{ m_access_mutex };
-                m_state->gc_data_changed(make_gc_data());
+                for_each_state([this](ScriptState& state) { state.gc_data_changed(make_gc_data()); });
             }
 
             if ((uint32_t)m_gc_mode->value() != (uint32_t)ScriptState::GarbageCollectionMode::GENERATIONAL) {
                 if (m_gc_budget->draw("Garbage Collection Budget")) {
                     std::scoped_lock _{ m_access_mutex };
-                    m_state->gc_data_changed(make_gc_data());
+                    for_each_state([this](ScriptState& state) { state.gc_data_changed(make_gc_data()); });
                 }
             }
         }
 
+        if (m_task_budget->draw("Task Budget (us)")) {
+            std::scoped_lock _{ m_access_mutex };
+            apply_task_budget();
+        }
+
+        if (ImGui::TreeNode("Tasks")) {
+            std::scoped_lock _{ m_access_mutex };
+
+            LuaTaskScheduler::Stats total{};
+
+            for (auto& state : m_states) {
+                const auto& stats = state->get_task_stats();
+
+                total.tasks += stats.tasks;
+                total.resumed += stats.resumed;
+                total.deferred += stats.deferred;
+                total.time += stats.time;
+            }
+
+            ImGui::Text("Tasks: %zu", total.tasks);
+            ImGui::Text("Last frame: %zu resumed, %zu deferred, %lld us", total.resumed, total.deferred, (long long)total.time.count());
+
+            size_t pending_files{};
+
+            for (auto& state : m_states) {
+                pending_files += state->get_file_requests().get_num_pending();
+            }
+
+            ImGui::Text("File requests: %zu pending, %zu queued on the I/O thread", pending_files, g_file_worker.get_num_queued());
+            ImGui::Text("Hook observer events dropped: %llu", (unsigned long long)detail::g_dropped_observer_events.load(std::memory_order_relaxed));
+
+            ImGui::TreePop();
+        }
+
         m_log_to_disk->draw("Log Lua Errors to Disk");
+        m_precompile_autorun->draw("Precompile Autorun Scripts at Startup");
+
+        if (m_isolate_scripts->draw("Isolate Scripts (Requires Reset)")) {
+            reset_scripts();
+        }
+
+        if (ImGui::TreeNode("Bytecode Cache")) {
+            const auto stats = m_chunk_cache.get_stats();
+
+            ImGui::Text("Scripts: %zu (%.1f KB)", stats.entries, (float)stats.bytes / 1024.0f);
+            ImGui::Text("Hits: %llu, misses: %llu", stats.hits, stats.misses);
+
+            if (ImGui::Button("Clear Cache")) {
+                m_chunk_cache.clear();
+            }
+
+            ImGui::TreePop();
+        }
+
+        {
+            // Starting and stopping swaps the state's hook and allocator, so nothing may be running in it.
+            std::scoped_lock _{*this};
+            m_profiler.on_draw_ui();
+        }
 
         if (!m_last_script_error.empty()) {
             std::shared_lock _{m_script_error_mutex};
@@ -804,52 +1138,66 @@ void ScriptRunner::on_draw_ui() {
     { 
         std::scoped_lock _{ m_access_mutex };
 
-        if (m_state == nullptr) {
+        if (m_states.empty() || !ImGui::CollapsingHeader("Script Generated UI")) {
             return;
         }
 
-        m_state->on_draw_ui();
+        for (auto& state : m_states) {
+            ImGui::PushID(state.get());
+            state->on_draw_ui();
+            ImGui::PopID();
+        }
     }
 }
 
-void ScriptRunner::on_pre_application_entry(void* entry, const char* name, size_t hash) {
-    std::scoped_lock _{ m_access_mutex };
+std::vector<ModSubscription> ScriptRunner::get_subscriptions() const {
+    // Scripts can register for any entry at any time.
+    return {
+        {ModCallback::PRE_GUI_DRAW_ELEMENT},
+        {ModCallback::GUI_DRAW_ELEMENT},
+        {ModCallback::PRE_APPLICATION_ENTRY},
+        {ModCallback::APPLICATION_ENTRY},
+    };
+}
 
-    if (m_state == nullptr) {
-        return;
-    }
+void ScriptRunner::on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) {
+    std::scoped_lock _{ m_access_mutex };
 
-    m_state->on_pre_application_entry(hash);
+    for_each_state([id](ScriptState& state) { state.on_pre_application_entry(id); });
 }
 
-void ScriptRunner::on_application_entry(void* entry, const char* name, size_t hash) {
+void ScriptRunner::on_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     std::scoped_lock _{ m_access_mutex };
 
-    if (m_state == nullptr) {
-        return;
-    }
+    for_each_state([id, hash](ScriptState& state) { state.on_application_entry(id, hash); });
 
-    m_state->on_application_entry(hash);
+    // Released once every state is done with them, from the thread running the entry.
+    if (hash == "EndRendering"_fnv) {
+        api::sdk::flush_pending_releases();
+    }
 }
 
 bool ScriptRunner::on_pre_gui_draw_element(REComponent* gui_element, void* primitive_context) {
     std::scoped_lock _{ m_access_mutex };
 
-    if (m_state == nullptr) {
-        return true;
+    bool any_false = false;
+
+    // Every state gets to see the element, even after one of them has decided to hide it.
+    for (auto& state : m_states) {
+        if (!state->on_pre_gui_draw_element(gui_element, primitive_context)) {
+            any_false = true;
+        }
     }
 
-    return m_state->on_pre_gui_draw_element(gui_element, primitive_context);
+    return !any_false;
 }
 
 void ScriptRunner::on_gui_draw_element(REComponent* gui_element, void* primitive_context) {
     std::scoped_lock _{ m_access_mutex };
 
-    if (m_state == nullptr) {
-        return;
+    for (auto& state : m_states) {
+        state->on_gui_draw_element(gui_element, primitive_context);
     }
-
-    m_state->on_gui_draw_element(gui_element, primitive_context);
 }
 
 void ScriptRunner::spew_error(const std::string& p) {
@@ -876,33 +1224,23 @@ void ScriptRunner::reset_scripts() {
         m_last_script_error.clear();
     }
 
-    if (m_state != nullptr) {
-        auto& mods = g_framework->get_mods()->get_mods();
-
-        for (auto& mod : mods) {
-            mod->on_lua_state_destroyed(m_state->lua());
-        }
-
-        m_state->on_script_reset();
-    }
-
-    // We need to explicitly destroy the state before we can create a new one.
+    // We need to explicitly destroy the states before we can create new ones.
     // otherwise the destructor will be called after the new state is created.
     // this is useful in FirstPerson, where we use sdk.hook.
     // if we didn't destroy the state before creating a new one
     // the FirstPerson mod would attempt to hook an already hooked function
-    m_state.reset();
-    m_state = std::make_unique<ScriptState>(make_gc_data());
+    destroy_states();
+    bindings::reset_channels();
     m_loaded_scripts.clear();
 
-    std::string module_path{};
+    const auto isolated = m_isolate_scripts->value();
 
-    module_path.resize(1024, 0);
-    module_path.resize(GetModuleFileName(nullptr, module_path.data(), module_path.size()));
-    spdlog::info("[ScriptRunner] Module path {}", module_path);
+    if (!isolated) {
+        create_state("Shared");
+    }
 
     // Load from the reframework/autorun directory.
-    auto autorun_path = std::filesystem::path{module_path}.parent_path() / "reframework" / "autorun";
+    auto autorun_path = get_autorun_path();
 
     spdlog::info("[ScriptRunner] Creating directories {}", autorun_path.string());
     std::filesystem::create_directories(autorun_path);
@@ -912,8 +1250,70 @@ void ScriptRunner::reset_scripts() {
         auto&& path = entry.path();
 
         if (path.has_extension() && path.extension() == ".lua") {
-            m_state->run_script(path.string());
+            auto& state = isolated ? create_state(path.filename().string()) : *m_states.front();
+
+            state.run_script(path.string());
             m_loaded_scripts.emplace_back(path.filename().string());
         }
     }
+
+    apply_task_budget();
+}
+
+ScriptState& ScriptRunner::create_state(std::string name) {
+    std::scoped_lock _{ m_access_mutex };
+
+    auto& state = m_states.emplace_back(std::make_unique<ScriptState>(make_gc_data(), std::move(name)));
+    m_profiler.attach(state->lua().lua_state());
+
+    return *state;
+}
+
+void ScriptRunner::apply_task_budget() {
+    std::scoped_lock _{ m_access_mutex };
+
+    if (m_states.empty()) {
+        return;
+    }
+
+    const auto budget = std::chrono::microseconds{(uint32_t)m_task_budget->value()} / m_states.size();
+
+    for (auto& state : m_states) {
+        state->set_task_budget(budget);
+    }
+}
+
+void ScriptRunner::destroy_states() {
+    std::scoped_lock _{ m_access_mutex };
+
+    auto& mods = g_framework->get_mods()->get_mods();
+
+    for (auto& state : m_states) {
+        for (auto& mod : mods) {
+            mod->on_lua_state_destroyed(state->lua());
+        }
+
+        state->on_script_reset();
+        m_profiler.detach(state->lua().lua_state());
+    }
+
+    m_states.clear();
+}
+
+void ScriptRunner::for_each_state(const std::function<void(ScriptState&)>& fn) {
+    std::scoped_lock _{ m_access_mutex };
+
+    for (auto& state : m_states) {
+        fn(*state);
+    }
+}
+
+std::filesystem::path ScriptRunner::get_autorun_path() {
+    std::string module_path{};
+
+    module_path.resize(1024, 0);
+    module_path.resize(GetModuleFileName(nullptr, module_path.data(), module_path.size()));
+    spdlog::info("[ScriptRunner] Module path {}", module_path);
+
+    return std::filesystem::path{module_path}.parent_path() / "reframework" / "autorun";
 }
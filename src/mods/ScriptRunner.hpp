@@ -1,6 +1,9 @@
 #pragma once
 
 #include <deque>
+#include <filesystem>
+#include <functional>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 #include <memory>
@@ -19,7 +22,15 @@
 
 #include "reframework/API.hpp"
 
+#include "FrameProfiler.hpp"
 #include "HookManager.hpp"
+#include "LuaAllocator.hpp"
+#include "LuaChunkCache.hpp"
+#include "LuaTaskScheduler.hpp"
+#include "ScriptProfiler.hpp"
+
+#include "bindings/FS.hpp"
+#include "bindings/Sdk.hpp"
 
 namespace regenny {
 namespace via {
@@ -70,7 +81,7 @@ public:
         uint32_t gc_major_multiplier{100};
     };
 
-    ScriptState(const GarbageCollectionData& gc_data);
+    ScriptState(const GarbageCollectionData& gc_data, std::string name = "Shared");
     ~ScriptState();
 
     void run_script(const std::string& p);
@@ -78,36 +89,70 @@ public:
 
     void on_frame();
     void on_draw_ui();
-    void on_pre_application_entry(size_t hash);
-    void on_application_entry(size_t hash);
+    void on_pre_application_entry(size_t id);
+    void on_application_entry(size_t id, size_t hash);
+
     bool on_pre_gui_draw_element(REComponent* gui_element, void* primitive_context);
     void on_gui_draw_element(REComponent* gui_element, void* primitive_context);
     void on_script_reset();
     void on_config_save();
 
     auto& lua() { return m_lua; }
+    const auto& get_name() const { return m_name; }
     void lock() { m_execution_mutex.lock(); }
     void unlock() { m_execution_mutex.unlock(); }
     auto scoped_lock() { return std::scoped_lock{m_execution_mutex}; }
 
+    auto get_allocator_stats() const { return m_allocator.get_stats(); }
+    const auto& get_task_stats() const { return m_tasks.get_stats(); }
+    auto& get_file_requests() { return m_file_requests; }
+    auto get_sdk_caches() { return m_sdk_caches.get(); }
+    void set_task_budget(std::chrono::microseconds budget) { m_task_budget = budget; }
+    void reset_allocator_peak() { m_allocator.reset_peak(); }
+
     // add_hook enqueues the hook definition to be installed the next time install_hooks is called.
     void add_hook(sdk::REMethodDefinition* fn, sol::protected_function pre_cb, sol::protected_function post_cb, sol::object ignore_jmp_obj);
 
+    // add_observer is like add_hook, but the hook only observes calls. The callbacks are deferred and called
+    // from the Lua thread instead of from the thread that called the function, so the hook takes no locks.
+    void add_observer(sdk::REMethodDefinition* fn, sol::protected_function pre_cb, sol::protected_function post_cb, sol::object ignore_jmp_obj);
+
     // install_hooks goes through the queue of added hooks and actually creates them. The queue is emptied as a result.
     void install_hooks();
 
+    // Calls the script callbacks for this state's observer events in the batch ScriptRunner drained this frame.
+    void dispatch_observer_events();
+
     void gc_data_changed(GarbageCollectionData data);
 
 private:
-    sol::state m_lua{};
+    // Declared before m_lua so they outlive the state's lua_close.
+    LuaAllocator m_allocator{};
+    api::sdk::StateCachesPtr m_sdk_caches{api::sdk::create_state_caches()};
+    sol::state m_lua{sol::default_at_panic, &LuaAllocator::alloc, &m_allocator};
+
+    // re.spawn tasks; resumed at the end of on_frame within m_task_budget.
+    LuaTaskScheduler m_tasks{m_lua.lua_state()};
+    std::chrono::microseconds m_task_budget{1000};
+
+    // fs/json *_async requests; completions are handed to Lua at the start of on_frame.
+    bindings::AsyncFileRequests m_file_requests{};
 
+    std::string m_name{};
     GarbageCollectionData m_gc_data{};
 
     std::recursive_mutex m_execution_mutex{};
 
-    // FNV-1A
-    std::unordered_multimap<size_t, sol::protected_function> m_pre_application_entry_fns{};
-    std::unordered_multimap<size_t, sol::protected_function> m_application_entry_fns{};
+    struct ApplicationEntryFn {
+        sol::protected_function fn{};
+        FrameProfiler::ScopeId scope{FrameProfiler::INVALID_SCOPE};
+    };
+
+    void add_application_entry_fn(std::vector<std::vector<ApplicationEntryFn>>& fns, std::string_view group, const char* name, sol::function fn);
+
+    // Indexed by Hooks::get_application_entry_id
+    std::vector<std::vector<ApplicationEntryFn>> m_pre_application_entry_fns{};
+    std::vector<std::vector<ApplicationEntryFn>> m_application_entry_fns{};
 
     std::vector<sol::protected_function> m_pre_gui_draw_element_fns{};
     std::vector<sol::protected_function> m_gui_draw_element_fns{};
@@ -121,16 +166,32 @@ private:
         sol::protected_function pre_cb;
         sol::protected_function post_cb;
         sol::object ignore_jmp_obj;
+        bool observer{false};
+    };
+
+    struct ObserverDef {
+        sdk::REMethodDefinition* fn;
+        sol::protected_function pre_cb;
+        sol::protected_function post_cb;
+        sol::object script_args;
+        api::sdk::HookArgs* script_args_view;
+        std::vector<sdk::RETypeDefinition*> arg_tys;
     };
 
     std::deque<HookDef> m_hooks_to_add{};
     std::unordered_map<sdk::REMethodDefinition*, std::vector<HookManager::HookId>> m_hooks{};
+
+    // Keyed by a process-wide ID so events queued for a previous ScriptState are ignored.
+    std::unordered_map<size_t, ObserverDef> m_observers{};
+    std::vector<uintptr_t> m_observer_args{};
 };
 
 class ScriptRunner : public Mod {
 public:
     static std::shared_ptr<ScriptRunner>& get();
 
+    ~ScriptRunner() override;
+
     std::string_view get_name() const override { return "ScriptRunner"; }
     std::optional<std::string> on_initialize() override;
     void on_config_load(const utility::Config& cfg) override;
@@ -139,28 +200,35 @@ public:
     void on_frame() override;
     void on_draw_ui() override;
 
-    void on_pre_application_entry(void* entry, const char* name, size_t hash) override;
-    void on_application_entry(void* entry, const char* name, size_t hash) override;
+    std::vector<ModSubscription> get_subscriptions() const override;
+    void on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
+    void on_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
     bool on_pre_gui_draw_element(REComponent* gui_element, void* primitive_context) override;
     void on_gui_draw_element(REComponent* gui_element, void* primitive_context) override;
 
     void spew_error(const std::string& p);
 
-    const auto& get_state() {
-        return m_state;
+    // One shared state, or one per script when scripts are isolated.
+    const auto& get_states() {
+        return m_states;
     }
 
+    auto& get_chunk_cache() {
+        return m_chunk_cache;
+    }
+
+    // Always taken in this order (and released in reverse) so two lockers can't deadlock each other.
     void lock() {
         m_access_mutex.lock();
 
-        if (m_state) {
-            m_state->lock();
+        for (auto& state : m_states) {
+            state->lock();
         }
     }
 
     void unlock() {
-        if (m_state) {
-            m_state->unlock();
+        for (auto it = m_states.rbegin(); it != m_states.rend(); ++it) {
+            (*it)->unlock();
         }
 
         m_access_mutex.unlock();
@@ -180,9 +248,26 @@ private:
         return data;
     }
 
-    std::unique_ptr<ScriptState> m_state{};
+    ScriptState& create_state(std::string name);
+    void destroy_states();
+
+    // The task budget covers all scripts, so isolated states split it between them.
+    void apply_task_budget();
+
+    // Calls fn for every state, one after the other on the calling thread. Callbacks call into the game,
+    // which expects that of the thread running the entry, so isolated states aren't run in parallel.
+    void for_each_state(const std::function<void(ScriptState&)>& fn);
+
+    std::vector<std::unique_ptr<ScriptState>> m_states{};
     std::recursive_mutex m_access_mutex{};
 
+    // Declared after m_states so it unhooks the states before they're destroyed.
+    ScriptProfiler m_profiler{};
+
+    // Outlives every ScriptState, so resets reuse the bytecode compiled for the previous one.
+    LuaChunkCache m_chunk_cache{};
+    std::unique_ptr<std::thread> m_precompile_thread{};
+
     // A list of Lua files that have been explicitly loaded either through the user manually loading the script, or
     // because the script was in the autorun directory.
     std::vector<std::string> m_loaded_scripts{}; 
@@ -194,6 +279,11 @@ private:
     bool m_console_spawned{false};
     bool m_needs_first_reset{true};
     const ModToggle::Ptr m_log_to_disk{ ModToggle::create(generate_name("LogToDisk"), false) };
+    const ModToggle::Ptr m_precompile_autorun{ ModToggle::create(generate_name("PrecompileAutorun"), true) };
+
+    // Each autorun script gets its own Lua state and lock, so a slow or broken script only holds up itself.
+    // Scripts share data through the channel API. Takes effect on the next reset.
+    const ModToggle::Ptr m_isolate_scripts{ ModToggle::create(generate_name("IsolateScripts"), false) };
 
     const ModCombo::Ptr m_gc_handler { 
         ModCombo::create(generate_name("GarbageCollectionHandlerV2"),
@@ -232,17 +322,27 @@ private:
         ModSlider::create(generate_name("GarbageCollectionMajorMultiplier"), 1.0f, 1000.0f, 100.0f)
     };
 
+    // Time per frame for resuming re.spawn tasks, in microseconds.
+    const ModSlider::Ptr m_task_budget {
+        ModSlider::create(generate_name("TaskBudget"), 0.0f, 10000.0f, 1000.0f)
+    };
+
     ValueList m_options{
         *m_log_to_disk,
+        *m_precompile_autorun,
+        *m_isolate_scripts,
         *m_gc_handler,
         *m_gc_type,
         *m_gc_mode,
         *m_gc_budget,
         *m_gc_minor_multiplier,
-        *m_gc_major_multiplier
+        *m_gc_major_multiplier,
+        *m_task_budget
     };
 
     // Resets the ScriptState and runs autorun scripts again.
     void reset_scripts();
+
+    static std::filesystem::path get_autorun_path();
 };
 
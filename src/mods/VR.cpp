@@ -2505,6 +2505,18 @@ void VR::on_present() {
 void VR::on_post_present() {
 }
 
+std::vector<ModSubscription> VR::get_subscriptions() const {
+    return {
+        {ModCallback::PRE_GUI_DRAW_ELEMENT},
+        {ModCallback::GUI_DRAW_ELEMENT},
+        {ModCallback::PRE_UPDATE_BEFORE_LOCK_SCENE},
+        {ModCallback::PRE_LIGHTSHAFT_DRAW},
+        {ModCallback::LIGHTSHAFT_DRAW},
+        {ModCallback::PRE_APPLICATION_ENTRY, {"UpdateHID"_fnv, "WaitRendering"_fnv, "BeginRendering"_fnv, "EndRendering"_fnv}},
+        {ModCallback::APPLICATION_ENTRY, {"UpdateHID"_fnv, "WaitRendering"_fnv, "BeginRendering"_fnv, "EndRendering"_fnv}},
+    };
+}
+
 void VR::on_update_transform(RETransform* transform) {
     
 }
@@ -3371,7 +3383,7 @@ void VR::on_wait_rendering(void* entry) {
     }
 }
 
-void VR::on_pre_application_entry(void* entry, const char* name, size_t hash) {
+void VR::on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     if (!get_runtime()->loaded) {
         return;
     }
@@ -3394,7 +3406,7 @@ void VR::on_pre_application_entry(void* entry, const char* name, size_t hash) {
     }
 }
 
-void VR::on_application_entry(void* entry, const char* name, size_t hash) {
+void VR::on_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     if (!get_runtime()->loaded) {
         return;
     }
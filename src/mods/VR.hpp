@@ -40,6 +40,7 @@ public:
     void on_pre_imgui_frame() override;
     void on_present() override;
     void on_post_present() override;
+    std::vector<ModSubscription> get_subscriptions() const override;
     void on_update_transform(RETransform* transform) override;
     void on_update_camera_controller(RopewayPlayerCameraController* controller) override;
     bool on_pre_gui_draw_element(REComponent* gui_element, void* primitive_context) override;
@@ -48,8 +49,8 @@ public:
     void on_pre_lightshaft_draw(void* shaft, void* render_context) override;
     void on_lightshaft_draw(void* shaft, void* render_context) override;
 
-    void on_pre_application_entry(void* entry, const char* name, size_t hash) override;
-    void on_application_entry(void* entry, const char* name, size_t hash) override;
+    void on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
+    void on_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
 
     void on_draw_ui() override;
     void on_device_reset() override;
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "ValueTypeStorage.hpp"
+
+namespace detail {
+// Power of two size classes from 128 bytes to 4KB; anything bigger is rare enough to go straight to malloc.
+constexpr size_t MIN_CLASS_SHIFT = 7;
+constexpr size_t MAX_CLASS_SHIFT = 12;
+constexpr size_t NUM_CLASSES = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+
+// How many free blocks each class keeps around before handing them back to the heap.
+constexpr size_t MAX_FREE_PER_CLASS = 256;
+
+class Pool {
+public:
+    uint8_t* acquire(size_t size, size_t& capacity) {
+        const auto shift = std::max<size_t>(std::bit_width(size - 1), MIN_CLASS_SHIFT);
+
+        if (shift > MAX_CLASS_SHIFT) {
+            capacity = size;
+            return (uint8_t*)malloc(size);
+        }
+
+        capacity = size_t{1} << shift;
+
+        {
+            std::scoped_lock _{m_mtx};
+            ++m_live;
+
+            auto& free_list = m_free[shift - MIN_CLASS_SHIFT];
+
+            if (!free_list.empty()) {
+                auto block = free_list.back();
+                free_list.pop_back();
+                return block;
+            }
+        }
+
+        return (uint8_t*)malloc(capacity);
+    }
+
+    void release(uint8_t* block, size_t capacity) {
+        if (capacity > (size_t{1} << MAX_CLASS_SHIFT)) {
+            free(block);
+            return;
+        }
+
+        {
+            std::scoped_lock _{m_mtx};
+            --m_live;
+
+            auto& free_list = m_free[std::bit_width(capacity - 1) - MIN_CLASS_SHIFT];
+
+            if (free_list.size() < MAX_FREE_PER_CLASS) {
+                free_list.push_back(block);
+                return;
+            }
+        }
+
+        free(block);
+    }
+
+    ValueTypeStorage::Stats get_stats() {
+        std::scoped_lock _{m_mtx};
+
+        ValueTypeStorage::Stats out{};
+        out.live_blocks = m_live;
+
+        for (const auto& free_list : m_free) {
+            out.pooled_blocks += free_list.size();
+        }
+
+        return out;
+    }
+
+private:
+    std::mutex m_mtx{};
+    std::array<std::vector<uint8_t*>, NUM_CLASSES> m_free{};
+    size_t m_live{};
+};
+
+// Never destroyed; ValueTypes can still be released by Lua states that are closed during shutdown.
+Pool& get_pool() {
+    static auto pool = new Pool{};
+    return *pool;
+}
+}
+
+ValueTypeStorage::ValueTypeStorage(const ValueTypeStorage& other) {
+    assign(other.data(), other.size());
+}
+
+ValueTypeStorage::ValueTypeStorage(ValueTypeStorage&& other) noexcept {
+    *this = std::move(other);
+}
+
+ValueTypeStorage& ValueTypeStorage::operator=(const ValueTypeStorage& other) {
+    if (this != &other) {
+        assign(other.data(), other.size());
+    }
+
+    return *this;
+}
+
+ValueTypeStorage& ValueTypeStorage::operator=(ValueTypeStorage&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    release();
+
+    if (other.m_heap != nullptr) {
+        m_heap = std::exchange(other.m_heap, nullptr);
+        m_capacity = std::exchange(other.m_capacity, 0);
+    } else {
+        memcpy(m_inline, other.m_inline, other.m_size);
+    }
+
+    m_size = std::exchange(other.m_size, 0);
+
+    return *this;
+}
+
+ValueTypeStorage::~ValueTypeStorage() {
+    release();
+}
+
+void ValueTypeStorage::resize(size_t size) {
+    if (size > INLINE_SIZE && size > m_capacity) {
+        release();
+        m_heap = detail::get_pool().acquire(size, m_capacity);
+    } else if (size <= INLINE_SIZE) {
+        release();
+    }
+
+    m_size = size;
+    memset(data(), 0, size);
+}
+
+void ValueTypeStorage::assign(const void* src, size_t size) {
+    resize(size);
+
+    if (src != nullptr && size > 0) {
+        memcpy(data(), src, size);
+    }
+}
+
+ValueTypeStorage::Stats ValueTypeStorage::get_stats() {
+    return detail::get_pool().get_stats();
+}
+
+void ValueTypeStorage::release() {
+    if (m_heap != nullptr) {
+        detail::get_pool().release(m_heap, m_capacity);
+        m_heap = nullptr;
+        m_capacity = 0;
+    }
+
+    m_size = 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// The bytes behind a script ValueType.
+//
+// Payloads up to INLINE_SIZE bytes (vectors, quaternions, a 4x4 matrix, most small structs) are stored in the object
+// itself. sol constructs usertypes inside their Lua userdata, so those cost no allocation besides the userdata.
+// Bigger payloads come from per size class free lists that are refilled by destroyed ValueTypes.
+//
+// Looks enough like a std::vector<uint8_t> (data/size/resize, begin/end, operator[]) that sol still exposes it
+// to scripts as an indexable container, the way ValueType.data used to be.
+class ValueTypeStorage {
+public:
+    static constexpr size_t INLINE_SIZE = 64;
+
+    using value_type = uint8_t;
+    using iterator = uint8_t*;
+    using const_iterator = const uint8_t*;
+    using size_type = size_t;
+
+    ValueTypeStorage() = default;
+    ValueTypeStorage(const ValueTypeStorage& other);
+    ValueTypeStorage(ValueTypeStorage&& other) noexcept;
+    ValueTypeStorage& operator=(const ValueTypeStorage& other);
+    ValueTypeStorage& operator=(ValueTypeStorage&& other) noexcept;
+    ~ValueTypeStorage();
+
+    // Zero fills; the old contents aren't kept.
+    void resize(size_t size);
+    void assign(const void* src, size_t size);
+
+    uint8_t* data() { return m_heap != nullptr ? m_heap : m_inline; }
+    const uint8_t* data() const { return m_heap != nullptr ? m_heap : m_inline; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + m_size; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + m_size; }
+
+    uint8_t& operator[](size_t i) { return data()[i]; }
+    const uint8_t& operator[](size_t i) const { return data()[i]; }
+
+    struct Stats {
+        size_t pooled_blocks{}; // sitting in the free lists
+        size_t live_blocks{};   // handed out
+    };
+
+    static Stats get_stats();
+
+private:
+    void release();
+
+    alignas(16) uint8_t m_inline[INLINE_SIZE]{};
+    uint8_t* m_heap{nullptr};
+    size_t m_size{0};
+    size_t m_capacity{0}; // of m_heap
+};
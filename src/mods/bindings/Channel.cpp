@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../ScriptRunner.hpp"
+
+#include "Channel.hpp"
+
+// Scripts in isolated states can't see each other's globals, so this is how they share data.
+// Values are packed into a byte string on the way in and rebuilt in the receiving state on the way out,
+// which limits them to nil, booleans, numbers, strings and tables of those.
+// Strings are copied byte for byte, so binary data makes it across too, which JSON text can't carry.
+namespace api::channel {
+namespace detail {
+std::mutex g_mtx{};
+std::unordered_map<std::string, std::deque<std::string>> g_queues{};
+std::unordered_map<std::string, std::string> g_values{};
+
+// Deep enough for any sane value, shallow enough to catch a table that contains itself.
+constexpr int MAX_DEPTH = 256;
+
+enum class Tag : uint8_t {
+    NIL,
+    BOOLEAN,
+    INTEGER,
+    FLOAT,
+    STRING,
+    TABLE,
+};
+
+template <typename T>
+void put(std::string& out, const T& v) {
+    out.append((const char*)&v, sizeof(T));
+}
+
+bool is_packable(int type) {
+    switch (type) {
+    case LUA_TNIL:
+    case LUA_TBOOLEAN:
+    case LUA_TNUMBER:
+    case LUA_TSTRING:
+    case LUA_TTABLE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void pack(lua_State* l, int index, std::string& out, int depth) {
+    switch (lua_type(l, index)) {
+    case LUA_TBOOLEAN:
+        put(out, Tag::BOOLEAN);
+        put(out, (uint8_t)lua_toboolean(l, index));
+        break;
+    case LUA_TNUMBER:
+        if (lua_isinteger(l, index)) {
+            put(out, Tag::INTEGER);
+            put(out, lua_tointeger(l, index));
+        } else {
+            put(out, Tag::FLOAT);
+            put(out, lua_tonumber(l, index));
+        }
+        break;
+    case LUA_TSTRING: {
+        size_t len{};
+        const auto s = lua_tolstring(l, index, &len);
+        put(out, Tag::STRING);
+        put(out, len);
+        out.append(s, len);
+        break;
+    }
+    case LUA_TTABLE: {
+        if (depth >= MAX_DEPTH) {
+            throw std::runtime_error{"table is nested too deeply (or contains itself)"};
+        }
+
+        luaL_checkstack(l, 3, "channel pack");
+
+        // Sized after the fact, once we know how many pairs made it in.
+        put(out, Tag::TABLE);
+        put(out, (uint32_t)lua_rawlen(l, index));
+        const auto count_at = out.size();
+        put(out, uint32_t{});
+
+        uint32_t count{};
+
+        lua_pushnil(l);
+
+        while (lua_next(l, index) != 0) {
+            // Functions, userdata and threads can't leave their state; skip pairs that involve one.
+            if (is_packable(lua_type(l, -2)) && is_packable(lua_type(l, -1))) {
+                pack(l, lua_absindex(l, -2), out, depth + 1);
+                pack(l, lua_absindex(l, -1), out, depth + 1);
+                ++count;
+            }
+
+            lua_pop(l, 1);
+        }
+
+        std::memcpy(out.data() + count_at, &count, sizeof(count));
+        break;
+    }
+    default:
+        put(out, Tag::NIL);
+        break;
+    }
+}
+
+class Unpacker {
+public:
+    Unpacker(lua_State* l, std::string_view data)
+        : m_l{l},
+        m_data{data}
+    {
+    }
+
+    // Pushes the value at the current position.
+    void value() {
+        luaL_checkstack(m_l, 3, "channel unpack");
+
+        switch (get<Tag>()) {
+        case Tag::NIL:
+            lua_pushnil(m_l);
+            break;
+        case Tag::BOOLEAN:
+            lua_pushboolean(m_l, get<uint8_t>());
+            break;
+        case Tag::INTEGER:
+            lua_pushinteger(m_l, get<lua_Integer>());
+            break;
+        case Tag::FLOAT:
+            lua_pushnumber(m_l, get<lua_Number>());
+            break;
+        case Tag::STRING: {
+            const auto len = get<size_t>();
+            lua_pushlstring(m_l, take(len), len);
+            break;
+        }
+        case Tag::TABLE: {
+            const auto narr = get<uint32_t>();
+            const auto count = get<uint32_t>();
+
+            lua_createtable(m_l, (int)std::min(narr, count), (int)(count - std::min(narr, count)));
+
+            for (uint32_t i = 0; i < count; ++i) {
+                value();
+                value();
+                lua_rawset(m_l, -3);
+            }
+
+            break;
+        }
+        default:
+            throw std::runtime_error{"corrupt channel value"};
+        }
+    }
+
+private:
+    const char* take(size_t n) {
+        if (n > m_data.size() - m_pos) {
+            throw std::runtime_error{"corrupt channel value"};
+        }
+
+        const auto p = m_data.data() + m_pos;
+        m_pos += n;
+        return p;
+    }
+
+    template <typename T>
+    T get() {
+        T v{};
+        std::memcpy(&v, take(sizeof(T)), sizeof(T));
+        return v;
+    }
+
+    lua_State* m_l;
+    std::string_view m_data;
+    size_t m_pos{};
+};
+
+std::string encode(sol::object value) {
+    std::string out{};
+    auto l = value.lua_state();
+
+    if (l == nullptr) {
+        put(out, Tag::NIL);
+        return out;
+    }
+
+    const auto top = lua_gettop(l);
+    value.push();
+
+    try {
+        pack(l, lua_absindex(l, -1), out, 0);
+    } catch (...) {
+        lua_settop(l, top);
+        throw;
+    }
+
+    lua_settop(l, top);
+    return out;
+}
+
+sol::object decode(sol::this_state l, const std::string& data) {
+    const auto top = lua_gettop(l);
+
+    try {
+        Unpacker{l, data}.value();
+    } catch (...) {
+        lua_settop(l, top);
+        throw;
+    }
+
+    return sol::stack::pop<sol::object>(l);
+}
+}
+
+void send(const std::string& name, sol::object value) {
+    auto text = detail::encode(value);
+
+    std::scoped_lock _{detail::g_mtx};
+    detail::g_queues[name].emplace_back(std::move(text));
+}
+
+sol::object receive(sol::this_state l, const std::string& name) {
+    std::string text{};
+
+    {
+        std::scoped_lock _{detail::g_mtx};
+
+        auto it = detail::g_queues.find(name);
+
+        if (it == detail::g_queues.end() || it->second.empty()) {
+            return sol::make_object(l, sol::nil);
+        }
+
+        text = std::move(it->second.front());
+        it->second.pop_front();
+    }
+
+    return detail::decode(l, text);
+}
+
+size_t count(const std::string& name) {
+    std::scoped_lock _{detail::g_mtx};
+
+    auto it = detail::g_queues.find(name);
+    return it != detail::g_queues.end() ? it->second.size() : 0;
+}
+
+void set(const std::string& key, sol::object value) {
+    if (value.get_type() == sol::type::nil) {
+        std::scoped_lock _{detail::g_mtx};
+        detail::g_values.erase(key);
+        return;
+    }
+
+    auto text = detail::encode(value);
+
+    std::scoped_lock _{detail::g_mtx};
+    detail::g_values[key] = std::move(text);
+}
+
+sol::object get(sol::this_state l, const std::string& key) {
+    std::string text{};
+
+    {
+        std::scoped_lock _{detail::g_mtx};
+
+        auto it = detail::g_values.find(key);
+
+        if (it == detail::g_values.end()) {
+            return sol::make_object(l, sol::nil);
+        }
+
+        text = it->second;
+    }
+
+    return detail::decode(l, text);
+}
+} // namespace api::channel
+
+void bindings::reset_channels() {
+    std::scoped_lock _{api::channel::detail::g_mtx};
+
+    api::channel::detail::g_queues.clear();
+    api::channel::detail::g_values.clear();
+}
+
+void bindings::open_channel(ScriptState* s) {
+    auto& lua = s->lua();
+    auto channel = lua.create_table();
+
+    channel["send"] = api::channel::send;
+    channel["receive"] = api::channel::receive;
+    channel["count"] = api::channel::count;
+    channel["set"] = api::channel::set;
+    channel["get"] = api::channel::get;
+    lua["channel"] = channel;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+class ScriptState;
+
+namespace bindings {
+void open_channel(ScriptState* s);
+
+// Drops every queued message and shared value. Called when scripts are reset.
+void reset_channels();
+}
@@ -1,10 +1,14 @@
+#include <atomic>
+#include <cctype>
 #include <filesystem>
 #include <regex>
 #include <fstream>
 #include <filesystem>
+#include <iterator>
 
 #include "../ScriptRunner.hpp"
 
+#include "Json.hpp"
 #include "FS.hpp"
 
 namespace fs = std::filesystem;
@@ -52,27 +56,170 @@ namespace detail {
 
     return out;
 }
-}
 
-sol::table glob(sol::this_state l, const char* filter) {
-    sol::state_view state{l};
-    std::regex filter_regex{filter};
-    auto results = state.create_table();
-    auto datadir = detail::get_datadir();
-    auto i = 0;
+// The file list behind fs.glob. It's only walked again after a change notification for the data directory
+// (or a write through fs.write), and each filter's matches are kept until then, so polling for new files is cheap.
+class DirectoryIndex {
+public:
+    using Matches = std::shared_ptr<const std::vector<std::string>>;
 
-    for (const auto& entry : ::fs::recursive_directory_iterator{datadir}) {
-        if (!entry.is_regular_file()) {
-            continue;
+    ~DirectoryIndex() {
+        close_notification();
+    }
+
+    Matches glob(const ::fs::path& dir, const std::string& filter) {
+        std::scoped_lock _{m_mtx};
+
+        refresh(dir);
+
+        auto it = m_filters.find(filter);
+
+        if (it == m_filters.end()) {
+            // Scripts usually glob a handful of fixed filters; anything beyond that is probably built on the fly.
+            if (m_filters.size() >= MAX_FILTERS) {
+                m_filters.clear();
+            }
+
+            it = m_filters.emplace(filter, Filter{compile(filter)}).first;
+        }
+
+        auto& cached = it->second;
+
+        if (cached.matches == nullptr || cached.generation != m_generation) {
+            auto matches = std::make_shared<std::vector<std::string>>();
+
+            for (const auto& relpath : m_files) {
+                if (cached.pattern.matches(relpath)) {
+                    matches->push_back(relpath);
+                }
+            }
+
+            cached.matches = std::move(matches);
+            cached.generation = m_generation;
+        }
+
+        return cached.matches;
+    }
+
+    void invalidate() {
+        m_dirty = true;
+    }
+
+private:
+    static constexpr size_t MAX_FILTERS = 64;
+
+    // Filters of the form literal, or literal.*literal (with escaped metacharacters) skip std::regex entirely.
+    struct Pattern {
+        std::optional<std::regex> regex{};
+        std::string prefix{};
+        std::string suffix{};
+        bool wildcard{false};
+
+        bool matches(const std::string& s) const {
+            if (regex) {
+                return std::regex_match(s, *regex);
+            }
+
+            if (!wildcard) {
+                return s == prefix;
+            }
+
+            return s.size() >= prefix.size() + suffix.size() && s.starts_with(prefix) && s.ends_with(suffix);
+        }
+    };
+
+    struct Filter {
+        Pattern pattern{};
+        uint64_t generation{};
+        Matches matches{};
+    };
+
+    static Pattern compile(const std::string& filter) {
+        Pattern out{};
+        std::string* literal = &out.prefix;
+
+        for (size_t i = 0; i < filter.size(); ++i) {
+            const auto c = filter[i];
+
+            if (c == '\\' && i + 1 < filter.size() && !std::isalnum((unsigned char)filter[i + 1])) {
+                *literal += filter[++i];
+            } else if (c == '.' && i + 1 < filter.size() && filter[i + 1] == '*' && !out.wildcard) {
+                out.wildcard = true;
+                literal = &out.suffix;
+                ++i;
+            } else if (std::string_view{"\\.*+?^$()[]{}|"}.find(c) != std::string_view::npos) {
+                out.regex = std::regex{filter};
+                return out;
+            } else {
+                *literal += c;
+            }
+        }
+
+        return out;
+    }
+
+    void refresh(const ::fs::path& dir) {
+        if (dir != m_dir) {
+            close_notification();
+            m_dir = dir;
+            m_dirty = true;
+        }
+
+        if (m_notification == INVALID_HANDLE_VALUE) {
+            m_notification = FindFirstChangeNotificationW(dir.c_str(), TRUE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME);
+        }
+
+        // Re-armed before the walk, so anything that changes during it is caught next time.
+        if (m_notification == INVALID_HANDLE_VALUE) {
+            m_dirty = true; // no watcher, so walk every time like before
+        } else if (WaitForSingleObject(m_notification, 0) == WAIT_OBJECT_0) {
+            m_dirty = true;
+            FindNextChangeNotification(m_notification);
+        }
+
+        if (!m_dirty.exchange(false)) {
+            return;
+        }
+
+        m_files.clear();
+
+        for (const auto& entry : ::fs::recursive_directory_iterator{dir}) {
+            if (entry.is_regular_file()) {
+                m_files.push_back(relative(entry.path(), dir).string());
+            }
         }
 
-        auto relpath = relative(entry.path(), datadir).string();
+        ++m_generation;
+    }
 
-        if (std::regex_match(relpath, filter_regex)) {
-            results[++i] = relpath;
+    void close_notification() {
+        if (m_notification != INVALID_HANDLE_VALUE) {
+            FindCloseChangeNotification(m_notification);
+            m_notification = INVALID_HANDLE_VALUE;
         }
     }
 
+    std::mutex m_mtx{};
+    std::atomic<bool> m_dirty{true};
+    HANDLE m_notification{INVALID_HANDLE_VALUE};
+    ::fs::path m_dir{};
+    std::vector<std::string> m_files{};
+    uint64_t m_generation{};
+    std::unordered_map<std::string, Filter> m_filters{};
+};
+
+DirectoryIndex g_index{};
+}
+
+sol::table glob(sol::this_state l, const std::string& filter) {
+    sol::state_view state{l};
+    const auto matches = detail::g_index.glob(detail::get_datadir(), filter);
+    auto results = state.create_table(matches->size(), 0);
+
+    for (size_t i = 0; i < matches->size(); ++i) {
+        results[i + 1] = (*matches)[i];
+    }
+
     return results;
 }
 
@@ -97,11 +244,17 @@ void write(sol::this_state l, const std::string& filepath, const std::string& da
 
     auto path = detail::get_datadir(filepath) / corrected_subpath;
 
+    // Otherwise an older write_async to the same file could land on top of this one.
+    g_file_worker.cancel_pending_write(path);
+
     ::fs::create_directories(path.parent_path());
 
     std::ofstream file{path};
 
     file << data;
+
+    // The change notification would catch this too, but not necessarily before the script's next glob.
+    detail::g_index.invalidate();
 }
 
 std::string read(sol::this_state l, const std::string& filepath) {
@@ -125,16 +278,18 @@ std::string read(sol::this_state l, const std::string& filepath) {
 
     auto path = detail::get_datadir(filepath) / corrected_subpath;
 
-    if (!exists(path)) {
-        return "";
+    // A write_async that hasn't landed yet is what the file is about to contain.
+    if (auto pending = g_file_worker.get_pending_write(path)) {
+        return *pending;
     }
 
-    ::fs::create_directories(path.parent_path());
-
     std::ifstream file{path};
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+
+    if (!file) {
+        return "";
+    }
+
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
 }
 }
 
@@ -168,6 +323,141 @@ std::optional<::fs::path> get_correct_subpath(sol::this_state l, const std::stri
     return api::fs::detail::get_datadir(filepath) / corrected_subpath;
 }
 
+namespace api::fs {
+using Request = bindings::AsyncFileRequests::Request;
+
+namespace detail {
+bindings::AsyncFileRequests& get_requests(lua_State* l) {
+    return sol::state_view{l}.registry()["state"].get<ScriptState*>()->get_file_requests();
+}
+
+int await_continue(lua_State* l, int status, lua_KContext ctx);
+
+int await(lua_State* l) {
+    auto req = sol::stack::check_get<Request*>(l, 1);
+
+    if (!req || *req == nullptr) {
+        return luaL_argerror(l, 1, "expected a request returned by an *_async function");
+    }
+
+    if (!(*req)->done) {
+        if (!lua_isyieldable(l)) {
+            return luaL_error(l, "fs.await: the request isn't done yet; await it from a re.spawn task or poll is_done()");
+        }
+
+        // Checked again every time the task is resumed, which is once per frame.
+        lua_settop(l, 1);
+        return lua_yieldk(l, 0, 0, &await_continue);
+    }
+
+    (*req)->result.push(l);
+
+    if ((*req)->error.empty()) {
+        lua_pushnil(l);
+    } else {
+        lua_pushstring(l, (*req)->error.c_str());
+    }
+
+    return 2;
+}
+
+int await_continue(lua_State* l, int, lua_KContext) {
+    return await(l);
+}
+}
+
+std::shared_ptr<Request> read_async(sol::this_state l, const std::string& filepath, sol::object callback) {
+    auto path = get_correct_subpath(l, filepath);
+    auto [req, on_done] = detail::get_requests(l).create(bindings::AsyncFileRequests::Kind::TEXT, callback);
+
+    g_file_worker.read(std::move(*path), false, std::move(on_done));
+
+    return req;
+}
+
+std::shared_ptr<Request> write_async(sol::this_state l, const std::string& filepath, std::string data, sol::object callback) {
+    auto path = get_correct_subpath(l, filepath);
+    auto [req, on_done] = detail::get_requests(l).create(bindings::AsyncFileRequests::Kind::WRITE, callback);
+
+    g_file_worker.write(std::move(*path), std::move(data), false, std::move(on_done));
+
+    return req;
+}
+}
+
+std::pair<std::shared_ptr<bindings::AsyncFileRequests::Request>, FileWorker::Completion>
+bindings::AsyncFileRequests::create(Kind kind, sol::object callback) {
+    auto req = std::make_shared<Request>();
+    req->kind = kind;
+
+    if (callback.is<sol::protected_function>()) {
+        req->callback = callback.as<sol::protected_function>();
+    }
+
+    const auto id = m_next_id++;
+    m_requests[id] = req;
+
+    // Only the mailbox is shared with the worker, and only weakly; a state that's gone just drops the result.
+    FileWorker::Completion on_done = [mailbox = std::weak_ptr{m_mailbox}, id](bool ok, std::string data, std::string error) {
+        if (auto m = mailbox.lock()) {
+            std::scoped_lock _{m->mtx};
+            m->completed.push_back({id, ok, std::move(data), std::move(error)});
+        }
+    };
+
+    return {std::move(req), std::move(on_done)};
+}
+
+void bindings::AsyncFileRequests::dispatch(lua_State* l) {
+    std::vector<Completed> completed{};
+
+    {
+        std::scoped_lock _{m_mailbox->mtx};
+
+        if (m_mailbox->completed.empty()) {
+            return;
+        }
+
+        completed.swap(m_mailbox->completed);
+    }
+
+    for (auto& c : completed) {
+        auto it = m_requests.find(c.id);
+
+        if (it == m_requests.end()) {
+            continue;
+        }
+
+        auto req = std::move(it->second);
+        m_requests.erase(it);
+
+        if (!c.ok) {
+            req->error = std::move(c.error);
+        } else if (req->kind == Kind::WRITE) {
+            req->result = sol::make_object(l, true);
+        } else if (req->kind == Kind::JSON) {
+            if (auto result = api::json::detail::decode(l, c.data, &req->error)) {
+                req->result = std::move(*result);
+            }
+        } else {
+            req->result = sol::make_object(l, std::move(c.data));
+        }
+
+        req->done = true;
+
+        if (req->callback.valid()) {
+            auto callback = std::move(req->callback);
+            auto result = req->error.empty() ? callback(req->result) : callback(req->result, req->error);
+
+            // Reported rather than thrown so one bad callback doesn't swallow the other completions.
+            if (!result.valid()) {
+                sol::error e = result;
+                ScriptRunner::get()->spew_error(e.what());
+            }
+        }
+    }
+}
+
 void bindings::open_fs(ScriptState* s) {
     auto& lua = s->lua();
     auto fs = lua.create_table();
@@ -175,8 +465,19 @@ void bindings::open_fs(ScriptState* s) {
     fs["glob"] = api::fs::glob;
     fs["write"] = api::fs::write;
     fs["read"] = api::fs::read;
+    fs["read_async"] = api::fs::read_async;
+    fs["write_async"] = api::fs::write_async;
+    fs["await"] = static_cast<lua_CFunction>(&api::fs::detail::await);
     lua["fs"] = fs;
 
+    lua.new_usertype<api::fs::Request>("FileRequest",
+        "is_done", [](api::fs::Request& req) { return req.done; },
+        "get_result", [](api::fs::Request& req) { return req.result; },
+        "get_error", [](sol::this_state l, api::fs::Request& req) -> sol::object {
+            return req.error.empty() ? sol::make_object(l, sol::nil) : sol::make_object(l, req.error);
+        }
+    );
+
     lua.open_libraries(sol::lib::io);
 
     // Replace the io functions with safe versions that can't be used to access parent directories and can't be used to open files outside of the data directory.
@@ -1,7 +1,69 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sol/sol.hpp>
+
+#include "../FileWorker.hpp"
+
 class ScriptState;
 
 namespace bindings {
 void open_fs(ScriptState* s);
+
+// The fs/json *_async requests of one script state.
+// Results come back from the FileWorker thread into a mailbox, and dispatch hands them to Lua on the state's own thread.
+class AsyncFileRequests {
+public:
+    // What a successful request resolves to: the file's text, the file decoded as JSON, or true for a write.
+    enum class Kind : uint8_t {
+        TEXT,
+        JSON,
+        WRITE,
+    };
+
+    struct Request {
+        Kind kind{Kind::TEXT};
+        bool done{false};
+        sol::object result{};
+        std::string error{};
+        sol::protected_function callback{};
+    };
+
+    AsyncFileRequests() = default;
+    AsyncFileRequests(const AsyncFileRequests&) = delete;
+    AsyncFileRequests& operator=(const AsyncFileRequests&) = delete;
+
+    // Creates a pending request. The returned completion is what gets passed to g_file_worker.
+    std::pair<std::shared_ptr<Request>, FileWorker::Completion> create(Kind kind, sol::object callback);
+
+    // Resolves whatever finished since the last call and runs the callbacks. Called with the state locked.
+    void dispatch(lua_State* l);
+
+    size_t get_num_pending() const {
+        return m_requests.size();
+    }
+
+private:
+    struct Completed {
+        uint64_t id{};
+        bool ok{};
+        std::string data{};
+        std::string error{};
+    };
+
+    struct Mailbox {
+        std::mutex mtx{};
+        std::vector<Completed> completed{};
+    };
+
+    std::shared_ptr<Mailbox> m_mailbox{std::make_shared<Mailbox>()};
+    std::unordered_map<uint64_t, std::shared_ptr<Request>> m_requests{};
+    uint64_t m_next_id{1};
+};
 }
@@ -1,6 +1,9 @@
+#include <cmath>
+
 #include <imgui.h>
 
 #include "../ScriptRunner.hpp"
+#include "sdk/Renderer.hpp"
 #include "sdk/SceneManager.hpp"
 #include "REFramework.hpp"
 #include "utility/ImGui.hpp"
@@ -1283,89 +1286,86 @@ ImGuiTableSortSpecs* table_get_sort_specs() {
 } // namespace api::imgui
 
 namespace api::draw {
-std::optional<Vector2f> world_to_screen(sol::object world_pos_object) {
-    auto scene = sdk::get_current_scene();
-
-    if (scene == nullptr) {
-        return std::nullopt;
+namespace detail {
+std::optional<Vector3f> to_world_pos(const sol::object& obj) {
+    if (obj.is<Vector3f>()) {
+        return obj.as<Vector3f>();
     }
 
-    auto context = sdk::get_thread_context();
-
-    static auto scene_def = sdk::find_type_definition("via.Scene");
-    auto first_transform = sdk::call_native_func_easy<RETransform*>(scene, scene_def, "get_FirstTransform");
-
-    if (first_transform == nullptr) {
-        return std::nullopt;
+    if (obj.is<Vector4f>()) {
+        const auto& v4f = obj.as<Vector4f&>();
+        return Vector3f{v4f.x, v4f.y, v4f.z};
     }
 
-    if (world_pos_object.is<sol::nil_t>()) {
-        return std::nullopt;
+    if (obj.is<Vector2f>()) {
+        const auto& v2f = obj.as<Vector2f&>();
+        return Vector3f{v2f.x, v2f.y, 0.0f};
     }
 
-    Vector4f world_pos{};
+    return std::nullopt;
+}
+}
 
-    if (world_pos_object.is<Vector2f>()) {
-        auto& v2f = world_pos_object.as<Vector2f&>();
-        world_pos = Vector4f{v2f.x, v2f.y, 0.0f, 1.0f};
-    } else if (world_pos_object.is<Vector3f>()) {
-        auto& v3f = world_pos_object.as<Vector3f&>();
-        world_pos = Vector4f{v3f.x, v3f.y, v3f.z, 1.0f};
-    } else if (world_pos_object.is<Vector4f>()) {
-        auto& v4f = world_pos_object.as<Vector4f&>();
-        world_pos = Vector4f{v4f.x, v4f.y, v4f.z, v4f.w};
-    } else {
+std::optional<Vector2f> world_to_screen(sol::object world_pos_object) {
+    const auto world_pos = detail::to_world_pos(world_pos_object);
+
+    if (!world_pos) {
         return std::nullopt;
     }
 
-    static auto transform_def = utility::re_managed_object::get_type_definition(first_transform);
-    static auto next_transform_method = transform_def->get_method("get_Next");
-    static auto get_gameobject_method = transform_def->get_method("get_GameObject");
-    static auto get_position_method = transform_def->get_method("get_Position");
-    static auto get_axisz_method = transform_def->get_method("get_AxisZ");
-    static auto math_t = sdk::find_type_definition("via.math");
+    return sdk::renderer::world_to_screen(*world_pos);
+}
 
-    auto camera = sdk::get_primary_camera();
+// Projects a whole table of positions with one camera read. Entries that have no screen position (behind the camera,
+// or not a vector) come back as false. Vector2f entries already in out are overwritten in place, so passing the
+// same table every frame doesn't allocate.
+sol::table world_to_screen_batch(sol::this_state l, sol::table points, sol::object out_obj) {
+    const auto count = points.size();
+    auto out = out_obj.is<sol::table>() ? out_obj.as<sol::table>() : sol::state_view{l}.create_table(count, 0);
 
-    if (camera == nullptr) {
-        return std::nullopt;
-    }
-
-    auto main_view = sdk::get_main_view();
+    // Per thread, since isolated script states can draw from worker threads.
+    thread_local std::vector<Vector3f> world_pos{};
+    thread_local std::vector<Vector2f> screen_pos{};
+    thread_local std::vector<uint8_t> valid{};
 
-    if (main_view == nullptr) {
-        return std::nullopt;
-    }
+    world_pos.resize(count);
+    screen_pos.resize(count);
+    valid.resize(count);
 
-    auto camera_gameobject = get_gameobject_method->call<REGameObject*>(context, camera);
-    auto camera_transform = camera_gameobject->transform;
+    for (size_t i = 0; i < count; ++i) {
+        const auto pos = detail::to_world_pos(points[i + 1]);
 
-    Vector4f camera_origin{};
-    get_position_method->call<void*>(&camera_origin, context, camera_transform);
+        valid[i] = pos.has_value();
+        world_pos[i] = pos.value_or(Vector3f{});
+    }
 
-    Vector4f camera_forward{};
-    get_axisz_method->call<void*>(&camera_forward, context, camera_transform);
+    const auto camera = sdk::renderer::get_camera_snapshot();
 
-    // Translate 2d position to 3d position (screen to world)
-    Matrix4x4f proj{}, view{};
-    float screen_size[2]{};
-    sdk::call_object_func<void*>(camera, "get_ProjectionMatrix", &proj, context, camera);
-    sdk::call_object_func<void*>(camera, "get_ViewMatrix", &view, context, camera);
-    sdk::call_object_func<void*>(main_view, "get_Size", &screen_size, context, main_view);
+    if (camera) {
+        sdk::renderer::world_to_screen(*camera, world_pos.data(), count, screen_pos.data(), nullptr);
+    }
 
-    Vector4f screen_pos{};
+    for (size_t i = 0; i < count; ++i) {
+        if (!camera || !valid[i] || std::isnan(screen_pos[i].x)) {
+            out[i + 1] = false;
+            continue;
+        }
 
-    const auto delta = world_pos - camera_origin;
+        sol::object existing = out[i + 1];
 
-    // behind camera
-    if (glm::dot(delta, -camera_forward) <= 0.0f) {
-        return std::nullopt;
+        if (existing.is<Vector2f>()) {
+            existing.as<Vector2f&>() = screen_pos[i];
+        } else {
+            out[i + 1] = screen_pos[i];
+        }
     }
 
-    static auto world_to_screen_method = math_t->get_method("worldPos2ScreenPos(via.vec3, via.mat4, via.mat4, via.Size)"); // there are 2 of them.
-    world_to_screen_method->call<void*>(&screen_pos, context, &world_pos, &view, &proj, &screen_size);
+    // A reused table may still hold results from a longer batch.
+    for (auto i = out.size(); i > count; --i) {
+        out[i] = sol::nil;
+    }
 
-    return Vector2f{screen_pos.x, screen_pos.y};
+    return out;
 }
 
 void world_text(const char* text, sol::object world_pos_object, ImU32 color = 0xFFFFFFFF) {
@@ -1731,6 +1731,7 @@ void bindings::open_imgui(ScriptState* s) {
     auto draw = lua.create_table();
 
     draw["world_to_screen"] = api::draw::world_to_screen;
+    draw["world_to_screen_batch"] = api::draw::world_to_screen_batch;
     draw["world_text"] = api::draw::world_text;
     draw["text"] = api::draw::text;
     draw["filled_rect"] = api::draw::filled_rect;
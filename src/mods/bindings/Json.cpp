@@ -1,5 +1,11 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <sstream>
+#include <vector>
 
 #include <json.hpp>
 #include <spdlog/spdlog.h>
@@ -13,90 +19,474 @@ using json = nlohmann::json;
 namespace fs = std::filesystem;
 
 namespace detail {
-json encode_any(sol::object obj) {
-    switch (obj.get_type()) {
-    case sol::type::nil:
-        return json{};
-    case sol::type::boolean:
-        return obj.as<bool>();
-    case sol::type::number: {
-        obj.push();
-        if (lua_isinteger(obj.lua_state(), -1)) {
-            obj.pop();
-            return obj.as<int64_t>();
-        }
-        
-        obj.pop();
-        
-        return obj.as<double>();
-    }
-    case sol::type::string:
-        return obj.as<std::string>();
-    case sol::type::table: {
-        auto table = obj.as<sol::table>();
-        bool is_array = true;
-        auto i = 1;
-
-        for (auto& kvp : table) {
-            if (kvp.first.get_type() != sol::type::number && kvp.first.as<int>() != i++) {
-                is_array = false;
+// Deep enough for any sane document, shallow enough to catch a table that contains itself.
+constexpr int MAX_DEPTH = 256;
+
+// Writes Lua values straight from the stack into a string, in the same format nlohmann's dump() produces.
+class Encoder {
+public:
+    Encoder(lua_State* l, int indent)
+        : m_l{l},
+        m_indent{indent}
+    {
+    }
+
+    std::string encode(int index) {
+        value(lua_absindex(m_l, index), 0);
+        return std::move(m_out);
+    }
+
+private:
+    void value(int index, int depth) {
+        switch (lua_type(m_l, index)) {
+        case LUA_TBOOLEAN:
+            m_out += lua_toboolean(m_l, index) ? "true" : "false";
+            break;
+        case LUA_TNUMBER:
+            number(index);
+            break;
+        case LUA_TSTRING: {
+            size_t len{};
+            const auto s = lua_tolstring(m_l, index, &len);
+            string(std::string_view{s, len});
+            break;
+        }
+        case LUA_TTABLE:
+            table(index, depth);
+            break;
+        default:
+            // nil, functions, userdata and threads have no JSON equivalent.
+            m_out += "null";
+            break;
+        }
+    }
+
+    void number(int index) {
+        char buf[32]{};
+
+        if (lua_isinteger(m_l, index)) {
+            const auto result = std::to_chars(buf, buf + sizeof(buf), (int64_t)lua_tointeger(m_l, index));
+            m_out.append(buf, result.ptr);
+            return;
+        }
+
+        const auto n = lua_tonumber(m_l, index);
+
+        if (!std::isfinite(n)) {
+            m_out += "null";
+            return;
+        }
+
+        // Shortest representation that round-trips.
+        const auto result = std::to_chars(buf, buf + sizeof(buf), n);
+        const auto len = result.ptr - buf;
+        m_out.append(buf, result.ptr);
+
+        // Keep floats recognizable as floats so they come back as floats.
+        if (std::string_view{buf, (size_t)len}.find_first_of(".eEn") == std::string_view::npos) {
+            m_out += ".0";
+        }
+    }
+
+    void string(std::string_view s) {
+        static constexpr char hex[] = "0123456789abcdef";
+
+        // nlohmann refuses to dump invalid UTF-8 too; writing it anyway would produce a document nothing can parse back.
+        if (const auto bad = invalid_utf8(s); bad != std::string_view::npos) {
+            char msg[64]{};
+            std::snprintf(msg, sizeof(msg), "invalid UTF-8 byte at index %zu: 0x%02X", bad, (uint8_t)s[bad]);
+            throw std::runtime_error{msg};
+        }
+
+        m_out += '"';
+
+        for (const auto c : s) {
+            switch (c) {
+            case '"':
+                m_out += "\\\"";
+                break;
+            case '\\':
+                m_out += "\\\\";
+                break;
+            case '\b':
+                m_out += "\\b";
+                break;
+            case '\f':
+                m_out += "\\f";
+                break;
+            case '\n':
+                m_out += "\\n";
+                break;
+            case '\r':
+                m_out += "\\r";
+                break;
+            case '\t':
+                m_out += "\\t";
+                break;
+            default:
+                if ((uint8_t)c < 0x20) {
+                    m_out += "\\u00";
+                    m_out += hex[(uint8_t)c >> 4];
+                    m_out += hex[(uint8_t)c & 0xF];
+                } else {
+                    m_out += c;
+                }
                 break;
             }
         }
 
-        json j{};
+        m_out += '"';
+    }
+
+    // Index of the first byte that isn't part of a well-formed UTF-8 sequence, or npos.
+    // Overlong forms, surrogates and code points past U+10FFFF are rejected, same as nlohmann.
+    static size_t invalid_utf8(std::string_view s) {
+        for (size_t i = 0; i < s.size();) {
+            const auto c = (uint8_t)s[i];
 
-        for (auto& kvp : table) {
-            if (is_array) {
-                j.push_back(encode_any(kvp.second));
+            if (c < 0x80) {
+                ++i;
+                continue;
+            }
+
+            size_t n{};
+            uint8_t lo = 0x80;
+            uint8_t hi = 0xBF;
+
+            if (c >= 0xC2 && c <= 0xDF) {
+                n = 1;
+            } else if (c >= 0xE0 && c <= 0xEF) {
+                n = 2;
+                lo = c == 0xE0 ? 0xA0 : 0x80;
+                hi = c == 0xED ? 0x9F : 0xBF;
+            } else if (c >= 0xF0 && c <= 0xF4) {
+                n = 3;
+                lo = c == 0xF0 ? 0x90 : 0x80;
+                hi = c == 0xF4 ? 0x8F : 0xBF;
             } else {
-                j[kvp.first.as<std::string>()] = encode_any(kvp.second);
+                return i;
+            }
+
+            // Only the first continuation byte has a narrowed range.
+            for (size_t j = 1; j <= n; ++j) {
+                // Cut off at the end of the string.
+                if (i + j >= s.size()) {
+                    return i;
+                }
+
+                const auto cc = (uint8_t)s[i + j];
+
+                if (cc < (j == 1 ? lo : 0x80) || cc > (j == 1 ? hi : 0xBF)) {
+                    return i + j;
+                }
             }
+
+            i += n + 1;
         }
 
-        return j;
+        return std::string_view::npos;
     }
-    default:
-        return json{};
+
+    void newline(int depth) {
+        if (m_indent < 0) {
+            return;
+        }
+
+        m_out += '\n';
+        m_out.append((size_t)m_indent * depth, ' ');
     }
-}
 
-sol::object decode_any(sol::this_state l, const json& j) {
-    using value_t = nlohmann::detail::value_t;
+    void table(int index, int depth) {
+        if (depth >= MAX_DEPTH) {
+            throw std::runtime_error{"table is nested too deeply (or contains itself)"};
+        }
 
-    auto state = sol::state_view{l};
+        luaL_checkstack(m_l, 4, "json encode");
 
-    switch (j.type()) {
-    case value_t::null:
-        return sol::nil;
-    case value_t::boolean:
-        return sol::make_object(l, j.get<bool>());
-    case value_t::number_integer:
-        return sol::make_object(l, j.get<int64_t>());
-    case value_t::number_unsigned:
-        return sol::make_object(l, j.get<uint64_t>());
-    case value_t::number_float:
-        return sol::make_object(l, j.get<double>());
-    case value_t::string:
-        return sol::make_object(l, j.get<std::string>());
-    case value_t::array: {
-        sol::table t = state.create_table();
-        for (size_t i = 0; i < j.size(); ++i) {
-            t[i + 1] = decode_any(l, j[i]);
-        }
-        return t;
-    }
-    case value_t::object: {
-        sol::table t = state.create_table();
-        for (auto it = j.begin(); it != j.end(); ++it) {
-            t[it.key()] = decode_any(l, it.value());
-        }
-        return t;
-    }
-    default:
-        return sol::nil;
+        const auto len = (lua_Integer)lua_rawlen(m_l, index);
+
+        // Same as before: an empty table is null.
+        if (len == 0 && is_empty(index)) {
+            m_out += "null";
+            return;
+        }
+
+        // Walking the keys first is cheap next to encoding the values, which then only happens once.
+        if (len > 0 && has_only_array_keys(index, len)) {
+            array(index, len, depth);
+            return;
+        }
+
+        object(index, depth);
+    }
+
+    bool is_empty(int index) {
+        lua_pushnil(m_l);
+
+        if (lua_next(m_l, index) == 0) {
+            return true;
+        }
+
+        lua_pop(m_l, 2);
+        return false;
+    }
+
+    void array(int index, lua_Integer len, int depth) {
+        m_out += '[';
+
+        for (lua_Integer i = 1; i <= len; ++i) {
+            if (i > 1) {
+                m_out += ',';
+            }
+
+            newline(depth + 1);
+            lua_rawgeti(m_l, index, i);
+            value(lua_gettop(m_l), depth + 1);
+            lua_pop(m_l, 1);
+        }
+
+        newline(depth);
+        m_out += ']';
+    }
+
+    // The length is only a border, so holes are allowed (and written as null), but any key outside 1..len
+    // would be lost by array(). {1, nil, 3, x = 5} can have a border at 3 and still needs to be an object.
+    bool has_only_array_keys(int index, lua_Integer len) {
+        lua_pushnil(m_l);
+
+        while (lua_next(m_l, index) != 0) {
+            lua_pop(m_l, 1);
+
+            const auto in_range = lua_isinteger(m_l, -1) && lua_tointeger(m_l, -1) >= 1 && lua_tointeger(m_l, -1) <= len;
+
+            if (!in_range) {
+                lua_pop(m_l, 1);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Enough to push the original key again for the lookup.
+    struct Key {
+        enum class Kind { STRING, INTEGER, FLOAT };
+
+        std::string text{};
+        Kind kind{};
+        lua_Integer integer{};
+        lua_Number number{};
+    };
+
+    // Keys are written sorted, since nlohmann keeps objects in a std::map.
+    void object(int index, int depth) {
+        std::vector<Key> keys{};
+
+        lua_pushnil(m_l);
+
+        while (lua_next(m_l, index) != 0) {
+            lua_pop(m_l, 1);
+
+            const auto key_type = lua_type(m_l, -1);
+
+            // Only string and number keys have a JSON spelling.
+            if (key_type != LUA_TSTRING && key_type != LUA_TNUMBER) {
+                continue;
+            }
+
+            Key key{};
+
+            if (key_type == LUA_TNUMBER) {
+                if (lua_isinteger(m_l, -1)) {
+                    key.kind = Key::Kind::INTEGER;
+                    key.integer = lua_tointeger(m_l, -1);
+                } else {
+                    key.kind = Key::Kind::FLOAT;
+                    key.number = lua_tonumber(m_l, -1);
+                }
+            }
+
+            // Convert a copy; lua_tolstring on the key itself would confuse lua_next.
+            lua_pushvalue(m_l, -1);
+            size_t len{};
+            const auto text = lua_tolstring(m_l, -1, &len);
+            key.text.assign(text, len);
+            lua_pop(m_l, 1);
+
+            keys.push_back(std::move(key));
+        }
+
+        // Stable, so when 1 and "1" collide the one seen last wins, like assigning both into a map would.
+        std::stable_sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) { return a.text < b.text; });
+
+        m_out += '{';
+
+        bool first = true;
+
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (i + 1 < keys.size() && keys[i].text == keys[i + 1].text) {
+                continue;
+            }
+
+            const auto& key = keys[i];
+
+            if (!first) {
+                m_out += ',';
+            }
+
+            first = false;
+            newline(depth + 1);
+
+            string(key.text);
+            m_out += m_indent >= 0 ? ": " : ":";
+
+            switch (key.kind) {
+            case Key::Kind::STRING:
+                lua_pushlstring(m_l, key.text.data(), key.text.size());
+                break;
+            case Key::Kind::INTEGER:
+                lua_pushinteger(m_l, key.integer);
+                break;
+            case Key::Kind::FLOAT:
+                lua_pushnumber(m_l, key.number);
+                break;
+            }
+
+            lua_rawget(m_l, index);
+            value(lua_gettop(m_l), depth + 1);
+            lua_pop(m_l, 1);
+        }
+
+        if (!first) {
+            newline(depth);
+        }
+
+        m_out += '}';
+    }
+
+    lua_State* m_l;
+    int m_indent;
+    std::string m_out{};
+};
+
+// Builds Lua tables directly from parser events, so no DOM is built in between.
+// Containers being filled sit on the Lua stack, each object key right above its table.
+class Decoder : public nlohmann::json_sax<json> {
+public:
+    Decoder(lua_State* l)
+        : m_l{l}
+    {
+    }
+
+    bool null() override {
+        lua_pushnil(m_l);
+        return finish_value();
+    }
+
+    bool boolean(bool val) override {
+        lua_pushboolean(m_l, val);
+        return finish_value();
+    }
+
+    bool number_integer(number_integer_t val) override {
+        lua_pushinteger(m_l, (lua_Integer)val);
+        return finish_value();
+    }
+
+    bool number_unsigned(number_unsigned_t val) override {
+        lua_pushinteger(m_l, (lua_Integer)val);
+        return finish_value();
+    }
+
+    bool number_float(number_float_t val, const string_t&) override {
+        lua_pushnumber(m_l, (lua_Number)val);
+        return finish_value();
+    }
+
+    bool string(string_t& val) override {
+        lua_pushlstring(m_l, val.data(), val.size());
+        return finish_value();
+    }
+
+    bool binary(binary_t&) override {
+        lua_pushnil(m_l);
+        return finish_value();
+    }
+
+    bool start_object(std::size_t) override {
+        return start_container(false);
+    }
+
+    bool key(string_t& val) override {
+        luaL_checkstack(m_l, 1, "json decode");
+        lua_pushlstring(m_l, val.data(), val.size());
+        return true;
+    }
+
+    bool end_object() override {
+        m_containers.pop_back();
+        return finish_value();
+    }
+
+    bool start_array(std::size_t) override {
+        return start_container(true);
+    }
+
+    bool end_array() override {
+        m_containers.pop_back();
+        return finish_value();
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+        m_error = ex.what();
+        return false;
     }
-}
+
+    const std::string& get_error() const {
+        return m_error;
+    }
+
+private:
+    struct Container {
+        bool is_array{};
+        lua_Integer next_index{1};
+    };
+
+    bool start_container(bool is_array) {
+        if (m_containers.size() >= MAX_DEPTH) {
+            m_error = "document is nested too deeply";
+            return false;
+        }
+
+        luaL_checkstack(m_l, 2, "json decode");
+        lua_newtable(m_l);
+        m_containers.push_back(Container{is_array});
+
+        return true;
+    }
+
+    // Moves the value on top of the stack into the container it belongs to.
+    // The root value has no container and is simply left on the stack.
+    bool finish_value() {
+        if (m_containers.empty()) {
+            return true;
+        }
+
+        auto& parent = m_containers.back();
+
+        if (parent.is_array) {
+            lua_rawseti(m_l, -2, parent.next_index++);
+        } else {
+            lua_rawset(m_l, -3);
+        }
+
+        return true;
+    }
+
+    lua_State* m_l;
+    std::vector<Container> m_containers{};
+    std::string m_error{};
+};
 
 fs::path get_datadir() {
     std::string modpath{};
@@ -106,11 +496,87 @@ fs::path get_datadir() {
 
     return fs::path{modpath}.parent_path() / "reframework" / "data";
 }
+
+fs::path get_data_path(std::string_view fn_name, const std::string& filepath) {
+    if (filepath.find("..") != std::string::npos) {
+        throw std::runtime_error{fmt::format("json.{} does not allow access to parent directories", fn_name)};
+    }
+
+    if (std::filesystem::path(filepath).is_absolute()) {
+        throw std::runtime_error{fmt::format("json.{} does not allow absolute paths", fn_name)};
+    }
+
+    return get_datadir() / filepath;
+}
+
+std::string encode(sol::object obj, int indent) {
+    auto l = obj.lua_state();
+
+    if (l == nullptr) {
+        return "null";
+    }
+
+    const auto top = lua_gettop(l);
+    obj.push();
+
+    try {
+        auto result = Encoder{l, indent}.encode(-1);
+        lua_settop(l, top);
+        return result;
+    } catch (...) {
+        lua_settop(l, top);
+        throw;
+    }
+}
+
+std::optional<sol::object> decode(sol::this_state l, std::string_view text, std::string* error) {
+    const auto top = lua_gettop(l);
+
+    Decoder decoder{l};
+    const auto ok = json::sax_parse(text.begin(), text.end(), &decoder);
+
+    if (!ok) {
+        lua_settop(l, top);
+
+        if (error != nullptr) {
+            *error = decoder.get_error();
+        }
+
+        return std::nullopt;
+    }
+
+    return sol::stack::pop<sol::object>(l);
+}
+
+std::optional<std::string> read_text(const fs::path& path) {
+    std::ifstream f{path, std::ios::binary};
+
+    if (!f) {
+        return std::nullopt;
+    }
+
+    std::stringstream ss{};
+    ss << f.rdbuf();
+
+    return ss.str();
+}
+
+bool write_text(const fs::path& path, std::string_view text) {
+    fs::create_directories(path.parent_path());
+
+    std::ofstream f{path, std::ios::binary};
+
+    if (!f) {
+        return false;
+    }
+
+    f.write(text.data(), text.size());
+    return f.good();
+}
 } // namespace detail
 
 sol::object load_string(sol::this_state l, const std::string& s) try {
-    const auto j = json::parse(s);
-    return detail::decode_any(l, j);
+    return detail::decode(l, s).value_or(sol::make_object(l, sol::nil));
 } catch (const std::exception& e) {
     return sol::nil;
 }
@@ -122,24 +588,33 @@ std::string dump_string(sol::object obj, sol::object indent_obj) try {
         indent = indent_obj.as<int>();
     }
 
-    return detail::encode_any(obj).dump(indent);
+    return detail::encode(obj, indent);
 } catch (const std::exception& e) {
     return "";
 }
 
-sol::object load_file(sol::this_state l, const std::string& filepath) try {
-    if (filepath.find("..") != std::string::npos) {
-        throw std::runtime_error{"json.load_file does not allow access to parent directories"};
+sol::object load_file(sol::this_state l, const std::string& filepath) {
+    const auto path = detail::get_data_path("load_file", filepath);
+
+    // A dump_file_async that hasn't landed yet is what the file is about to contain.
+    auto text = g_file_worker.get_pending_write(path);
+
+    if (!text) {
+        text = detail::read_text(path);
     }
 
-    if (std::filesystem::path(filepath).is_absolute()) {
-        throw std::runtime_error{"json.load_file does not allow absolute paths"};
+    if (!text) {
+        spdlog::error("[JSON] Failed to load file {}: could not open it", filepath);
+        return sol::nil;
+    }
+
+    std::string error{};
+
+    if (auto result = detail::decode(l, *text, &error)) {
+        return *result;
     }
 
-    const auto j = json::parse(std::ifstream{detail::get_datadir() / filepath});
-    return detail::decode_any(l, j);
-} catch (const json::exception& e) {
-    spdlog::error("[JSON] Failed to load file {}: {}", filepath, e.what());
+    spdlog::error("[JSON] Failed to load file {}: {}", filepath, error);
     return sol::nil;
 }
 
@@ -150,26 +625,49 @@ bool dump_file(const std::string& filepath, sol::object obj, sol::object indent_
         indent = indent_obj.as<int>();
     }
 
-    if (filepath.find("..") != std::string::npos) {
-        throw std::runtime_error{"json.dump_file does not allow access to parent directories"};
-    }
-
-    if (std::filesystem::path(filepath).is_absolute()) {
-        throw std::runtime_error{"json.dump_file does not allow absolute paths"};
-    }
-
-    auto path = detail::get_datadir() / filepath;
+    const auto path = detail::get_data_path("dump_file", filepath);
+    const auto text = detail::encode(obj, indent);
 
-    fs::create_directories(path.parent_path());
+    // Otherwise an older dump_file_async to the same file could land on top of this one.
+    g_file_worker.cancel_pending_write(path);
 
-    std::ofstream f{path};
-    f << detail::encode_any(obj).dump(indent);
-    return true;
+    return detail::write_text(path, text);
 } catch (const std::exception& e) {
     spdlog::error("[JSON] Failed to dump file {}: {}", filepath, e.what());
     return false;
 }
 
+using Request = bindings::AsyncFileRequests::Request;
+
+std::shared_ptr<Request> load_file_async(sol::this_state l, const std::string& filepath, sol::object callback) {
+    auto path = detail::get_data_path("load_file_async", filepath);
+    auto& requests = sol::state_view{l}.registry()["state"].get<ScriptState*>()->get_file_requests();
+    auto [req, on_done] = requests.create(bindings::AsyncFileRequests::Kind::JSON, callback);
+
+    g_file_worker.read(std::move(path), true, std::move(on_done));
+
+    return req;
+}
+
+// The value is encoded here, since it lives in this state; only the write happens on the worker.
+std::shared_ptr<Request> dump_file_async(sol::this_state l, const std::string& filepath, sol::object obj, sol::object indent_or_callback, sol::object callback) {
+    int indent = 4;
+
+    if (indent_or_callback.get_type() == sol::type::number) {
+        indent = indent_or_callback.as<int>();
+    } else if (indent_or_callback.get_type() == sol::type::function) {
+        callback = indent_or_callback;
+    }
+
+    auto path = detail::get_data_path("dump_file_async", filepath);
+    auto text = detail::encode(obj, indent);
+    auto& requests = sol::state_view{l}.registry()["state"].get<ScriptState*>()->get_file_requests();
+    auto [req, on_done] = requests.create(bindings::AsyncFileRequests::Kind::WRITE, callback);
+
+    g_file_worker.write(std::move(path), std::move(text), true, std::move(on_done));
+
+    return req;
+}
 } // namespace api::json
 
 void bindings::open_json(ScriptState* s) {
@@ -180,5 +678,7 @@ void bindings::open_json(ScriptState* s) {
     json["dump_string"] = api::json::dump_string;
     json["load_file"] = api::json::load_file;
     json["dump_file"] = api::json::dump_file;
+    json["load_file_async"] = api::json::load_file_async;
+    json["dump_file_async"] = api::json::dump_file_async;
     lua["json"] = json;
 }
\ No newline at end of file
@@ -1,7 +1,26 @@
 #pragma once
 
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <sol/sol.hpp>
+
 class ScriptState;
 
+namespace api::json::detail {
+// Streams a Lua value to JSON text. indent < 0 is compact. Throws on tables nested too deeply (or cyclic).
+std::string encode(sol::object obj, int indent = -1);
+
+// Parses JSON text straight into Lua values. Returns nullopt on a parse error.
+std::optional<sol::object> decode(sol::this_state l, std::string_view text, std::string* error = nullptr);
+
+// Plain file I/O for the file variants; these don't touch Lua, so they can run on any thread.
+std::optional<std::string> read_text(const std::filesystem::path& path);
+bool write_text(const std::filesystem::path& path, std::string_view text);
+}
+
 namespace bindings {
 void open_json(ScriptState* s);
 }
@@ -1,5 +1,7 @@
+#include <atomic>
 #include <cstdint>
 #include <concepts>
+#include <thread>
 
 #include <hde64.h>
 
@@ -8,12 +10,15 @@
 #include "sdk/REManagedObject.hpp"
 #include "sdk/RETypeDB.hpp"
 #include "sdk/SceneManager.hpp"
+#include "sdk/SceneSnapshot.hpp"
 #include "sdk/ResourceManager.hpp"
 #include "sdk/MotionFsm2Layer.hpp"
 #include "sdk/TDBVer.hpp"
+#include "sdk/Trace.hpp"
 #include "utility/Memory.hpp"
 
 #include "../ScriptRunner.hpp"
+#include "../ValueTypeStorage.hpp"
 #include <lstate.h> // weird include order because of sol
 #include <lgc.h>
 
@@ -21,8 +26,6 @@
 
 namespace api {
 namespace sdk {
-static std::unordered_map<::sdk::RETypeDefinition*, uint32_t> s_fnv_cache{};
-
 struct BehaviorTreeCoreHandle : public ::REManagedObject {
     int unused;
 };
@@ -31,6 +34,52 @@ struct BehaviorTree : public ::REManagedObject {
     int unused;
     int unused2;
 };
+
+// How parse_data/set_data convert a value of a given type.
+// Enums are resolved to the kind of their underlying type.
+enum class MarshalKind : uint8_t {
+    UNKNOWN,
+    STRING,
+    SINGLE,
+    BOOLEAN,
+    SBYTE,
+    BYTE,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    INT64,
+    UINT64,
+    VEC2,
+    VEC3,
+    VEC4,
+    MAT4,
+    QUATERNION,
+    GAMEOBJECTREF,
+    ARRAY,
+    OBJECT,
+    VALUETYPE,
+};
+
+// Which usertype sol_lua_push uses for managed objects of a given type.
+enum class UserType : uint8_t {
+    MANAGED_OBJECT,
+    TRANSFORM,
+    BEHAVIOR_TREE,
+    BEHAVIOR_TREE_CORE_HANDLE,
+};
+
+// Precomputed per type so the hot path doesn't need to hash get_full_name() for every value.
+struct MarshalInfo {
+    ::sdk::RETypeDefinition* type{nullptr};
+    ::sdk::RETypeDefinition* underlying_type{nullptr}; // enums only
+    uint32_t size{0};
+    MarshalKind kind{MarshalKind::UNKNOWN};
+    UserType usertype{UserType::MANAGED_OBJECT};
+    bool is_value_type{false};
+};
+
+const MarshalInfo& get_marshal_info(::sdk::RETypeDefinition* data_type);
 }
 }
 
@@ -40,15 +89,256 @@ constexpr uintptr_t FAKE_OBJECT_ADDR = 12345;
 
 namespace api::re_managed_object {
 namespace detail {
+// Native replacement for the old _sol_lua_push_objects/_sol_lua_push_ref_counts/_sol_lua_push_ephemeral_counts tables.
+// Maps an object to the slot of its userdata in a weak table, along with our reference bookkeeping for it.
+class ObjectCache {
+public:
+    struct Entry {
+        ::REManagedObject* obj{nullptr};
+        int slot{LUA_NOREF}; // index into the weak object table
+        int32_t ref_count{0}; // references we hold on the game object
+        int32_t ephemeral_count{0}; // pushes of local objects we didn't add a reference to
+    };
+
+    Entry* find(::REManagedObject* obj) {
+        if (m_entries.empty()) {
+            return nullptr;
+        }
+
+        const auto mask = m_entries.size() - 1;
+
+        for (auto i = hash(obj) & mask;; i = (i + 1) & mask) {
+            auto& entry = m_entries[i];
+
+            if (entry.obj == obj) {
+                return &entry;
+            }
+
+            if (entry.obj == nullptr) {
+                return nullptr;
+            }
+        }
+    }
+
+    Entry& find_or_insert(::REManagedObject* obj) {
+        // keep the load factor (including tombstones) under 75%
+        if ((m_used + 1) * 4 >= m_entries.size() * 3) {
+            rehash(std::max<size_t>(64, m_live * 4 >= m_entries.size() ? m_entries.size() * 2 : m_entries.size()));
+        }
+
+        const auto mask = m_entries.size() - 1;
+        Entry* tombstone = nullptr;
+
+        for (auto i = hash(obj) & mask;; i = (i + 1) & mask) {
+            auto& entry = m_entries[i];
+
+            if (entry.obj == obj) {
+                return entry;
+            }
+
+            if (entry.obj == TOMBSTONE && tombstone == nullptr) {
+                tombstone = &entry;
+            } else if (entry.obj == nullptr) {
+                auto& out = tombstone != nullptr ? *tombstone : entry;
+
+                if (&out == &entry) {
+                    ++m_used;
+                }
+
+                ++m_live;
+                out = Entry{obj};
+
+                return out;
+            }
+        }
+    }
+
+    void erase(Entry& entry) {
+        entry = Entry{TOMBSTONE};
+        --m_live;
+    }
+
+    // slots in the weak table are managed here rather than with luaL_ref,
+    // because luaL_ref relies on the table's length, which changes when the GC clears values.
+    int alloc_slot() {
+        if (!m_free_slots.empty()) {
+            const auto slot = m_free_slots.back();
+            m_free_slots.pop_back();
+            return slot;
+        }
+
+        return ++m_last_slot;
+    }
+
+    void free_slot(int slot) {
+        m_free_slots.push_back(slot);
+    }
+
+    void reset(int table_ref) {
+        m_entries.clear();
+        m_free_slots.clear();
+        m_used = 0;
+        m_live = 0;
+        m_last_slot = 0;
+        m_table_ref = table_ref;
+    }
+
+    int table_ref() const {
+        return m_table_ref;
+    }
+
+private:
+    static inline const auto TOMBSTONE = (::REManagedObject*)1;
+
+    static size_t hash(::REManagedObject* obj) {
+        return (size_t)((((uintptr_t)obj >> 4) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    void rehash(size_t new_size) {
+        auto old_entries = std::move(m_entries);
+
+        m_entries.clear();
+        m_entries.resize(new_size);
+        m_used = 0;
+        m_live = 0;
+
+        const auto mask = new_size - 1;
+
+        for (auto& old : old_entries) {
+            if (old.obj == nullptr || old.obj == TOMBSTONE) {
+                continue;
+            }
+
+            auto i = hash(old.obj) & mask;
+
+            while (m_entries[i].obj != nullptr) {
+                i = (i + 1) & mask;
+            }
+
+            m_entries[i] = old;
+            ++m_used;
+            ++m_live;
+        }
+    }
+
+    std::vector<Entry> m_entries{};
+    std::vector<int> m_free_slots{};
+    size_t m_used{0}; // live entries + tombstones
+    size_t m_live{0};
+    int m_last_slot{0};
+    int m_table_ref{LUA_NOREF};
+};
+
+// Inline cache for __index/__newindex. Lua interns short strings, so once a key string
+// is anchored in the registry its pointer uniquely identifies it for the lifetime of the state.
+struct MemberCacheKey {
+    uint32_t type_index{};
+    const char* name{}; // nullptr for non-string keys
+
+    bool operator==(const MemberCacheKey& other) const {
+        return type_index == other.type_index && name == other.name;
+    }
+};
+
+struct MemberCacheKeyHash {
+    size_t operator()(const MemberCacheKey& key) const {
+        return std::hash<uintptr_t>{}((uintptr_t)key.name) ^ ((size_t)key.type_index * 0x9E3779B97F4A7C15);
+    }
+};
+
+struct MemberCacheEntry {
+    ::sdk::REField* field{nullptr};
+    ::sdk::REMethodDefinition* method{nullptr};
+    ::sdk::REMethodDefinition* get_item{nullptr};
+    ::sdk::REMethodDefinition* set_item{nullptr};
+};
+}
+}
+
+namespace api::sdk {
+// The sdk bindings' caches for one Lua state. Owned by its ScriptState and only accessed with its lock held.
+struct StateCaches {
+    re_managed_object::detail::ObjectCache objects{};
+    std::unordered_map<re_managed_object::detail::MemberCacheKey, re_managed_object::detail::MemberCacheEntry, re_managed_object::detail::MemberCacheKeyHash> members{};
+};
+
+StateCachesPtr create_state_caches() {
+    return StateCachesPtr{new StateCaches{}};
+}
+
+void StateCachesDeleter::operator()(StateCaches* caches) const {
+    delete caches;
+}
+}
+
+namespace api::re_managed_object {
+namespace detail {
+// The address is the registry key of the state's StateCaches.
+static const char s_state_caches_key{};
+
+void register_caches(lua_State* l, ::api::sdk::StateCaches* caches) {
+    lua_pushlightuserdata(l, caches);
+    lua_rawsetp(l, LUA_REGISTRYINDEX, &s_state_caches_key);
+}
+
+::api::sdk::StateCaches& get_caches(lua_State* l) {
+    lua_rawgetp(l, LUA_REGISTRYINDEX, &s_state_caches_key);
+    auto caches = (::api::sdk::StateCaches*)lua_touserdata(l, -1);
+    lua_pop(l, 1);
+
+    return *caches;
+}
+
+// Game references dropped by garbage collected objects, released at the end of the frame.
+static std::mutex s_pending_releases_mtx{};
+static std::vector<::REManagedObject*> s_pending_releases{};
+
+void reset_object_cache(lua_State* l) {
+    {
+        // anything left over from the previous state being closed
+        std::scoped_lock _{s_pending_releases_mtx};
+
+        for (auto obj : s_pending_releases) {
+            utility::re_managed_object::release(obj);
+        }
+
+        s_pending_releases.clear();
+    }
+
+    // weak values, so the cache doesn't keep the userdata alive
+    lua_newtable(l);
+    lua_newtable(l);
+    lua_pushstring(l, "v");
+    lua_setfield(l, -2, "__mode");
+    lua_setmetatable(l, -2);
+
+    get_caches(l).objects.reset(luaL_ref(l, LUA_REGISTRYINDEX));
+}
+
+void erase_cached_object(lua_State* l, ObjectCache::Entry& entry) {
+    auto& cache = get_caches(l).objects;
+
+    if (entry.slot != LUA_NOREF) {
+        lua_rawgeti(l, LUA_REGISTRYINDEX, cache.table_ref());
+        lua_pushnil(l);
+        lua_rawseti(l, -2, entry.slot);
+        lua_pop(l, 1);
+
+        cache.free_slot(entry.slot);
+    }
+
+    cache.erase(entry);
+}
+
 void add_ref(lua_State* l, ::REManagedObject* obj, bool force = false) {
-    auto sv = sol::state_view{l};
-    
     // we shouldn't really do this very much
     // so it shouldn't be too terrible on performance
     if (!utility::re_managed_object::is_managed_object(obj)) {
         throw sol::error{(std::stringstream{} << "sol_lua_push: " << (uintptr_t)obj << " is not a managed object").str()};
     }
 
+    auto& entry = get_caches(l).objects.find_or_insert(obj);
+
     // Throwing automatic add_ref on the backburner; it doesn't seem to work
     // very well with lua's garbage collector.
     // addendum: maybe figured it out
@@ -64,18 +354,14 @@ void add_ref(lua_State* l, ::REManagedObject* obj, bool force = false) {
         // the reference counting is not necessary, but it will let us
         // catch bugs if an REManagedObject pointer is being created
         // without coming through our sol_lua_push function
-        sol::lua_table ref_counts = sv["_sol_lua_push_ref_counts"];
-        sol::lua_table ephemeral_counts = sv["_sol_lua_push_ephemeral_counts"];
-        std::optional<int> current_ref_count = ref_counts[(uintptr_t)obj];
-
-        if (current_ref_count && *current_ref_count > 0) {
+        if (entry.ref_count > 0) {
             // don't unnecessarily increase the ref count
             // if the user is the one doing it
             if (force) {
                 return;
             }
 
-            ref_counts[(uintptr_t)obj] = *current_ref_count + 1;
+            ++entry.ref_count;
         } else {
             // only add the ref once when the user requests it
             // so they don't screw something up
@@ -83,33 +369,18 @@ void add_ref(lua_State* l, ::REManagedObject* obj, bool force = false) {
                 utility::re_managed_object::add_ref(obj);
             }
 
-            ref_counts[(uintptr_t)obj] = 1;
+            entry.ref_count = 1;
         }
 
         // when the user adds a ref to an ephemeral object
-        if (force) {
-            std::optional<int> current_ephemeral_count = ephemeral_counts[(uintptr_t)obj];
-
-            if (current_ephemeral_count && *current_ephemeral_count > 0) {
-                ephemeral_counts[(uintptr_t)obj] = *current_ephemeral_count - 1;
-            } else {
-                ephemeral_counts[(uintptr_t)obj] = sol::make_object(l, sol::nil);
-            }
+        if (force && entry.ephemeral_count > 0) {
+            --entry.ephemeral_count;
         }
     } else {
-        // ephemeral counts is just a table
+        // ephemeral counts are just
         // to help with tracking the local objects
         // so we don't spam the log with warnings when they get gc'd
-        sol::lua_table ephemeral_counts = sv["_sol_lua_push_ephemeral_counts"];
-        std::optional<int> current_ref_count = ephemeral_counts[(uintptr_t)obj];
-
-        if (current_ref_count) {
-            ephemeral_counts[(uintptr_t)obj] = *current_ref_count + 1;
-        } else {
-            ephemeral_counts[(uintptr_t)obj] = 1;
-        }
-
-        //ref_counts[(uintptr_t)obj] = sol::make_object(l, sol::nil);
+        ++entry.ephemeral_count;
     }
 }
 }
@@ -131,47 +402,31 @@ void add_ref(lua_State* l, ::REManagedObject* obj, bool force = false) {
     return obj;
 }
 
-void release(sol::this_state s, ::REManagedObject* obj, bool force = false) {
+void release(sol::this_state s, ::REManagedObject* obj, bool force = false, bool deferred = false) {
     auto l = s.lua_state();
-    auto sv = sol::state_view(l);
-
-    sol::lua_table objects = sv["_sol_lua_push_objects"];
-    sol::lua_table ref_counts = sv["_sol_lua_push_ref_counts"];
-    sol::lua_table ephemeral_counts = sv["_sol_lua_push_ephemeral_counts"];
+    auto entry = detail::get_caches(l).objects.find(obj);
 
-    if (std::optional<int> ref_count = ref_counts[(uintptr_t)obj]; ref_count && *ref_count > 0) {
+    if (entry != nullptr && entry->ref_count > 0) {
         // because of our internal refcount keeping, we shouldn't need to double check
         // whether it's an actual object or not. hopefully?
-        //if (utility::re_managed_object::is_managed_object(obj)) {
-            utility::re_managed_object::release(obj);
-        //}
-
-        int new_ref_count = *ref_count - 1;
-
-        if (new_ref_count == 0) {
-            if (sol::object object = ephemeral_counts[(uintptr_t)obj]; !object.valid()) {
-                objects[(uintptr_t)obj] = sol::make_object(l, sol::nil);
-            }
-
-            ref_counts[(uintptr_t)obj] = sol::make_object(l, sol::nil);
+        if (deferred) {
+            std::scoped_lock _{detail::s_pending_releases_mtx};
+            detail::s_pending_releases.push_back(obj);
         } else {
-            ref_counts[(uintptr_t)obj] = new_ref_count;
+            utility::re_managed_object::release(obj);
         }
 
-        //ephemeral_counts[(uintptr_t)obj] = sol::make_object(l, sol::nil);
-    } else if (std::optional<int> ephemeral_count = ephemeral_counts[(uintptr_t)obj]; ephemeral_count && *ephemeral_count > 0) {
+        if (--entry->ref_count == 0 && entry->ephemeral_count == 0) {
+            detail::erase_cached_object(l, *entry);
+        }
+    } else if (entry != nullptr && entry->ephemeral_count > 0) {
         if (force && utility::re_managed_object::is_managed_object(obj)) {
             utility::re_managed_object::release(obj);
         }
 
         // ephemeral counts don't actually release the object, they just decrement the count.
-        int new_ephemeral_count = *ephemeral_count - 1;
-
-        if (new_ephemeral_count == 0) {
-            objects[(uintptr_t)obj] = sol::make_object(l, sol::nil);
-            ephemeral_counts[(uintptr_t)obj] = sol::make_object(l, sol::nil);
-        } else {
-            ephemeral_counts[(uintptr_t)obj] = new_ephemeral_count;
+        if (--entry->ephemeral_count == 0) {
+            detail::erase_cached_object(l, *entry);
         }
     } else {
         if (force) {
@@ -183,82 +438,93 @@ void release(sol::this_state s, ::REManagedObject* obj, bool force = false) {
         }
     }
 }
+
+// __gc metamethod for REManagedObject and derived usertypes.
+void gc(sol::this_state s, ::REManagedObject* obj) {
+    release(s, obj, false, true);
+}
+}
+
+namespace api::sdk {
+void flush_pending_releases() {
+    std::vector<::REManagedObject*> releases{};
+
+    {
+        std::scoped_lock _{api::re_managed_object::detail::s_pending_releases_mtx};
+        releases.swap(api::re_managed_object::detail::s_pending_releases);
+    }
+
+    for (auto obj : releases) {
+        utility::re_managed_object::release(obj);
+    }
+}
 }
 
 // specialization for REManagedObject to automatically add a reference
 // when lua pushes a pointer to the object onto the stack
 template<detail::ManagedObjectBased T>
 int sol_lua_push(sol::types<T*>, lua_State* l, T* obj) {
-    if (obj != nullptr) {
-        auto sv = sol::state_view{l};
-        sol::lua_table objects = sv["_sol_lua_push_objects"];
-
-        if (sol::object lua_obj = objects[(uintptr_t)obj]; !lua_obj.is<sol::nil_t>()) {
-            // renew the reference so it doesn't get collected
-            // had to dig deep in the lua source to figure out this nonsense
-            lua_obj.push();
-            auto g = G(l);
-            auto tv = s2v(l->top - 1);
-            auto& gc = tv->value_.gc;
-            resetbits(gc->marked, bitmask(BLACKBIT) | WHITEBITS); // "touches" the object, marking it gray. lowers the insane GC frequency on our weak table
-
-            return 1;
-        } else {
-            if ((uintptr_t)obj != detail::FAKE_OBJECT_ADDR) {
-                api::re_managed_object::detail::add_ref(l, (::REManagedObject*)obj, false);
-            }
+    REF_TRACE_SCOPE(LUA_PUSH);
 
-            int32_t backpedal = 0;
-
-            if ((uintptr_t)obj != detail::FAKE_OBJECT_ADDR) {
-                uint32_t typename_hash = 0;
-                const auto td = utility::re_managed_object::get_type_definition(obj);
-
-                if (td != nullptr) {
-                    if (auto it = api::sdk::s_fnv_cache.find(td); it != api::sdk::s_fnv_cache.end()) {
-                        typename_hash = it->second;
-                    } else {
-                        typename_hash = utility::hash(td->get_full_name());
-                        api::sdk::s_fnv_cache[td] = typename_hash;
-                    }
-
-                    switch (typename_hash) {
-                    case "via.Transform"_fnv:
-                        backpedal = sol::stack::push<sol::detail::as_pointer_tag<std::remove_pointer_t<::RETransform>>>(l, (::RETransform*)obj);
-                        break;
-                    case "via.behaviortree.BehaviorTree"_fnv:[[fallthrough]];
-                    case "via.motion.MotionFsm2"_fnv:[[fallthrough]];
-                    case "via.motion.MotionJackFsm2"_fnv:
-                        backpedal = sol::stack::push<sol::detail::as_pointer_tag<std::remove_pointer_t<api::sdk::BehaviorTree>>>(l, (api::sdk::BehaviorTree*)obj);
-                        break;
-                    case "via.behaviortree.BehaviorTree.CoreHandle"_fnv: [[fallthrough]];
-                    case "via.motion.MotionFsm2Layer"_fnv: [[fallthrough]];
-                    case "via.timeline.TimelineFsm2Layer"_fnv:
-                        backpedal = sol::stack::push<sol::detail::as_pointer_tag<std::remove_pointer_t<api::sdk::BehaviorTreeCoreHandle>>>(l, (api::sdk::BehaviorTreeCoreHandle*)obj);
-                        break;
-                    default:
-                        backpedal = sol::stack::push<sol::detail::as_pointer_tag<std::remove_pointer_t<T>>>(l, obj);
-                        break;
-                    };
-                } else {
-                    backpedal = sol::stack::push<sol::detail::as_pointer_tag<std::remove_pointer_t<T>>>(l, obj);
-                }
+    if (obj == nullptr) {
+        return sol::stack::push(l, sol::nil);
+    }
 
-                auto ref = sol::stack::get<sol::object>(l, -backpedal);
+    if ((uintptr_t)obj == detail::FAKE_OBJECT_ADDR) {
+        return sol::stack::push<sol::detail::as_pointer_tag<std::remove_pointer_t<T>>>(l, obj);
+    }
 
-                // keep a weak reference to the object for caching
-                objects[(uintptr_t)obj] = ref;
+    auto& cache = api::re_managed_object::detail::get_caches(l).objects;
+    auto entry = cache.find((::REManagedObject*)obj);
 
-                return backpedal;
-            } else {
-                backpedal = sol::stack::push<sol::detail::as_pointer_tag<std::remove_pointer_t<T>>>(l, obj);
-            }
+    if (entry != nullptr && entry->slot != LUA_NOREF) {
+        lua_rawgeti(l, LUA_REGISTRYINDEX, cache.table_ref());
+        lua_rawgeti(l, -1, entry->slot);
+        lua_remove(l, -2);
 
-            return backpedal;
+        if (!lua_isnil(l, -1)) {
+            return 1;
         }
+
+        // the userdata was collected but hasn't been finalized yet, so make a new one.
+        lua_pop(l, 1);
+    }
+
+    api::re_managed_object::detail::add_ref(l, (::REManagedObject*)obj, false);
+
+    int32_t backpedal = 0;
+    const auto td = utility::re_managed_object::get_type_definition(obj);
+    const auto usertype = td != nullptr ? api::sdk::get_marshal_info(td).usertype : api::sdk::UserType::MANAGED_OBJECT;
+
+    switch (usertype) {
+    case api::sdk::UserType::TRANSFORM:
+        backpedal = sol::stack::push<sol::detail::as_pointer_tag<std::remove_pointer_t<::RETransform>>>(l, (::RETransform*)obj);
+        break;
+    case api::sdk::UserType::BEHAVIOR_TREE:
+        backpedal = sol::stack::push<sol::detail::as_pointer_tag<std::remove_pointer_t<api::sdk::BehaviorTree>>>(l, (api::sdk::BehaviorTree*)obj);
+        break;
+    case api::sdk::UserType::BEHAVIOR_TREE_CORE_HANDLE:
+        backpedal = sol::stack::push<sol::detail::as_pointer_tag<std::remove_pointer_t<api::sdk::BehaviorTreeCoreHandle>>>(l, (api::sdk::BehaviorTreeCoreHandle*)obj);
+        break;
+    default:
+        backpedal = sol::stack::push<sol::detail::as_pointer_tag<std::remove_pointer_t<T>>>(l, obj);
+        break;
+    };
+
+    // add_ref may have grown the cache, so look the entry up again.
+    auto& new_entry = cache.find_or_insert((::REManagedObject*)obj);
+
+    if (new_entry.slot == LUA_NOREF) {
+        new_entry.slot = cache.alloc_slot();
     }
 
-    return sol::stack::push(l, sol::nil);
+    // keep a weak reference to the object for caching
+    lua_rawgeti(l, LUA_REGISTRYINDEX, cache.table_ref());
+    lua_pushvalue(l, -1 - backpedal);
+    lua_rawseti(l, -2, new_entry.slot);
+    lua_pop(l, 1);
+
+    return backpedal;
 }
 
 namespace api::sdk {
@@ -270,7 +536,7 @@ sol::object get_field_or_method(sol::object obj, const char* name);
 void set_native_field(lua_State* l, sol::object obj, ::sdk::RETypeDefinition* ty, const char* name, sol::object value);
 
 struct ValueType {
-    std::vector<uint8_t> data{};
+    ValueTypeStorage data{};
     ::sdk::RETypeDefinition* type{nullptr};
 
     ValueType(::sdk::RETypeDefinition* t)
@@ -281,10 +547,16 @@ struct ValueType {
         }
     }
 
+    // Copies size bytes of raw_data in; used for struct results so they're built in place in the userdata.
+    ValueType(::sdk::RETypeDefinition* t, const void* raw_data, size_t raw_data_size)
+        : type(t)
+    {
+        data.assign(raw_data, raw_data_size);
+    }
+
     ValueType(const void* raw_data, size_t raw_data_size) {
         if (raw_data_size > 0 && raw_data != nullptr) {
-            data.resize(raw_data_size);
-            memcpy(data.data(), raw_data, raw_data_size);
+            data.assign(raw_data, raw_data_size);
         }
     }
 
@@ -427,6 +699,40 @@ struct MemoryView {
     }
 };
 
+// What sdk.get_scene_snapshot returns. Entries are read out of the shared snapshot on demand,
+// and nothing is handed out once the snapshot has been invalidated, since its pointers may be dangling by then.
+struct SceneView {
+    std::shared_ptr<const ::sdk::SceneSnapshot> scene{};
+    bool filtered{false};
+    std::vector<uint32_t> indices{}; // into the snapshot's entries, when filtered
+    std::vector<::REComponent*> components{}; // parallel to indices
+
+    size_t size() const {
+        return filtered ? indices.size() : scene->get_entries().size();
+    }
+
+    // i is 1-based. Null when it's out of range.
+    const ::sdk::SceneEntry* get(lua_Integer i, ::REComponent** component = nullptr) const {
+        if (!scene->is_current()) {
+            throw sol::error("This scene snapshot is out of date; call sdk.get_scene_snapshot again.");
+        }
+
+        if (i < 1 || i > (lua_Integer)size()) {
+            return nullptr;
+        }
+
+        if (!filtered) {
+            return &scene->get_entries()[i - 1];
+        }
+
+        if (component != nullptr) {
+            *component = components[i - 1];
+        }
+
+        return &scene->get_entries()[indices[i - 1]];
+    }
+};
+
 void* get_thread_context() {
     return (void*)::sdk::get_thread_context();
 }
@@ -662,38 +968,190 @@ void* get_real_obj(sol::object obj) {
     return real_obj;
 }
 
-sol::object parse_data(lua_State* l, void* data, ::sdk::RETypeDefinition* data_type, bool from_method) {
-    if (data_type != nullptr) {
-        if (!data_type->is_value_type()) {
-            if (data == nullptr || *(void**)data == nullptr) {
-                return sol::make_object(l, sol::nil);
-            }
+namespace detail {
+MarshalInfo build_marshal_info(::sdk::RETypeDefinition* data_type) {
+    MarshalInfo new_info{};
+    new_info.type = data_type;
+    new_info.is_value_type = data_type->is_value_type();
+    new_info.size = data_type->get_size();
+
+    size_t full_name_hash{};
+
+    // Slightly different logic for enums
+    if (data_type->is_enum()) {
+        new_info.underlying_type = data_type->get_underlying_type();
+
+        if (new_info.underlying_type != nullptr) {
+            full_name_hash = utility::hash(new_info.underlying_type->get_full_name());
+        }
+    } else {
+        full_name_hash = utility::hash(data_type->get_full_name());
+
+        switch (full_name_hash) {
+        case "via.Transform"_fnv:
+            new_info.usertype = UserType::TRANSFORM;
+            break;
+        case "via.behaviortree.BehaviorTree"_fnv:[[fallthrough]];
+        case "via.motion.MotionFsm2"_fnv:[[fallthrough]];
+        case "via.motion.MotionJackFsm2"_fnv:
+            new_info.usertype = UserType::BEHAVIOR_TREE;
+            break;
+        case "via.behaviortree.BehaviorTree.CoreHandle"_fnv: [[fallthrough]];
+        case "via.motion.MotionFsm2Layer"_fnv: [[fallthrough]];
+        case "via.timeline.TimelineFsm2Layer"_fnv:
+            new_info.usertype = UserType::BEHAVIOR_TREE_CORE_HANDLE;
+            break;
+        default:
+            break;
+        }
+    }
+
+    switch (full_name_hash) {
+    case "System.String"_fnv:
+        new_info.kind = MarshalKind::STRING;
+        break;
+    case "System.Single"_fnv:
+        new_info.kind = MarshalKind::SINGLE;
+        break;
+    case "System.Boolean"_fnv:
+        new_info.kind = MarshalKind::BOOLEAN;
+        break;
+    case "System.SByte"_fnv:
+        new_info.kind = MarshalKind::SBYTE;
+        break;
+    case "System.Byte"_fnv:
+        new_info.kind = MarshalKind::BYTE;
+        break;
+    case "System.Int16"_fnv:
+        new_info.kind = MarshalKind::INT16;
+        break;
+    case "System.UInt16"_fnv:
+        new_info.kind = MarshalKind::UINT16;
+        break;
+    case "System.UInt32"_fnv:
+        new_info.kind = MarshalKind::UINT32;
+        break;
+    case "System.Int32"_fnv:
+        new_info.kind = MarshalKind::INT32;
+        break;
+    case "System.Int64"_fnv:
+        new_info.kind = MarshalKind::INT64;
+        break;
+    case "System.UInt64"_fnv:
+        new_info.kind = MarshalKind::UINT64;
+        break;
+    case "via.Float2"_fnv: [[fallthrough]];
+    case "via.vec2"_fnv:
+        new_info.kind = MarshalKind::VEC2;
+        break;
+    case "via.Float3"_fnv: [[fallthrough]];
+    case "via.vec3"_fnv:
+        new_info.kind = MarshalKind::VEC3;
+        break;
+    case "via.Float4"_fnv: [[fallthrough]];
+    case "via.vec4"_fnv:
+        new_info.kind = MarshalKind::VEC4;
+        break;
+    case "via.mat4"_fnv:
+        new_info.kind = MarshalKind::MAT4;
+        break;
+    case "via.Quaternion"_fnv:
+        new_info.kind = MarshalKind::QUATERNION;
+        break;
+    case "via.GameObjectRef"_fnv:
+        new_info.kind = MarshalKind::GAMEOBJECTREF;
+        break;
+    default: {
+        const auto vm_obj_type = data_type->get_vm_obj_type();
+
+        if (vm_obj_type > via::clr::VMObjType::NULL_ && vm_obj_type < via::clr::VMObjType::ValType) {
+            new_info.kind = vm_obj_type == via::clr::VMObjType::Array ? MarshalKind::ARRAY : MarshalKind::OBJECT;
+        } else if (new_info.is_value_type) {
+            new_info.kind = MarshalKind::VALUETYPE;
+        } else {
+            new_info.kind = MarshalKind::UNKNOWN;
+        }
+
+        break;
+    }
+    }
+
+    return new_info;
+}
+
+enum MarshalInfoState : uint8_t {
+    EMPTY,
+    WRITING,
+    READY,
+};
+}
+
+const MarshalInfo& get_marshal_info(::sdk::RETypeDefinition* data_type) {
+    // Dense, indexed by the type's TDB index. Allocated once up front so references stay valid.
+    // Entries are filled in by whichever thread asks first (hooks run on game threads), and only
+    // read once their state has been published as READY.
+    static const auto num_types = ::sdk::RETypeDB::get()->numTypes;
+    static auto marshal_infos = std::make_unique<MarshalInfo[]>(num_types);
+    static auto states = std::make_unique<std::atomic<uint8_t>[]>(num_types);
+    thread_local MarshalInfo out_of_range_info{};
+
+    const auto index = data_type->get_index();
+
+    if (index >= num_types) {
+        if (out_of_range_info.type != data_type) {
+            out_of_range_info = detail::build_marshal_info(data_type);
         }
 
-        size_t full_name_hash{};
+        return out_of_range_info;
+    }
+
+    auto& state = states[index];
 
-        // Slightly different logic for enums
-        if (data_type->is_enum()) {
-            auto underlying_type = data_type->get_underlying_type();
+    while (state.load(std::memory_order_acquire) != detail::READY) {
+        uint8_t expected = detail::EMPTY;
 
-            if (underlying_type != nullptr) {
-                full_name_hash = utility::hash(underlying_type->get_full_name());
+        if (state.compare_exchange_strong(expected, detail::WRITING, std::memory_order_acquire)) {
+            try {
+                marshal_infos[index] = detail::build_marshal_info(data_type);
+            } catch (...) {
+                // Hand it back so the next caller tries again, instead of everyone waiting on a write that never lands.
+                state.store(detail::EMPTY, std::memory_order_release);
+                throw;
             }
-        } else {
-            full_name_hash = utility::hash(data_type->get_full_name());
+
+            state.store(detail::READY, std::memory_order_release);
+            break;
         }
 
-        const auto vm_obj_type = data_type->get_vm_obj_type();
+        // Another thread is filling it in, which doesn't take long. If that fails, the entry goes back
+        // to EMPTY and this thread has a go itself.
+        while (state.load(std::memory_order_acquire) == detail::WRITING) {
+            std::this_thread::yield();
+        }
+    }
 
-        switch (full_name_hash) {
-        case "System.String"_fnv: {
+    return marshal_infos[index];
+}
+
+sol::object parse_data(lua_State* l, void* data, ::sdk::RETypeDefinition* data_type, bool from_method) {
+    if (data_type != nullptr) {
+        const auto& info = get_marshal_info(data_type);
+
+        if (!info.is_value_type) {
+            if (data == nullptr || *(void**)data == nullptr) {
+                return sol::make_object(l, sol::nil);
+            }
+        }
+
+        switch (info.kind) {
+        case MarshalKind::STRING: {
             const auto managed_ret_val = *(::REManagedObject**)data;
             const auto managed_str = (SystemString*)((uintptr_t)utility::re_managed_object::get_field_ptr(managed_ret_val) - sizeof(::REManagedObject));
             const auto str = utility::narrow(managed_str->data);
 
             return sol::make_object(l, str);
         }
-        case "System.Single"_fnv: {
+        case MarshalKind::SINGLE: {
             if (from_method) {
                 // even though it's a single, it's actually a double because of the invoke wrapper conversion
                 auto ret_val_f = *(double*)data;
@@ -703,66 +1161,63 @@ sol::object parse_data(lua_State* l, void* data, ::sdk::RETypeDefinition* data_t
                 return sol::make_object(l, ret_val_f);
             }
         }
-        case "System.Boolean"_fnv: {
+        case MarshalKind::BOOLEAN: {
             auto ret_val_b = *(bool*)data;
             return sol::make_object(l, ret_val_b);
         }
-        case "System.SByte"_fnv: {
+        case MarshalKind::SBYTE: {
             auto ret_val_i = *(int8_t*)data;
             return sol::make_object(l, ret_val_i);
         }
-        case "System.Byte"_fnv: {
+        case MarshalKind::BYTE: {
             auto ret_val_b = *(uint8_t*)data;
             return sol::make_object(l, ret_val_b);
         }
-        case "System.Int16"_fnv: {
+        case MarshalKind::INT16: {
             auto ret_val_i = *(int16_t*)data;
             return sol::make_object(l, ret_val_i);
         }
-        case "System.UInt16"_fnv: {
+        case MarshalKind::UINT16: {
             auto ret_val_i = *(uint16_t*)data;
             return sol::make_object(l, ret_val_i);
         }
-        case "System.UInt32"_fnv: {
+        case MarshalKind::UINT32: {
             auto ret_val_u = *(uint32_t*)data;
             return sol::make_object(l, ret_val_u);
         }
-        case "System.Int32"_fnv: {
+        case MarshalKind::INT32: {
             auto ret_val_u = *(int32_t*)data;
             return sol::make_object(l, ret_val_u);
         }
-        case "System.Int64"_fnv: {
+        case MarshalKind::INT64: {
             auto ret_val_u = *(int64_t*)data;
             return sol::make_object(l, ret_val_u);
         }
-        case "System.UInt64"_fnv: {
+        case MarshalKind::UINT64: {
             auto ret_val_u = *(uint64_t*)data;
             return sol::make_object(l, ret_val_u);
         }
-        case "via.Float2"_fnv: [[fallthrough]];
-        case "via.vec2"_fnv: {
+        case MarshalKind::VEC2: {
             auto ret_val_v = *(Vector2f*)data;
             return sol::make_object<Vector2f>(l, ret_val_v);
         }
-        case "via.Float3"_fnv: [[fallthrough]];
-        case "via.vec3"_fnv: {
+        case MarshalKind::VEC3: {
             auto ret_val_v = *(Vector3f*)data;
             return sol::make_object<Vector3f>(l, ret_val_v);
         }
-        case "via.Float4"_fnv: [[fallthrough]];
-        case "via.vec4"_fnv: {
+        case MarshalKind::VEC4: {
             auto ret_val_v = *(Vector4f*)data;
             return sol::make_object<Vector4f>(l, ret_val_v);
         }
-        case "via.mat4"_fnv: {
+        case MarshalKind::MAT4: {
             auto ret_val_m = *(Matrix4x4f*)data;
             return sol::make_object<Matrix4x4f>(l, ret_val_m);
         }
-        case "via.Quaternion"_fnv: {
+        case MarshalKind::QUATERNION: {
             auto ret_val_q = *(glm::quat*)data;
             return sol::make_object<glm::quat>(l, ret_val_q);
         }
-        case "via.GameObjectRef"_fnv: {
+        case MarshalKind::GAMEOBJECTREF: {
             static auto object_ref_type = ::sdk::find_type_definition("via.GameObjectRef");
             static auto get_target_func = object_ref_type->get_method("get_Target");
             auto obj = get_target_func->call<::REManagedObject*>(sdk::get_thread_context(), data);
@@ -773,35 +1228,25 @@ sol::object parse_data(lua_State* l, void* data, ::sdk::RETypeDefinition* data_t
 
             return sol::make_object(l, obj);
         }
-        default:
-            if (vm_obj_type > via::clr::VMObjType::NULL_ && vm_obj_type < via::clr::VMObjType::ValType) {
-                switch (vm_obj_type) {
-                case via::clr::VMObjType::Array:
-                    return sol::make_object(l, *(::sdk::SystemArray**)data);
-                default: {
-                    const auto td = utility::re_managed_object::get_type_definition(*(::REManagedObject**)data);
-
-                    // another fallback incase the method returns an object which is an array
-                    if (td != nullptr && td->get_vm_obj_type() == via::clr::VMObjType::Array) {
-                        return sol::make_object(l, *(::sdk::SystemArray**)data);
-                    }
-
-                    return sol::make_object(l, *(::REManagedObject**)data);
-                }
-                }
+        case MarshalKind::ARRAY:
+            return sol::make_object(l, *(::sdk::SystemArray**)data);
+        case MarshalKind::OBJECT: {
+            const auto td = utility::re_managed_object::get_type_definition(*(::REManagedObject**)data);
+
+            // another fallback incase the method returns an object which is an array
+            if (td != nullptr && td->get_vm_obj_type() == via::clr::VMObjType::Array) {
+                return sol::make_object(l, *(::sdk::SystemArray**)data);
             }
-            break;
-        }
-
-        // so, we managed to get here, but we don't know what to do with the data
-        // check if it's a valuetype first
-        if (data_type->is_value_type()) {
-            auto new_obj = sol::make_object(l, ValueType{ data_type });
-            auto& bytes = new_obj.as<ValueType&>();
-            
-            memcpy(bytes.data.data(), data, data_type->get_size());
 
-            return new_obj;
+            return sol::make_object(l, *(::REManagedObject**)data);
+        }
+        case MarshalKind::VALUETYPE: {
+            // so, we managed to get here, but we don't know what to do with the data
+            // so we copy it into a ValueType
+            return sol::make_object<ValueType>(l, data_type, data, info.size);
+        }
+        default:
+            break;
         }
     }
 
@@ -816,87 +1261,76 @@ sol::object parse_data(lua_State* l, void* data, ::sdk::RETypeDefinition* data_t
 
 void set_data(void* data, ::sdk::RETypeDefinition* data_type, sol::object& value) {
     if (data_type != nullptr) {
-        size_t full_name_hash{};
-        const auto vm_obj_type = data_type->get_vm_obj_type();
-
-        if (data_type->is_enum()) {
-            auto underlying_type = data_type->get_underlying_type();
-
-            if (underlying_type != nullptr) {
-                full_name_hash = utility::hash(underlying_type->get_full_name());
-            }
-        } else {
-            full_name_hash = utility::hash(data_type->get_full_name());
-        }
+        const auto& info = get_marshal_info(data_type);
 
-        switch (full_name_hash) {
-        case "System.Single"_fnv:
+        switch (info.kind) {
+        case MarshalKind::SINGLE:
             *(float*)data = value.as<float>();
             return;
-        case "System.Boolean"_fnv:
+        case MarshalKind::BOOLEAN:
             *(bool*)data = value.as<bool>();
             return;
-        case "System.SByte"_fnv:
+        case MarshalKind::SBYTE:
             *(int8_t*)data = value.as<int8_t>();
             return;
-        case "System.Byte"_fnv:
+        case MarshalKind::BYTE:
             *(uint8_t*)data = value.as<uint8_t>();
             return;
-        case "System.Int16"_fnv:
+        case MarshalKind::INT16:
             *(int16_t*)data = value.as<int16_t>();
             return;
-        case "System.UInt16"_fnv:
+        case MarshalKind::UINT16:
             *(uint16_t*)data = value.as<uint16_t>();
             return;
-        case "System.UInt32"_fnv:
+        case MarshalKind::UINT32:
             *(uint32_t*)data = value.as<uint32_t>();
             return;
-        case "System.Int32"_fnv:
+        case MarshalKind::INT32:
             *(int32_t*)data = value.as<int32_t>();
             return;
-        case "System.Int64"_fnv:
+        case MarshalKind::INT64:
             *(int64_t*)data = value.as<int32_t>();
             return;
-        case "System.UInt64"_fnv:
+        case MarshalKind::UINT64:
             *(uint64_t*)data = value.as<int32_t>();
             return;
-        case "via.Float2"_fnv: [[fallthrough]];
-        case "via.vec2"_fnv:
+        case MarshalKind::VEC2:
             *(Vector2f*)data = value.as<Vector2f>();
             return;
-        case "via.Float3"_fnv: [[fallthrough]];
-        case "via.vec3"_fnv:
+        case MarshalKind::VEC3:
             *(Vector3f*)data = value.as<Vector3f>();
             return;
-        case "via.Float4"_fnv: [[fallthrough]];
-        case "via.vec4"_fnv:
+        case MarshalKind::VEC4:
             *(Vector4f*)data = value.as<Vector4f>();
             return;
-        case "via.mat4"_fnv:
+        case MarshalKind::MAT4:
             *(Matrix4x4f*)data = value.as<Matrix4x4f>();
             return;
-        case "via.Quaternion"_fnv:
+        case MarshalKind::QUATERNION:
             *(glm::quat*)data = value.as<glm::quat>();
             return;
-        default:
-            if (vm_obj_type > via::clr::VMObjType::NULL_ && vm_obj_type < via::clr::VMObjType::ValType) {
-                REManagedObject* new_data;
-                if (value.is<const char*>()) {
-                    new_data = ::sdk::VM::create_managed_string(utility::widen(value.as<const char*>()));
-                } else {
-                    new_data = value.as<::REManagedObject*>();
-                }
+        case MarshalKind::STRING: [[fallthrough]];
+        case MarshalKind::ARRAY: [[fallthrough]];
+        case MarshalKind::OBJECT: {
+            REManagedObject* new_data;
+            if (value.is<const char*>()) {
+                new_data = ::sdk::VM::create_managed_string(utility::widen(value.as<const char*>()));
+            } else {
+                new_data = value.as<::REManagedObject*>();
+            }
 
-                REManagedObject** field = (REManagedObject**) data;
-                if (field != nullptr && *field != nullptr) {
-                    utility::re_managed_object::release(*field);
-                }
-                if (new_data != nullptr) {
-                    utility::re_managed_object::add_ref(new_data);
-                }
-                *(REManagedObject**) data = new_data;
-                return;
+            REManagedObject** field = (REManagedObject**) data;
+            if (field != nullptr && *field != nullptr) {
+                utility::re_managed_object::release(*field);
             }
+            if (new_data != nullptr) {
+                utility::re_managed_object::add_ref(new_data);
+            }
+            *(REManagedObject**) data = new_data;
+            return;
+        }
+        default:
+            break;
         }
     }
 
@@ -1083,6 +1517,41 @@ sol::object get_primary_camera(sol::this_state s) {
     return sol::make_object(s, (::REManagedObject*)::sdk::get_primary_camera());
 }
 
+// Every transform in the scene, optionally only the ones whose game object has a component of type_obj.
+// Returns a view rather than a table of tables, so a script that only looks at a few entries only pays for those.
+SceneView get_scene_snapshot(sol::object type_obj) {
+    ::REType* component_type{nullptr};
+
+    if (type_obj.is<::sdk::RETypeDefinition*>()) {
+        component_type = type_obj.as<::sdk::RETypeDefinition*>()->get_type();
+    } else if (type_obj.is<const char*>()) {
+        const auto tdef = ::sdk::find_type_definition(type_obj.as<const char*>());
+
+        if (tdef == nullptr) {
+            throw sol::error("Type passed to get_scene_snapshot does not exist.");
+        }
+
+        component_type = tdef->get_type();
+    } else if (type_obj.valid() && !type_obj.is<sol::nil_t>()) {
+        throw sol::error("Invalid type passed to get_scene_snapshot. Must be a type definition or a type name.");
+    }
+
+    SceneView view{};
+    view.scene = ::sdk::get_scene_snapshot();
+
+    if (component_type != nullptr) {
+        const auto& entries = view.scene->get_entries();
+
+        view.filtered = true;
+        view.scene->for_each_with_component(component_type, [&](const ::sdk::SceneEntry& entry, ::REComponent* component) {
+            view.indices.push_back((uint32_t)(&entry - entries.data()));
+            view.components.push_back(component);
+        });
+    }
+
+    return view;
+}
+
 bool is_managed_object(sol::object obj) {
     auto real_obj = get_real_obj(obj);
 
@@ -1098,32 +1567,393 @@ void hook(sol::this_state s, ::sdk::REMethodDefinition* fn, sol::protected_funct
     auto state = sol_state.registry()["state"].get<ScriptState*>();
     state->add_hook(fn, pre_cb, post_cb, ignore_jmp_object);
 }
+
+void hook_observer(sol::this_state s, ::sdk::REMethodDefinition* fn, sol::protected_function pre_cb, sol::protected_function post_cb, sol::object ignore_jmp_object) {
+    auto sol_state = sol::state_view{s};
+    auto state = sol_state.registry()["state"].get<ScriptState*>();
+    state->add_observer(fn, pre_cb, post_cb, ignore_jmp_object);
+}
+
+void* to_ptr(sol::object obj) {
+    if (obj.is<int64_t>()) {
+        const auto n = obj.as<int64_t>();
+        return *(void**)&n;
+    } else if (obj.is<::REManagedObject*>()) {
+        return (void*)obj.as<::REManagedObject*>();
+    } else if (obj.is<double>()) {
+        const auto n = obj.as<double>();
+        return *(void**)&n;
+    } else if (obj.is<bool>()) {
+        const auto n = (uintptr_t)obj.as<bool>();
+        return *(void**)&n;
+    } else {
+        return obj.as<void*>();
+    }
+}
+}
+
+namespace api::hook_args {
+void check_in_call(const api::sdk::HookArgs& view) {
+    if (view.args == nullptr) {
+        throw sol::error("args used outside its hook call");
+    }
+}
+
+// Lua indices are 1-based: 1 is the thread context, 2 is "this" for instance methods, followed by the parameters.
+bool is_valid_index(const api::sdk::HookArgs& view, lua_Integer i) {
+    check_in_call(view);
+    return i >= 1 && i <= (lua_Integer)view.args->size();
+}
+
+::sdk::RETypeDefinition* get_type(api::sdk::HookArgs& view, int32_t i) {
+    if (!is_valid_index(view, i) || view.fn == nullptr || i == 1) {
+        return nullptr;
+    }
+
+    const auto first_param = view.fn->is_static() ? 2 : 3;
+
+    if (i < first_param) {
+        return view.fn->get_declaring_type();
+    }
+
+    const auto param = (size_t)(i - first_param);
+
+    if (view.arg_tys == nullptr || param >= view.arg_tys->size()) {
+        return nullptr;
+    }
+
+    return (*view.arg_tys)[param];
+}
+
+sol::object get_value(sol::this_state s, api::sdk::HookArgs& view, int32_t i) {
+    if (!is_valid_index(view, i)) {
+        return sol::make_object(s, sol::nil);
+    }
+
+    auto& arg = (*view.args)[i - 1];
+    const auto ty = get_type(view, i);
+
+    if (ty == nullptr) {
+        return sol::make_object(s, (void*)arg);
+    }
+
+    // larger value types are passed by pointer
+    if (ty->is_value_type() && ty->get_valuetype_size() > sizeof(void*)) {
+        return api::sdk::parse_data(s, (void*)arg, ty, false);
+    }
+
+    return api::sdk::parse_data(s, &arg, ty, false);
+}
+
+sol::object get_object(sol::this_state s, api::sdk::HookArgs& view, int32_t i) {
+    if (!is_valid_index(view, i)) {
+        return sol::make_object(s, sol::nil);
+    }
+
+    const auto obj = (::REManagedObject*)(*view.args)[i - 1];
+
+    if (obj == nullptr || !utility::re_managed_object::is_managed_object(obj)) {
+        return sol::make_object(s, sol::nil);
+    }
+
+    return sol::make_object(s, obj);
+}
+
+// Pushes the table holding the view's other keys for the current call. Returns false with nothing pushed
+// when there isn't one yet and create is false.
+bool push_extra(lua_State* l, api::sdk::HookArgs& view, bool create) {
+    if (view.extra_call == view.call) {
+        if (lua_getiuservalue(l, 1, 1) == LUA_TTABLE) {
+            return true;
+        }
+
+        lua_pop(l, 1);
+    }
+
+    if (!create) {
+        return false;
+    }
+
+    lua_newtable(l);
+    lua_pushvalue(l, -1);
+    lua_setiuservalue(l, 1, 1);
+    view.extra_call = view.call;
+
+    return true;
+}
+
+int index(lua_State* l) {
+    auto& view = sol::stack::get<api::sdk::HookArgs&>(l, 1);
+    const auto i = lua_isinteger(l, 2) ? lua_tointeger(l, 2) : 0;
+
+    if (is_valid_index(view, i)) {
+        lua_pushlightuserdata(l, (void*)(*view.args)[i - 1]);
+        return 1;
+    }
+
+    if (!push_extra(l, view, false)) {
+        lua_pushnil(l);
+        return 1;
+    }
+
+    lua_pushvalue(l, 2);
+    lua_rawget(l, -2);
+
+    return 1;
+}
+
+int new_index(lua_State* l) {
+    auto& view = sol::stack::get<api::sdk::HookArgs&>(l, 1);
+    const auto i = lua_isinteger(l, 2) ? lua_tointeger(l, 2) : 0;
+
+    if (!is_valid_index(view, i)) {
+        push_extra(l, view, true);
+        lua_pushvalue(l, 2);
+        lua_pushvalue(l, 3);
+        lua_rawset(l, -3);
+
+        return 0;
+    }
+
+    if (lua_type(l, 3) == LUA_TLIGHTUSERDATA) {
+        (*view.args)[i - 1] = (uintptr_t)lua_touserdata(l, 3);
+    } else {
+        (*view.args)[i - 1] = (uintptr_t)api::sdk::to_ptr(sol::stack::get<sol::object>(l, 3));
+    }
+
+    return 0;
+}
+
+// __pairs: the arguments in order, then the other keys.
+int next(lua_State* l) {
+    auto& view = sol::stack::get<api::sdk::HookArgs&>(l, 1);
+    check_in_call(view);
+
+    const auto size = (lua_Integer)view.args->size();
+    const auto in_args = lua_isnil(l, 2) || (lua_isinteger(l, 2) && is_valid_index(view, lua_tointeger(l, 2)));
+
+    if (in_args) {
+        const auto i = lua_isnil(l, 2) ? 1 : lua_tointeger(l, 2) + 1;
+
+        if (i <= size) {
+            lua_pushinteger(l, i);
+            lua_pushlightuserdata(l, (void*)(*view.args)[i - 1]);
+            return 2;
+        }
+    }
+
+    if (!push_extra(l, view, false)) {
+        lua_pushnil(l);
+        return 1;
+    }
+
+    if (in_args) {
+        lua_pushnil(l);
+    } else {
+        lua_pushvalue(l, 2);
+    }
+
+    if (lua_next(l, -2) != 0) {
+        return 2;
+    }
+
+    lua_pushnil(l);
+    return 1;
+}
+
+int pairs(lua_State* l) {
+    lua_pushcfunction(l, &next);
+    lua_pushvalue(l, 1);
+    lua_pushnil(l);
+    return 3;
+}
+
+int length(lua_State* l) {
+    auto& view = sol::stack::get<api::sdk::HookArgs&>(l, 1);
+    check_in_call(view);
+
+    lua_pushinteger(l, (lua_Integer)view.args->size());
+    return 1;
+}
+}
+
+namespace api::scene_view {
+using SceneView = api::sdk::SceneView;
+
+sol::object get_transform(sol::this_state s, const SceneView& view, lua_Integer i) {
+    const auto entry = view.get(i);
+    return entry != nullptr ? sol::make_object(s, (::REManagedObject*)entry->transform) : sol::make_object(s, sol::nil);
+}
+
+sol::object get_game_object(sol::this_state s, const SceneView& view, lua_Integer i) {
+    const auto entry = view.get(i);
+    return entry != nullptr ? sol::make_object(s, (::REManagedObject*)entry->game_object) : sol::make_object(s, sol::nil);
+}
+
+sol::object get_component(sol::this_state s, const SceneView& view, lua_Integer i) {
+    ::REComponent* component{nullptr};
+    view.get(i, &component);
+    return sol::make_object(s, (::REManagedObject*)component);
+}
+
+sol::object get_position(sol::this_state s, const SceneView& view, lua_Integer i) {
+    const auto entry = view.get(i);
+    return entry != nullptr ? sol::make_object(s, entry->position) : sol::make_object(s, sol::nil);
+}
+
+sol::object get_depth(sol::this_state s, const SceneView& view, lua_Integer i) {
+    const auto entry = view.get(i);
+    return entry != nullptr ? sol::make_object(s, entry->depth) : sol::make_object(s, sol::nil);
+}
+
+bool is_valid(const SceneView& view) {
+    return view.scene->is_current();
+}
+
+// view[i] builds the same table a snapshot entry used to be, for scripts that want all of it.
+int index(lua_State* l) {
+    auto& view = sol::stack::get<SceneView&>(l, 1);
+
+    if (!lua_isinteger(l, 2)) {
+        lua_pushnil(l);
+        return 1;
+    }
+
+    ::REComponent* component{nullptr};
+    const auto entry = view.get(lua_tointeger(l, 2), &component);
+
+    if (entry == nullptr) {
+        lua_pushnil(l);
+        return 1;
+    }
+
+    sol::state_view lua{l};
+    auto t = lua.create_table(0, 5);
+    t["transform"] = sol::make_object(l, (::REManagedObject*)entry->transform);
+    t["game_object"] = sol::make_object(l, (::REManagedObject*)entry->game_object);
+    t["component"] = sol::make_object(l, (::REManagedObject*)component);
+    t["position"] = entry->position;
+    t["depth"] = entry->depth;
+
+    t.push();
+    return 1;
+}
+
+int length(lua_State* l) {
+    auto& view = sol::stack::get<SceneView&>(l, 1);
+
+    lua_pushinteger(l, (lua_Integer)view.size());
+    return 1;
+}
 }
 
 namespace api::re_managed_object {
+namespace detail {
+void reset_member_cache(lua_State* l) {
+    get_caches(l).members.clear();
+
+    lua_newtable(l);
+    lua_setfield(l, LUA_REGISTRYINDEX, "_member_cache_keys");
+}
+
+MemberCacheEntry resolve_member(::sdk::RETypeDefinition* type_def, const char* name) {
+    MemberCacheEntry entry{};
+
+    if (name != nullptr) {
+        entry.field = type_def->get_field(name);
+
+        if (entry.field == nullptr) {
+            entry.method = type_def->get_method(name);
+        }
+    }
+
+    entry.get_item = type_def->get_method("get_Item");
+    entry.set_item = type_def->get_method("set_Item");
+
+    return entry;
+}
+
+// Resolves the member for the key at stack index idx, going through the state's cache when possible.
+// The ScriptState lock is held during __index/__newindex, so the cache itself is not locked.
+const MemberCacheEntry& get_member(lua_State* l, ::sdk::RETypeDefinition* type_def, int idx, const char*& name) {
+    static thread_local MemberCacheEntry uncached_entry{};
+
+    auto& cache = get_caches(l).members;
+
+    name = nullptr;
+    size_t len{};
+
+    if (lua_type(l, idx) == LUA_TSTRING) {
+        name = lua_tolstring(l, idx, &len);
+    }
+
+    // long strings aren't interned, so their address can't be used as a key.
+    const bool cacheable = len <= LUAI_MAXSHORTLEN;
+    const auto key = MemberCacheKey{type_def->get_index(), name};
+
+    if (cacheable) {
+        if (auto it = cache.find(key); it != cache.end()) {
+            return it->second;
+        }
+    }
+
+    // get_Item/set_Item, shared by every key of the type. Also all that non-string keys resolve to.
+    const auto item_key = MemberCacheKey{type_def->get_index(), nullptr};
+    auto item_it = cache.find(item_key);
+
+    if (item_it == cache.end()) {
+        item_it = cache.emplace(item_key, resolve_member(type_def, nullptr)).first;
+    }
+
+    if (name == nullptr) {
+        return item_it->second;
+    }
+
+    auto entry = item_it->second;
+    entry.field = type_def->get_field(name);
+
+    if (entry.field == nullptr) {
+        entry.method = type_def->get_method(name);
+    }
+
+    // Keys that aren't members (e.g. dictionary keys going to get_Item) aren't cached,
+    // otherwise the cache and the anchored strings would grow with every key a script uses.
+    if (!cacheable || (entry.field == nullptr && entry.method == nullptr)) {
+        uncached_entry = entry;
+        return uncached_entry;
+    }
+
+    // anchor the string so it can't be collected and have its address reused by a different string.
+    lua_getfield(l, LUA_REGISTRYINDEX, "_member_cache_keys");
+    lua_pushvalue(l, idx);
+    lua_pushboolean(l, true);
+    lua_rawset(l, -3);
+    lua_pop(l, 1);
+
+    return cache.emplace(key, entry).first->second;
+}
+}
+
 sol::object index(sol::this_state s, sol::object lua_obj, sol::variadic_args args) {
     auto obj = lua_obj.as<REManagedObject*>();
     if (obj == nullptr) {
         throw sol::error("Attempted to index invalid REManagedObject");
     }
-    auto index = args[0];
 
     auto type_def = utility::re_managed_object::get_type_definition(obj);
-    std::string name;
-    if (index.is<const char*>()) {
-        name = index.as<const char*>();
-        auto field = type_def->get_field(name.c_str());
-        if (field != nullptr) {
-            return api::sdk::get_native_field_from_field(lua_obj, type_def, field);
-        }
-        auto method = type_def->get_method(name.c_str());
-        if (method != nullptr) {
-            return sol::make_object(s, method);
-        }
+    const char* name{nullptr};
+    const auto& member = detail::get_member(s, type_def, args[0].stack_index(), name);
+
+    if (member.field != nullptr) {
+        return api::sdk::get_native_field_from_field(lua_obj, type_def, member.field);
+    }
+
+    if (member.method != nullptr) {
+        return sol::make_object(s, member.method);
     }
 
-    if (auto fn = type_def->get_method("get_Item"); fn != nullptr) {
-        return ::api::sdk::call_native_func_direct(lua_obj, fn, args);
+    if (member.get_item != nullptr) {
+        return ::api::sdk::call_native_func_direct(lua_obj, member.get_item, args);
     }
 
     //throw sol::error("Attempted to index invalid REManagedObject field: " + name);
@@ -1136,25 +1966,22 @@ void new_index(sol::this_state s, sol::object lua_obj, sol::variadic_args args)
         throw sol::error("Attempted to new_index invalid REManagedObject");
     }
 
-    auto index = args[0];
     auto assign = args[1];
 
     auto type_def = utility::re_managed_object::get_type_definition(obj);
-    std::string name;
-    if (index.is<const char*>()) {
-        name = index.as<const char*>();
-        auto field = type_def->get_field(name.c_str());
+    const char* name{nullptr};
+    const auto& member = detail::get_member(s, type_def, args[0].stack_index(), name);
 
-        if (field != nullptr) {
-            return api::sdk::set_native_field_from_field(lua_obj, type_def, field, assign);
-        }
+    if (member.field != nullptr) {
+        return api::sdk::set_native_field_from_field(lua_obj, type_def, member.field, assign);
     }
 
-    if (auto fn = type_def->get_method("set_Item"); fn != nullptr) {
-        ::api::sdk::call_native_func_direct(lua_obj, fn, args);
+    if (member.set_item != nullptr) {
+        ::api::sdk::call_native_func_direct(lua_obj, member.set_item, args);
         return;
     }
-    throw sol::error("Attempted to new_index invalid REManagedObject field: " + name);
+
+    throw sol::error("Attempted to new_index invalid REManagedObject field: " + std::string{name != nullptr ? name : ""});
 }
 
 bool is_valid_offset(::REManagedObject* obj, int32_t offset) {
@@ -1201,15 +2028,248 @@ T read_memory(::REManagedObject* obj, int32_t offset) {
 }
 } 
 
+// Bulk versions of read_*/write_* for REManagedObject, ValueType and MemoryView. The bounds are checked once for
+// the whole range, so a matrix or a joint array costs one call instead of dozens. Like the scalar versions,
+// an out of bounds read returns nil and an out of bounds write does nothing.
+namespace api::memory_block {
+namespace detail {
+// Caps a single bulk read at something no script should need, and keeps offset + size well inside int32_t.
+constexpr size_t MAX_BLOCK_SIZE = 0x100000;
+
+uint8_t* get_range(::REManagedObject* obj, int32_t offset, size_t size) {
+    if (size == 0 || size > MAX_BLOCK_SIZE) {
+        return nullptr;
+    }
+
+    if (!api::re_managed_object::is_valid_offset(obj, offset) || !api::re_managed_object::is_valid_offset(obj, offset + (int32_t)size - 1)) {
+        return nullptr;
+    }
+
+    return (uint8_t*)obj + offset;
+}
+
+uint8_t* get_range(api::sdk::ValueType& obj, int32_t offset, size_t size) {
+    if (size == 0 || size > MAX_BLOCK_SIZE || offset < 0 || (size_t)offset + size > obj.data.size()) {
+        return nullptr;
+    }
+
+    return obj.data.data() + offset;
+}
+
+uint8_t* get_range(api::sdk::MemoryView& obj, int32_t offset, size_t size) {
+    if (size == 0 || size > MAX_BLOCK_SIZE || offset < 0 || (size_t)offset + size > obj.size) {
+        return nullptr;
+    }
+
+    return obj.data + offset;
+}
+}
+
+// Fills out (or a new table) with count values starting at offset. Passing the same table every frame avoids the allocation.
+template <typename Self, typename T>
+sol::object read_array(sol::this_state l, Self obj, int32_t offset, uint32_t count, sol::object out) {
+    const auto p = detail::get_range(obj, offset, (size_t)count * sizeof(T));
+
+    if (p == nullptr) {
+        return sol::make_object(l, sol::nil);
+    }
+
+    auto tbl = out.is<sol::table>() ? out.as<sol::table>() : sol::state_view{l}.create_table(count, 0);
+
+    tbl.push();
+
+    for (uint32_t i = 0; i < count; ++i) {
+        T value{};
+        memcpy(&value, p + i * sizeof(T), sizeof(T));
+
+        if constexpr (std::is_floating_point_v<T>) {
+            lua_pushnumber(l, (lua_Number)value);
+        } else {
+            lua_pushinteger(l, (lua_Integer)value);
+        }
+
+        lua_rawseti(l, -2, i + 1);
+    }
+
+    lua_pop(l, 1);
+
+    return tbl;
+}
+
+template <typename Self, typename T>
+void write_array(sol::this_state l, Self obj, int32_t offset, sol::table values) {
+    const auto count = values.size();
+    const auto p = detail::get_range(obj, offset, count * sizeof(T));
+
+    if (p == nullptr) {
+        return;
+    }
+
+    values.push();
+
+    for (size_t i = 0; i < count; ++i) {
+        lua_rawgeti(l, -1, i + 1);
+
+        T value{};
+
+        if constexpr (std::is_floating_point_v<T>) {
+            value = (T)lua_tonumber(l, -1);
+        } else {
+            value = (T)lua_tointeger(l, -1);
+        }
+
+        memcpy(p + i * sizeof(T), &value, sizeof(T));
+        lua_pop(l, 1);
+    }
+
+    lua_pop(l, 1);
+}
+
+template <typename Self, typename T>
+sol::object read_value(sol::this_state l, Self obj, int32_t offset) {
+    const auto p = detail::get_range(obj, offset, sizeof(T));
+
+    if (p == nullptr) {
+        return sol::make_object(l, sol::nil);
+    }
+
+    T value{};
+    memcpy(&value, p, sizeof(T));
+
+    return sol::make_object<T>(l, value);
+}
+
+template <typename Self, typename T>
+void write_value(Self obj, int32_t offset, const T& value) {
+    if (const auto p = detail::get_range(obj, offset, sizeof(T)); p != nullptr) {
+        memcpy(p, &value, sizeof(T));
+    }
+}
+
+// Same format strings as string.unpack, which does the actual decoding; this just hands it the bytes in one go.
+template <typename Self>
+sol::variadic_results read_struct(sol::this_state l, Self obj, int32_t offset, const char* fmt) {
+    sol::state_view lua{l};
+    sol::variadic_results out{};
+
+    sol::function packsize = lua["string"]["packsize"];
+    const auto size = packsize(fmt).template get<size_t>();
+    const auto p = detail::get_range(obj, offset, size);
+
+    if (p == nullptr) {
+        out.push_back(sol::make_object(l, sol::nil));
+        return out;
+    }
+
+    sol::function unpack = lua["string"]["unpack"];
+    auto results = unpack(fmt, std::string_view{(const char*)p, size});
+
+    // The last result is string.unpack's next position, which means nothing here.
+    for (auto i = 0; i + 1 < results.return_count(); ++i) {
+        out.push_back(results.template get<sol::object>(i));
+    }
+
+    return out;
+}
+
+template <typename Self>
+void write_struct(sol::this_state l, Self obj, int32_t offset, const char* fmt, sol::variadic_args args) {
+    sol::state_view lua{l};
+    sol::function pack = lua["string"]["pack"];
+    const std::string bytes = pack(fmt, args);
+
+    if (const auto p = detail::get_range(obj, offset, bytes.size()); p != nullptr) {
+        memcpy(p, bytes.data(), bytes.size());
+    }
+}
+
+// Calls fn with whichever block type obj is. Returns false if it isn't one.
+template <typename Fn>
+bool visit_block(sol::object obj, Fn&& fn) {
+    if (obj.is<api::sdk::ValueType>()) {
+        return fn(obj.as<api::sdk::ValueType&>());
+    }
+
+    if (obj.is<api::sdk::MemoryView>()) {
+        return fn(obj.as<api::sdk::MemoryView&>());
+    }
+
+    if (obj.is<::REManagedObject*>()) {
+        return fn(obj.as<::REManagedObject*>());
+    }
+
+    return false;
+}
+
+// Offsets for a boxed value type default to where its fields start, so copy_from(boxed) copies the value itself.
+int32_t get_default_offset(sol::object obj, sol::object offset) {
+    if (offset.is<int32_t>()) {
+        return offset.as<int32_t>();
+    }
+
+    if (obj.is<::REManagedObject*>()) {
+        const auto managed = obj.as<::REManagedObject*>();
+        return (int32_t)((uintptr_t)utility::re_managed_object::get_field_ptr(managed) - (uintptr_t)managed);
+    }
+
+    return 0;
+}
+
+// Overwrites an existing ValueType instead of creating a new one, so a script can reuse the same temporary every frame.
+bool copy_from(api::sdk::ValueType& self, sol::object src, sol::object offset_obj) {
+    const auto offset = get_default_offset(src, offset_obj);
+
+    return visit_block(src, [&](auto&& block) {
+        const auto p = detail::get_range(block, offset, self.data.size());
+
+        if (p == nullptr) {
+            return false;
+        }
+
+        // The source can be the same ValueType, or a view into it.
+        memmove(self.data.data(), p, self.data.size());
+        return true;
+    });
+}
+
+bool copy_to(api::sdk::ValueType& self, sol::object dst, sol::object offset_obj) {
+    const auto offset = get_default_offset(dst, offset_obj);
+
+    return visit_block(dst, [&](auto&& block) {
+        const auto p = detail::get_range(block, offset, self.data.size());
+
+        if (p == nullptr) {
+            return false;
+        }
+
+        memmove(p, self.data.data(), self.data.size());
+        return true;
+    });
+}
+
+template <typename Self, typename T>
+void add_accessors(sol::usertype<T>& type) {
+    type["read_floats"] = &read_array<Self, float>;
+    type["read_dwords"] = &read_array<Self, uint32_t>;
+    type["write_floats"] = &write_array<Self, float>;
+    type["write_dwords"] = &write_array<Self, uint32_t>;
+    type["read_vec3"] = &read_value<Self, Vector3f>;
+    type["read_vec4"] = &read_value<Self, Vector4f>;
+    type["read_mat4"] = &read_value<Self, Matrix4x4f>;
+    type["write_vec3"] = &write_value<Self, Vector3f>;
+    type["write_vec4"] = &write_value<Self, Vector4f>;
+    type["write_mat4"] = &write_value<Self, Matrix4x4f>;
+    type["read_struct"] = &read_struct<Self>;
+    type["write_struct"] = &write_struct<Self>;
+}
+}
+
 void bindings::open_sdk(ScriptState* s) {
     auto& lua = s->lua();
 
-    //lua["_sol_lua_push_objects"] = std::unordered_map<::REManagedObject*, sol::object>();
-    lua.do_string(R"(
-        _sol_lua_push_objects = setmetatable({}, { __mode = "v" })
-        _sol_lua_push_ref_counts = {}
-        _sol_lua_push_ephemeral_counts = {}
-    )");
+    api::re_managed_object::detail::register_caches(lua, s->get_sdk_caches());
+    api::re_managed_object::detail::reset_object_cache(lua);
+    api::re_managed_object::detail::reset_member_cache(lua);
 
     auto sdk = lua.create_table();
     sdk["get_tdb_version"] = []() -> int { return sdk::RETypeDB::get()->version; };
@@ -1238,7 +2298,9 @@ void bindings::open_sdk(ScriptState* s) {
     sdk["get_native_field"] = api::sdk::get_native_field;
     sdk["set_native_field"] = api::sdk::set_native_field;
     sdk["get_primary_camera"] = api::sdk::get_primary_camera;
+    sdk["get_scene_snapshot"] = api::sdk::get_scene_snapshot;
     sdk["hook"] = api::sdk::hook;
+    sdk["hook_observer"] = api::sdk::hook_observer;
     sdk.new_enum("PreHookResult", "CALL_ORIGINAL", HookManager::PreHookResult::CALL_ORIGINAL, "SKIP_ORIGINAL", HookManager::PreHookResult::SKIP_ORIGINAL);
     sdk["is_managed_object"] = api::sdk::is_managed_object;
     sdk["to_managed_object"] = [](sol::this_state s, sol::object ptr) { 
@@ -1276,22 +2338,7 @@ void bindings::open_sdk(ScriptState* s) {
     sdk["to_double"] = [](void* ptr) { return *(double*)&ptr; };
     sdk["to_float"] = [](void* ptr) { return *(float*)&ptr; };
     sdk["to_int64"] = [](void* ptr) { return *(int64_t*)&ptr; };
-    sdk["to_ptr"] = [](sol::object obj) {
-        if (obj.is<int64_t>()) {
-            const auto n = obj.as<int64_t>();
-            return *(void**)&n;
-        } else if (obj.is<::REManagedObject*>()) {
-            return (void*)obj.as<::REManagedObject*>();
-        } else if (obj.is<double>()) {
-            const auto n = obj.as<double>();
-            return *(void**)&n;
-        } else if (obj.is<bool>()) {
-            const auto n = (uintptr_t)obj.as<bool>();
-            return *(void**)&n;
-        } else {
-            return obj.as<void*>();
-        }
-    };
+    sdk["to_ptr"] = api::sdk::to_ptr;
     sdk["float_to_ptr"] = [](float f) {
         uintptr_t n = *(uintptr_t*)&f;
         return *(void**)&f;
@@ -1427,7 +2474,7 @@ void bindings::open_sdk(ScriptState* s) {
         }
     );
 
-    lua.new_usertype<::REManagedObject>("REManagedObject",
+    auto managed_object_type = lua.new_usertype<::REManagedObject>("REManagedObject",
         sol::meta_function::equal_to, [s](REManagedObject* lhs, REManagedObject* rhs) { return lhs == rhs; },
         sol::meta_function::index, &api::re_managed_object::index,
         sol::meta_function::new_index, &api::re_managed_object::new_index,
@@ -1498,11 +2545,14 @@ void bindings::open_sdk(ScriptState* s) {
         "read_double", &api::re_managed_object::read_memory<double>
     );
 
+    api::memory_block::add_accessors<::REManagedObject*>(managed_object_type);
+
     // templated lambda
     auto create_managed_object_ptr_gc = [&]<detail::ManagedObjectBased T>(T* obj) {
         lua["__REManagedObjectPtrInternalCreate"] = [s]() -> sol::object {
             return sol::make_object(s->lua(), (T*)detail::FAKE_OBJECT_ADDR);
         };
+        lua["__REManagedObjectPtrInternalGc"] = &api::re_managed_object::gc;
 
         lua.do_string(R"(
             local fake_obj = __REManagedObjectPtrInternalCreate()
@@ -1511,12 +2561,11 @@ void bindings::open_sdk(ScriptState* s) {
             fake_obj = nil
             collectgarbage("collect")
 
-            mt.__gc = function(obj)
-                obj:release()
-            end
+            mt.__gc = __REManagedObjectPtrInternalGc
         )");
 
         lua["__REManagedObjectPtrInternalCreate"] = sol::make_object(lua, sol::nil);
+        lua["__REManagedObjectPtrInternalGc"] = sol::make_object(lua, sol::nil);
     };
 
     create_managed_object_ptr_gc((::REManagedObject*)nullptr);
@@ -1568,6 +2617,47 @@ void bindings::open_sdk(ScriptState* s) {
         "get_size", &sdk::SystemArray::size,
         "get_element", &sdk::SystemArray::get_element,
         "get_elements", &sdk::SystemArray::get_elements,
+        "get_element_type", [](sdk::SystemArray* arr) -> sdk::RETypeDefinition* {
+            const auto layout = arr->get_layout();
+            return layout ? layout->element_type : nullptr;
+        },
+        "get_element_size", [](sdk::SystemArray* arr) -> uint32_t {
+            const auto layout = arr->get_layout();
+            return layout ? layout->element_size : 0;
+        },
+        // The element storage, for the bulk read_*/write_* functions. Only valid while the array itself is alive.
+        "get_data", [](sol::this_state l, sdk::SystemArray* arr) -> sol::object {
+            const auto layout = arr->get_layout();
+
+            if (!layout) {
+                return sol::make_object(l, sol::nil);
+            }
+
+            return sol::make_object(l, api::sdk::MemoryView{layout->data, (size_t)layout->count * layout->element_size});
+        },
+        // for i, element in arr:iter() do ... end
+        // Elements are read in place and converted the way fields are, so value types don't get boxed through the VM.
+        "iter", [](sol::this_state l, sdk::SystemArray* arr) {
+            const auto layout = arr->get_layout();
+            const auto count = layout ? layout->count : arr->size();
+
+            // Holding the array object keeps it alive for as long as the loop runs.
+            return sol::as_function([self = sol::make_object(l, arr), layout, count, i = 0](sol::this_state l) mutable -> std::tuple<sol::object, sol::object> {
+                if (i >= count) {
+                    return {sol::make_object(l, sol::nil), sol::make_object(l, sol::nil)};
+                }
+
+                const auto index = i++;
+
+                if (!layout) {
+                    return {sol::make_object(l, index), sol::make_object(l, self.as<sdk::SystemArray*>()->get_element(index))};
+                }
+
+                auto element = layout->data + (size_t)index * layout->element_size;
+
+                return {sol::make_object(l, index), api::sdk::parse_data(l, element, layout->element_type, false)};
+            });
+        },
         sol::meta_function::index, [](sol::this_state s, sdk::SystemArray* arr, sol::variadic_args args) {
             auto index = args[0];
             if (index.is<int32_t>()) {
@@ -1589,7 +2679,7 @@ void bindings::open_sdk(ScriptState* s) {
 
     create_managed_object_ptr_gc((sdk::SystemArray*)nullptr);
     
-    lua.new_usertype<api::sdk::ValueType>("ValueType",
+    auto value_type = lua.new_usertype<api::sdk::ValueType>("ValueType",
         sol::meta_function::construct, sol::constructors<api::sdk::ValueType(sdk::RETypeDefinition*)>(),
         sol::meta_function::index, &api::sdk::ValueType::index,
         sol::meta_function::new_index, &api::sdk::ValueType::new_index,
@@ -1615,7 +2705,32 @@ void bindings::open_sdk(ScriptState* s) {
         "get_type_definition", [](api::sdk::ValueType* b) { return b->type; }
     );
 
-    lua.new_usertype<api::sdk::MemoryView>("MemoryView",
+    api::memory_block::add_accessors<api::sdk::ValueType&>(value_type);
+    value_type["copy_from"] = &api::memory_block::copy_from;
+    value_type["copy_to"] = &api::memory_block::copy_to;
+
+    lua.new_usertype<api::sdk::SceneView>("SceneSnapshot",
+        sol::meta_function::index, &api::scene_view::index,
+        sol::meta_function::length, &api::scene_view::length,
+        "get_transform", &api::scene_view::get_transform,
+        "get_game_object", &api::scene_view::get_game_object,
+        "get_component", &api::scene_view::get_component,
+        "get_position", &api::scene_view::get_position,
+        "get_depth", &api::scene_view::get_depth,
+        "is_valid", &api::scene_view::is_valid
+    );
+
+    lua.new_usertype<api::sdk::HookArgs>("HookArgs",
+        sol::meta_function::index, &api::hook_args::index,
+        sol::meta_function::new_index, &api::hook_args::new_index,
+        sol::meta_function::length, &api::hook_args::length,
+        sol::meta_function::pairs, &api::hook_args::pairs,
+        "get_type", &api::hook_args::get_type,
+        "get_value", &api::hook_args::get_value,
+        "get_object", &api::hook_args::get_object
+    );
+
+    auto memory_view_type = lua.new_usertype<api::sdk::MemoryView>("MemoryView",
         "write_byte", &api::sdk::MemoryView::write_memory<uint8_t>,
         "write_short", &api::sdk::MemoryView::write_memory<uint16_t>,
         "write_dword", &api::sdk::MemoryView::write_memory<uint32_t>,
@@ -1632,6 +2747,8 @@ void bindings::open_sdk(ScriptState* s) {
         "get_address", &api::sdk::MemoryView::address
     );
 
+    api::memory_block::add_accessors<api::sdk::MemoryView&>(memory_view_type);
+
     lua.new_usertype<::sdk::Resource>("REResource",
         "add_ref", [](sol::this_state s, ::sdk::Resource* res) { 
             res->add_ref();
@@ -1,7 +1,59 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 class ScriptState;
 
+namespace sdk {
+struct REMethodDefinition;
+struct RETypeDefinition;
+}
+
 namespace bindings {
 void open_sdk(ScriptState* s);
 }
+
+namespace api::sdk {
+// View over the argument array of a hooked method, passed to Lua pre-hooks in place of a table.
+// One is created per hook and pointed at the hook's argument storage on each call.
+struct HookArgs {
+    ::sdk::REMethodDefinition* fn{nullptr};
+    std::vector<uintptr_t>* args{nullptr};
+    std::vector<::sdk::RETypeDefinition*>* arg_tys{nullptr};
+
+    // Keys that aren't arguments go into a table in the userdata's user value, which only lives for one call,
+    // like the table that used to be passed instead of the view.
+    uint64_t call{0};
+    uint64_t extra_call{0}; // the call the user value's table was made for
+
+    void begin_call(std::vector<uintptr_t>* call_args, std::vector<::sdk::RETypeDefinition*>* call_arg_tys) {
+        args = call_args;
+        arg_tys = call_arg_tys;
+        ++call;
+    }
+
+    // The storage is the hook's and gets reused by the next call, possibly on another thread,
+    // so a view the script kept around mustn't see it once the callback has returned.
+    void end_call() {
+        args = nullptr;
+        arg_tys = nullptr;
+    }
+};
+
+// Per Lua state caches of the sdk bindings. Owned by the ScriptState, which has to keep them alive until the
+// state is closed, because __gc metamethods still use them.
+struct StateCaches;
+
+struct StateCachesDeleter {
+    void operator()(StateCaches* caches) const;
+};
+
+using StateCachesPtr = std::unique_ptr<StateCaches, StateCachesDeleter>;
+
+StateCachesPtr create_state_caches();
+
+// Releases the game references held by Lua objects that were garbage collected since the last call.
+void flush_pending_releases();
+}
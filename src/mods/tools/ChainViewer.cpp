@@ -10,6 +10,7 @@
 #include "sdk/RETypeDB.hpp"
 #include "sdk/REManagedObject.hpp"
 #include "sdk/Renderer.hpp"
+#include "sdk/SceneSnapshot.hpp"
 
 #if TDB_VER < 69
 #include "sdk/regenny/re3/via/motion/Chain.hpp"
@@ -76,28 +77,19 @@ void ChainViewer::on_frame() {
         return;
     }
 
-    auto scene = sdk::get_current_scene();
+    const auto scene = sdk::get_scene_snapshot();
 
-    if (scene == nullptr) {
+    if (scene->get_entries().empty()) {
         return;
     }
 
     auto context = sdk::get_thread_context();
 
-    static auto scene_def = sdk::find_type_definition("via.Scene");
-    auto first_transform = sdk::call_native_func_easy<RETransform*>(scene, scene_def, "get_FirstTransform");
-
-    if (first_transform == nullptr) {
-        return;
-    }
-
     m_delta_time.update();
 
-    static auto transform_def = utility::re_managed_object::get_type_definition(first_transform);
+    static auto transform_def = sdk::find_type_definition("via.Transform");
     static auto folder_def = sdk::find_type_definition("via.Folder");
     static auto gameobject_def = sdk::find_type_definition("via.GameObject");
-    static auto next_transform_method = transform_def->get_method("get_Next");
-    static auto child_transform_method = transform_def->get_method("get_Child");
     static auto get_gameobject_method = transform_def->get_method("get_GameObject");
     static auto get_folder_path_method = folder_def->get_method("get_Path");
     static auto get_folder_method = gameobject_def->get_method("get_Folder");
@@ -152,22 +144,24 @@ void ChainViewer::on_frame() {
 
     ImGui::Begin("Chains");
 
-    for (auto transform = first_transform; 
-        transform != nullptr; 
-        transform = next_transform_method->call<RETransform*>(context, transform)) 
-    {
-        auto attempt_display_chains = [&](RETransform* transform) {
+    // The scene's roots and the two levels of children below them.
+    for (const auto& scene_entry : scene->get_entries()) {
+        if (scene_entry.depth > 2) {
+            continue;
+        }
+
+        auto attempt_display_chains = [&](const sdk::SceneEntry& entry) {
             static auto chain_type = sdk::find_type_definition("via.motion.Chain");
             static auto chain_re_type = chain_type->get_type();
 
-            auto chain = utility::re_component::find<regenny::via::motion::Chain>(transform, chain_re_type);
+            auto chain = utility::re_component::find<regenny::via::motion::Chain>(entry.transform, chain_re_type);
             bool made = false;
 
             if (chain == nullptr) {
                 return;
             }
 
-            auto owner = get_gameobject_method->call<REGameObject*>(context, transform);
+            auto owner = entry.game_object;
 
             if (owner == nullptr) {
                 return;
@@ -373,15 +367,7 @@ void ChainViewer::on_frame() {
             ImGui::PopID();
         };
 
-        attempt_display_chains(transform);
-
-        for (auto t = child_transform_method->call<RETransform*>(context, transform); t != nullptr; t = next_transform_method->call<RETransform*>(context, t)) {
-            attempt_display_chains(t);
-
-            for (auto t2 = child_transform_method->call<RETransform*>(context,t); t2 != nullptr; t2 = next_transform_method->call<RETransform*>(context, t2)) {
-                attempt_display_chains(t2);
-            }
-        }
+        attempt_display_chains(scene_entry);
     }
 
     ImGui::End();
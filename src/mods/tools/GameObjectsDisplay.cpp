@@ -2,6 +2,8 @@
 #include "sdk/SceneManager.hpp"
 #include "sdk/RETypeDB.hpp"
 #include "sdk/REManagedObject.hpp"
+#include "sdk/Renderer.hpp"
+#include "sdk/SceneSnapshot.hpp"
 
 #include "GameObjectsDisplay.hpp"
 
@@ -54,92 +56,35 @@ void GameObjectsDisplay::on_frame() {
         return;
     }
 
-    auto scene = sdk::get_current_scene();
+    const auto camera = sdk::renderer::get_camera_snapshot();
 
-    if (scene == nullptr) {
+    if (!camera) {
         return;
     }
 
-    auto context = sdk::get_thread_context();
-
-    static auto scene_def = sdk::find_type_definition("via.Scene");
-    auto first_transform = sdk::call_native_func_easy<RETransform*>(scene, scene_def, "get_FirstTransform");
-
-    if (first_transform == nullptr) {
-        return;
-    }
-
-    static auto transform_def = utility::re_managed_object::get_type_definition(first_transform);
-    static auto next_transform_method = transform_def->get_method("get_Next");
-    static auto get_gameobject_method = transform_def->get_method("get_GameObject");
-    static auto get_position_method = transform_def->get_method("get_Position");
-    static auto get_axisz_method = transform_def->get_method("get_AxisZ");
-
-    auto math = sdk::get_native_singleton("via.math");
-    auto math_t = sdk::find_type_definition("via.math");
-
-    auto camera = sdk::get_primary_camera();
-
-    if (camera == nullptr) {
-        return;
-    }
-
-    auto main_view = sdk::get_main_view();
-
-    if (main_view == nullptr) {
-        return;
-    }
-
-    auto camera_gameobject = get_gameobject_method->call<REGameObject*>(context, camera);
-    auto camera_transform = camera_gameobject->transform;
-
-    Vector4f camera_origin{};
-    get_position_method->call<void*>(&camera_origin, context, camera_transform);
-
-    Vector4f camera_forward{};
-    get_axisz_method->call<void*>(&camera_forward, context, camera_transform);
-
-    // Translate 2d position to 3d position (screen to world)
-    Matrix4x4f proj{}, view{};
-    float screen_size[2]{};
-    sdk::call_object_func<void*>(camera, "get_ProjectionMatrix", &proj, context, camera);
-    sdk::call_object_func<void*>(camera, "get_ViewMatrix", &view, context, camera);
-    sdk::call_object_func<void*>(main_view, "get_Size", &screen_size, context, main_view);
-
-    static auto world_to_screen_methods = math_t->get_methods("worldPos2ScreenPos"); // there are 2 of them.
-
-    Vector4f pos{};
-    Vector4f screen_pos{};
-
+    const auto scene = sdk::get_scene_snapshot();
     auto draw_list = ImGui::GetBackgroundDrawList();
 
-    for (auto transform = first_transform; 
-        transform != nullptr; 
-        transform = next_transform_method->call<RETransform*>(context, transform)) 
-    {
-        auto owner = get_gameobject_method->call<REGameObject*>(context, transform);
-
-        if (owner == nullptr) {
+    for (const auto& entry : scene->get_entries()) {
+        // Only the scene's root transforms, same as walking get_Next from the first transform.
+        if (entry.depth != 0 || entry.game_object == nullptr) {
             continue;
         }
 
-        auto owner_name = utility::re_string::get_string(owner->name);
+        auto owner_name = utility::re_string::get_string(entry.game_object->name);
 
         if (owner_name.empty()) {
             continue;
         }
 
-        get_position_method->call<void*>(&pos, context, transform);
-
-        const auto delta = pos - camera_origin;
+        // nullopt when behind the camera.
+        const auto screen_pos = sdk::renderer::world_to_screen(*camera, entry.position);
 
-        // behind camera
-        if (glm::dot(delta, -camera_forward) <= 0.0f) {
+        if (!screen_pos) {
             continue;
         }
 
-        world_to_screen_methods[1]->call<void*>(&screen_pos, context, &pos, &view, &proj, &screen_size);
-        draw_list->AddText(ImVec2(screen_pos.x, screen_pos.y), ImGui::GetColorU32(ImVec4(1.0f, 1.0f, 1.0f, 1.0f)), owner_name.c_str());
+        draw_list->AddText(ImVec2(screen_pos->x, screen_pos->y), ImGui::GetColorU32(ImVec4(1.0f, 1.0f, 1.0f, 1.0f)), owner_name.c_str());
     }
 }
 
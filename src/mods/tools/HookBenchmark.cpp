@@ -0,0 +1,258 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <imgui.h>
+#include <spdlog/spdlog.h>
+
+#include "HookManager.hpp"
+
+#include "HookBenchmark.hpp"
+
+namespace detail {
+volatile uintptr_t g_bench_sink{};
+
+// Each instantiation gets a distinct body so the linker can't fold them together,
+// which matters since a function can only be hooked once.
+template <uintptr_t N>
+__declspec(noinline) uintptr_t bench_int(uintptr_t a, uintptr_t b) {
+    g_bench_sink = g_bench_sink + a;
+    return a + b + N;
+}
+
+__declspec(noinline) float bench_float(float a, float b) {
+    g_bench_sink = g_bench_sink + 1;
+    return a * b;
+}
+
+using IntFn = uintptr_t (*)(uintptr_t, uintptr_t);
+using FloatFn = float (*)(float, float);
+
+constexpr uintptr_t SKIPPED_RESULT = 0x1234;
+
+HookManager::Signature int_signature() {
+    HookManager::Signature sig{};
+    sig.num_args = 2;
+
+    return sig;
+}
+
+HookManager::Signature float_signature() {
+    HookManager::Signature sig{};
+    sig.num_args = 2;
+    sig.float_args = 0b11;
+    sig.float_ret = true;
+
+    return sig;
+}
+
+// Calls through a volatile pointer so the calls can't be inlined or hoisted out of the loop.
+template <uintptr_t N>
+size_t call_int(size_t start, size_t count, uintptr_t expected_offset = N + 1) {
+    volatile IntFn fn = &bench_int<N>;
+    size_t errors = 0;
+
+    for (auto i = start; i < start + count; ++i) {
+        const auto expected = expected_offset == SKIPPED_RESULT ? SKIPPED_RESULT : i + expected_offset;
+
+        if (fn(i, 1) != expected) {
+            ++errors;
+        }
+    }
+
+    return errors;
+}
+
+template <typename T>
+double ns_per_call(T start, T end, size_t calls) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (double)calls;
+}
+}
+
+void HookBenchmark::on_draw_dev_ui() {
+    ImGui::SetNextTreeNodeOpen(false, ImGuiCond_::ImGuiCond_Once);
+
+    if (!ImGui::CollapsingHeader(get_name().data())) {
+        return;
+    }
+
+    ImGui::SliderInt("Iterations", &m_iterations, 10'000, 10'000'000);
+    ImGui::SliderInt("Callbacks", &m_num_callbacks, 2, 64);
+    ImGui::SliderInt("Threads", &m_num_threads, 2, 64);
+
+    ImGui::TextWrapped("The game will freeze while the benchmark is running.");
+
+    if (ImGui::Button("Run")) {
+        run();
+    }
+
+    if (m_results.empty()) {
+        return;
+    }
+
+    if (ImGui::BeginTable("##results", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Scenario");
+        ImGui::TableSetupColumn("ns/call");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Errors");
+        ImGui::TableHeadersRow();
+
+        for (const auto& result : m_results) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(result.name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", result.ns_per_call);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", result.calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", result.errors);
+        }
+
+        ImGui::EndTable();
+    }
+}
+
+void HookBenchmark::run() {
+    using namespace detail;
+    using clock = std::chrono::high_resolution_clock;
+
+    m_results.clear();
+
+    const auto iterations = (size_t)m_iterations;
+    const auto num_callbacks = (size_t)m_num_callbacks;
+    const auto num_threads = (size_t)m_num_threads;
+    std::atomic<size_t> cb_errors{0};
+
+    // The pre hook checks that it sees the arguments the caller passed.
+    auto check_args = [&cb_errors](std::vector<uintptr_t>& args, std::vector<sdk::RETypeDefinition*>& arg_tys) {
+        if (args[1] != 1) {
+            ++cb_errors;
+        }
+
+        return HookManager::PreHookResult::CALL_ORIGINAL;
+    };
+
+    auto measure = [&](std::string name, auto&& fn) {
+        cb_errors = 0;
+
+        const auto start = clock::now();
+        const auto errors = fn();
+        const auto end = clock::now();
+
+        Result result{std::move(name), ns_per_call(start, end, iterations), iterations, errors + cb_errors};
+        spdlog::info("[HookBenchmark] {}: {:.2f} ns/call, {} calls, {} errors", result.name, result.ns_per_call, result.calls, result.errors);
+
+        m_results.push_back(std::move(result));
+    };
+
+    // Reports throughput, i.e. wall time divided by the calls made across all threads.
+    auto measure_threaded = [&](std::string name, auto&& fn) {
+        measure(std::move(name), [&]() {
+            std::atomic<size_t> errors{0};
+            std::vector<std::thread> threads{};
+            const auto per_thread = iterations / num_threads;
+
+            for (auto t = 0u; t < num_threads; ++t) {
+                threads.emplace_back([&, t]() { errors += fn(t * per_thread, per_thread); });
+            }
+
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            return errors.load();
+        });
+    };
+
+    measure("Unhooked", [&]() { return call_int<0>(0, iterations); });
+
+    // Callback counts, all on the same function. A function whose callbacks have all been removed
+    // gets unhooked, so there's no separate 0 callback case.
+    std::vector<HookManager::HookId> ids{};
+    ids.push_back(g_hookman.add((void*)&bench_int<1>, int_signature(), check_args, nullptr));
+
+    measure("1 callback", [&]() { return call_int<1>(0, iterations); });
+
+    while (ids.size() < num_callbacks) {
+        ids.push_back(g_hookman.add((void*)&bench_int<1>, int_signature(), check_args, nullptr));
+    }
+
+    measure(fmt::format("{} callbacks", num_callbacks), [&]() { return call_int<1>(0, iterations); });
+
+    for (auto id : ids) {
+        g_hookman.remove((void*)&bench_int<1>, id);
+    }
+
+    // A lone raw callback, which the facilitator calls directly.
+    auto raw_id = g_hookman.add_raw((void*)&bench_int<5>, int_signature(), 
+        [](void* cb_errors, uintptr_t* args, size_t num_args, sdk::RETypeDefinition** arg_tys) {
+            if (args[1] != 1) {
+                ++*(std::atomic<size_t>*)cb_errors;
+            }
+
+            return HookManager::PreHookResult::CALL_ORIGINAL;
+        }, &cb_errors, nullptr, nullptr);
+
+    measure("1 raw callback", [&]() { return call_int<5>(0, iterations); });
+
+    g_hookman.remove((void*)&bench_int<5>, raw_id);
+
+    // Float arguments and return value.
+    auto float_id = g_hookman.add((void*)&bench_float, float_signature(), 
+        [&cb_errors](std::vector<uintptr_t>& args, std::vector<sdk::RETypeDefinition*>& arg_tys) {
+            if (*(float*)&args[1] != 2.0f) {
+                ++cb_errors;
+            }
+
+            return HookManager::PreHookResult::CALL_ORIGINAL;
+        }, nullptr);
+
+    measure("Float return, 1 callback", [&]() {
+        volatile FloatFn fn = &bench_float;
+        size_t errors = 0;
+
+        for (auto i = 0u; i < iterations; ++i) {
+            if (fn(3.0f, 2.0f) != 6.0f) {
+                ++errors;
+            }
+        }
+
+        return errors;
+    });
+
+    g_hookman.remove((void*)&bench_float, float_id);
+
+    // Skipping the original, with the post hook supplying the return value.
+    auto skip_id = g_hookman.add((void*)&bench_int<2>, int_signature(), 
+        [](std::vector<uintptr_t>& args, std::vector<sdk::RETypeDefinition*>& arg_tys) {
+            return HookManager::PreHookResult::SKIP_ORIGINAL;
+        },
+        [](uintptr_t& ret_val, sdk::RETypeDefinition* ret_ty) {
+            ret_val = SKIPPED_RESULT;
+        });
+
+    measure("SKIP_ORIGINAL", [&]() { return call_int<2>(0, iterations, SKIPPED_RESULT); });
+
+    g_hookman.remove((void*)&bench_int<2>, skip_id);
+
+    // Many threads calling the same hooked function at once.
+    auto threaded_id = g_hookman.add((void*)&bench_int<3>, int_signature(), check_args, nullptr);
+
+    measure_threaded(fmt::format("1 callback, {} threads", num_threads), [](size_t start, size_t count) { return call_int<3>(start, count); });
+
+    g_hookman.remove((void*)&bench_int<3>, threaded_id);
+
+    // Observer-only hooks, which don't serialize callers.
+    auto observer_id = g_hookman.add_observer((void*)&bench_int<4>, int_signature(), 
+        [&cb_errors](const HookManager::ObserverFrame& frame) {
+            if (frame.args[1] != 1) {
+                ++cb_errors;
+            }
+        }, nullptr);
+
+    measure("Observer", [&]() { return call_int<4>(0, iterations); });
+    measure_threaded(fmt::format("Observer, {} threads", num_threads), [](size_t start, size_t count) { return call_int<4>(start, count); });
+
+    g_hookman.remove((void*)&bench_int<4>, observer_id);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Tool.hpp"
+
+// Measures the per-call overhead of the HookManager facilitators on a set of dummy native functions,
+// so changes to the hook path can be judged against numbers instead of in-game stutter.
+class HookBenchmark : public Tool {
+public:
+    std::string_view get_name() const override {
+        return "HookBenchmark";
+    }
+
+    void on_draw_dev_ui() override;
+
+private:
+    struct Result {
+        std::string name{};
+        double ns_per_call{};
+        size_t calls{};
+        size_t errors{};
+    };
+
+    void run();
+
+    std::vector<Result> m_results{};
+
+    int m_iterations{1'000'000};
+    int m_num_callbacks{8};
+    int m_num_threads{8};
+};
@@ -12,6 +12,7 @@
 #include "Tool.hpp"
 #include "HookManager.hpp"
 
+#include <sdk/RETypeDB.hpp>
 #include <sdk/TDBVer.hpp>
 
 #ifdef DMC5
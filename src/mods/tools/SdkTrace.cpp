@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <fstream>
+
+#include <imgui.h>
+#include <spdlog/spdlog.h>
+
+#include "utility/Module.hpp"
+
+#include "REFramework.hpp"
+
+#include "SdkTrace.hpp"
+
+#ifdef REF_TRACING
+namespace detail {
+using Counter = sdk::trace::Counter;
+
+constexpr size_t NUM_COUNTERS = (size_t)Counter::COUNT;
+}
+#endif
+
+void SdkTrace::on_frame() {
+#ifdef REF_TRACING
+    ++m_frames_since_snapshot;
+
+    if (m_paused) {
+        return;
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - m_last_snapshot.time;
+
+    if (elapsed >= std::chrono::milliseconds{m_update_interval_ms}) {
+        update();
+    }
+#endif
+}
+
+void SdkTrace::on_draw_dev_ui() {
+    ImGui::SetNextTreeNodeOpen(false, ImGuiCond_::ImGuiCond_Once);
+
+    if (!ImGui::CollapsingHeader(get_name().data())) {
+        return;
+    }
+
+#ifndef REF_TRACING
+    ImGui::TextWrapped("Built without REF_TRACING. Reconfigure with -DREF_TRACING=ON to enable the SDK counters.");
+#else
+    ImGui::Checkbox("Paused", &m_paused);
+    ImGui::SliderInt("Update Interval (ms)", &m_update_interval_ms, 100, 10000);
+
+    if (ImGui::Button("Dump to File")) {
+        dump();
+    }
+
+    if (!m_dump_result.empty()) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(m_dump_result.c_str());
+    }
+
+    ImGui::Text("Over the last %.2fs", m_interval_s);
+
+    if (ImGui::BeginTable("##totals", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Counter");
+        ImGui::TableSetupColumn("calls/frame");
+        ImGui::TableSetupColumn("ns/call");
+        ImGui::TableSetupColumn("ms/frame");
+        ImGui::TableHeadersRow();
+
+        for (size_t i = 0; i < detail::NUM_COUNTERS; ++i) {
+            const auto& rate = m_totals[i];
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(sdk::trace::get_counter_name((detail::Counter)i));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", rate.calls_per_frame);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", rate.ns_per_call);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", rate.ms_per_frame);
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::TextUnformatted("By call site (calls/frame, ms/frame)");
+
+    if (ImGui::BeginTable("##sites", 1 + (int)detail::NUM_COUNTERS, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY, ImVec2{0, 300})) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Site");
+
+        for (size_t i = 0; i < detail::NUM_COUNTERS; ++i) {
+            ImGui::TableSetupColumn(sdk::trace::get_counter_name((detail::Counter)i));
+        }
+
+        ImGui::TableHeadersRow();
+
+        for (const auto& site : m_sites) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(site.name.c_str());
+
+            for (const auto& rate : site.rates) {
+                ImGui::TableNextColumn();
+
+                if (rate.calls_per_frame > 0.0) {
+                    ImGui::Text("%.1f, %.3f", rate.calls_per_frame, rate.ms_per_frame);
+                }
+            }
+        }
+
+        ImGui::EndTable();
+    }
+#endif
+}
+
+#ifdef REF_TRACING
+void SdkTrace::update() {
+    auto snapshot = sdk::trace::snapshot();
+
+    const auto frames = (double)std::max<size_t>(m_frames_since_snapshot, 1);
+    const auto seconds = std::chrono::duration<double>(snapshot.time - m_last_snapshot.time).count();
+    const auto first = m_last_snapshot.tsc == 0;
+
+    // The TSC rate isn't exposed anywhere, so measure it against the steady clock between snapshots.
+    const auto cycles_per_ns = seconds > 0.0 ? (double)(snapshot.tsc - m_last_snapshot.tsc) / (seconds * 1e9) : 1.0;
+
+    auto to_rate = [&](const sdk::trace::Stat& now, const sdk::trace::Stat& before) {
+        Rate rate{};
+        const auto calls = (double)(now.calls - before.calls);
+        const auto ns = (double)(now.cycles - before.cycles) / cycles_per_ns;
+
+        rate.calls_per_frame = calls / frames;
+        rate.ns_per_call = calls > 0.0 ? ns / calls : 0.0;
+        rate.ms_per_frame = ns / 1e6 / frames;
+
+        return rate;
+    };
+
+    if (!first) {
+        for (size_t i = 0; i < detail::NUM_COUNTERS; ++i) {
+            m_totals[i] = to_rate(snapshot.totals[i], m_last_snapshot.totals[i]);
+        }
+
+        m_sites.clear();
+
+        for (const auto& [site, stats] : snapshot.sites) {
+            static const sdk::trace::Stats empty{};
+
+            auto it = std::find_if(m_last_snapshot.sites.begin(), m_last_snapshot.sites.end(), [&](const auto& p) { return p.first == site; });
+            const auto& before = it != m_last_snapshot.sites.end() ? it->second : empty;
+
+            SiteRates site_rates{};
+            site_rates.name = sdk::trace::get_site_name(site);
+
+            for (size_t i = 0; i < detail::NUM_COUNTERS; ++i) {
+                site_rates.rates[i] = to_rate(stats[i], before[i]);
+                site_rates.total_ms_per_frame += site_rates.rates[i].ms_per_frame;
+            }
+
+            if (std::any_of(site_rates.rates.begin(), site_rates.rates.end(), [](const Rate& r) { return r.calls_per_frame > 0.0; })) {
+                m_sites.push_back(std::move(site_rates));
+            }
+        }
+
+        std::sort(m_sites.begin(), m_sites.end(), [](const SiteRates& a, const SiteRates& b) {
+            return a.total_ms_per_frame > b.total_ms_per_frame;
+        });
+
+        m_interval_s = seconds;
+    }
+
+    m_last_snapshot = std::move(snapshot);
+    m_frames_since_snapshot = 0;
+}
+
+void SdkTrace::dump() {
+    const auto dir = utility::get_module_directory(g_framework->get_module().as<HMODULE>()).value_or(".");
+    const auto path = dir + "/reframework_sdk_trace.csv";
+
+    std::ofstream out{path};
+
+    if (!out) {
+        m_dump_result = "Failed to open " + path;
+        return;
+    }
+
+    out << "site,counter,calls_per_frame,ns_per_call,ms_per_frame\n";
+
+    auto write_row = [&](std::string site, size_t counter, const Rate& rate) {
+        for (size_t pos = 0; (pos = site.find('"', pos)) != std::string::npos; pos += 2) {
+            site.insert(pos, 1, '"');
+        }
+
+        out << '"' << site << "\"," << sdk::trace::get_counter_name((detail::Counter)counter) << ',' 
+            << rate.calls_per_frame << ',' << rate.ns_per_call << ',' << rate.ms_per_frame << '\n';
+    };
+
+    for (size_t i = 0; i < detail::NUM_COUNTERS; ++i) {
+        write_row("(total)", i, m_totals[i]);
+    }
+
+    for (const auto& site : m_sites) {
+        for (size_t i = 0; i < detail::NUM_COUNTERS; ++i) {
+            if (site.rates[i].calls_per_frame > 0.0) {
+                write_row(site.name, i, site.rates[i]);
+            }
+        }
+    }
+
+    m_dump_result = "Wrote " + path;
+    spdlog::info("[SdkTrace] {}", m_dump_result);
+}
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "sdk/Trace.hpp"
+
+#include "Tool.hpp"
+
+// Shows the sdk::trace counters as per-second and per-frame rates, broken down by call site.
+// Only does anything in builds with REF_TRACING.
+class SdkTrace : public Tool {
+public:
+    std::string_view get_name() const override {
+        return "SdkTrace";
+    }
+
+    void on_frame() override;
+    void on_draw_dev_ui() override;
+
+#ifdef REF_TRACING
+private:
+    struct Rate {
+        double calls_per_frame{};
+        double ns_per_call{};
+        double ms_per_frame{};
+    };
+
+    struct SiteRates {
+        std::string name{};
+        std::array<Rate, (size_t)sdk::trace::Counter::COUNT> rates{};
+        double total_ms_per_frame{};
+    };
+
+    void update();
+    void dump();
+
+    sdk::trace::Snapshot m_last_snapshot{};
+    size_t m_frames_since_snapshot{};
+
+    std::array<Rate, (size_t)sdk::trace::Counter::COUNT> m_totals{};
+    std::vector<SiteRates> m_sites{};
+    double m_interval_s{};
+
+    std::string m_dump_result{};
+    int m_update_interval_ms{1000};
+    bool m_paused{false};
+#endif
+};
@@ -2,6 +2,7 @@
 #include <sdk/SceneManager.hpp>
 #include <sdk/MurmurHash.hpp>
 #include <sdk/Application.hpp>
+#include <sdk/RETypeDB.hpp>
 
 #include "HookManager.hpp"
 
@@ -126,7 +127,13 @@ void RE8VR::on_draw_ui() {
     m_hide_lower_body_cutscenes->draw("Auto Hide Lower Body in Cutscenes");
 }
 
-void RE8VR::on_pre_application_entry(void* entry, const char* name, size_t hash) {
+std::vector<ModSubscription> RE8VR::get_subscriptions() const {
+    return {
+        {ModCallback::PRE_APPLICATION_ENTRY, {"LockScene"_fnv}},
+    };
+}
+
+void RE8VR::on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     switch (hash) {
     case "LockScene"_fnv:
         on_pre_lock_scene(entry);
@@ -136,7 +143,7 @@ void RE8VR::on_pre_application_entry(void* entry, const char* name, size_t hash)
     }
 }
 
-void RE8VR::on_application_entry(void* entry, const char* name, size_t hash) {
+void RE8VR::on_application_entry(void* entry, const char* name, size_t hash, size_t id) {
     
 }
 
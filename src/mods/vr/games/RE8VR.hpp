@@ -26,8 +26,9 @@ public:
 
     void on_draw_ui() override;
 
-    void on_pre_application_entry(void* entry, const char* name, size_t hash) override;
-    void on_application_entry(void* entry, const char* name, size_t hash) override;
+    std::vector<ModSubscription> get_subscriptions() const override;
+    void on_pre_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
+    void on_application_entry(void* entry, const char* name, size_t hash, size_t id) override;
 
     // non-virtual callbacks
     void on_pre_lock_scene(void* entry);
@@ -0,0 +1,27 @@
+#pragma once
+
+// What the tests share: CHECK records a failure and keeps going, so one run reports every broken
+// expectation, and main ends with `return report("Name");`.
+
+#include <cstdio>
+
+inline int g_failures{0};
+
+#define CHECK(x)                                                                       \
+    do {                                                                               \
+        if (!(x)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+            ++g_failures;                                                              \
+        }                                                                              \
+    } while (0)
+
+// Returns the exit code for main.
+inline int report(const char* suite) {
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d checks failed\n", g_failures);
+        return 1;
+    }
+
+    std::printf("All %s tests passed\n", suite);
+    return 0;
+}
@@ -0,0 +1,454 @@
+// HookManager's bookkeeping against a backend that generates no code and patches nothing.
+// The facilitators are stood in for by calls that do what the generated code does around the original function
+// (taking the hook's lock, dispatching, jumping through the stub's slot), so this runs on any platform.
+
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "HookManager.hpp"
+
+#include "Check.hpp"
+
+namespace {
+using HookedFn = HookManager::HookedFn;
+using PreHookResult = HookManager::PreHookResult;
+using Fn = uintptr_t (*)(uintptr_t, uintptr_t);
+
+class MockBackend : public HookManager::Backend {
+public:
+    // Stands in for a facilitator; its address is the entry, and the stub is just another address.
+    struct Generated {
+        FacilitatorRequest request{};
+        char stub{};
+        uintptr_t original{};
+    };
+
+    std::vector<Facilitator> generate(const std::vector<FacilitatorRequest>& requests) override {
+        batches.push_back(requests.size());
+
+        if (fail_generate) {
+            return {};
+        }
+
+        std::vector<Facilitator> facilitators{};
+
+        for (const auto& request : requests) {
+            auto& generated = this->generated.emplace_back(Generated{request});
+            facilitators.push_back(Facilitator{request.replace ? 0 : (uintptr_t)&generated.stub, (uintptr_t)&generated, &generated.original});
+        }
+
+        return facilitators;
+    }
+
+    uintptr_t create(void* target, void* destination) override {
+        if (target == fail_create) {
+            return 0;
+        }
+
+        detours.emplace_back(target, destination);
+        return (uintptr_t)target;
+    }
+
+    bool enable(const std::vector<void*>& targets) override {
+        enables.push_back(targets);
+        return true;
+    }
+
+    bool disable(const std::vector<void*>& targets) override {
+        disables.push_back(targets);
+        return true;
+    }
+
+    bool remove(void* target) override {
+        removed.push_back(target);
+        return true;
+    }
+
+    // The hook whose stub the target's detour lands on.
+    HookedFn* hook_for(void* target) const {
+        for (const auto& [t, destination] : detours) {
+            if (t != target) {
+                continue;
+            }
+
+            for (const auto& g : generated) {
+                if ((void*)&g.stub == destination) {
+                    return g.request.hook;
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+    std::deque<Generated> generated{};
+    std::vector<size_t> batches{};
+    std::vector<std::pair<void*, void*>> detours{};
+    std::vector<std::vector<void*>> enables{};
+    std::vector<std::vector<void*>> disables{};
+    std::vector<void*> removed{};
+
+    bool fail_generate{false};
+    void* fail_create{};
+};
+
+uintptr_t add_fn(uintptr_t a, uintptr_t b) { return a + b; }
+uintptr_t sub_fn(uintptr_t a, uintptr_t b) { return a - b; }
+uintptr_t mul_fn(uintptr_t a, uintptr_t b) { return a * b; }
+
+// What the regular facilitator does, minus moving the arguments between registers and args.
+uintptr_t facilitate(HookedFn& hook, Fn original, uintptr_t a, uintptr_t b) {
+    HookedFn::lock_static(&hook);
+
+    hook.args[0] = a;
+    hook.args[1] = b;
+
+    const auto& dispatch = hook.dispatch;
+    const auto result = dispatch.pre_fn(dispatch.pre_data, hook.args.data(), hook.args.size(), hook.arg_tys.data());
+
+    hook.ret_val = result == PreHookResult::CALL_ORIGINAL ? original(hook.args[0], hook.args[1]) : 0;
+    dispatch.post_fn(dispatch.post_data, &hook.ret_val, hook.ret_ty);
+
+    const auto ret_val = hook.ret_val;
+    HookedFn::unlock_static(&hook);
+
+    return ret_val;
+}
+
+// What the observer facilitator does: the frame lives on the stack and nothing is locked.
+uintptr_t observe(HookedFn& hook, Fn original, uintptr_t a, uintptr_t b) {
+    uintptr_t frame[3]{a, b, 0};
+
+    HookedFn::on_pre_observe_static(&hook, frame);
+    frame[2] = original(a, b);
+    HookedFn::on_post_observe_static(&hook, frame);
+
+    return frame[2];
+}
+
+// Calls the target the way a patched one would: into the stub, through facilitator_fn, and on to the original
+// through the slot filled in at install. Returns 0 if the target isn't hooked.
+uintptr_t call(const MockBackend& backend, Fn target, uintptr_t a, uintptr_t b) {
+    auto hook = backend.hook_for((void*)target);
+
+    if (hook == nullptr) {
+        CHECK(false);
+        return 0;
+    }
+
+    const auto& facilitator = *(const MockBackend::Generated*)hook->facilitator_fn.load();
+    const auto original = (Fn)facilitator.original;
+
+    return facilitator.request.observer ? observe(*hook, original, a, b) : facilitate(*hook, original, a, b);
+}
+
+HookManager::Signature two_args() {
+    HookManager::Signature sig{};
+    sig.num_args = 2;
+    return sig;
+}
+
+auto make_hookman() {
+    auto backend = std::make_unique<MockBackend>();
+    auto raw = backend.get();
+
+    return std::make_pair(std::make_unique<HookManager>(std::move(backend)), raw);
+}
+
+PreHookResult call_original(std::vector<uintptr_t>&, std::vector<sdk::RETypeDefinition*>&) {
+    return PreHookResult::CALL_ORIGINAL;
+}
+
+void no_post(uintptr_t&, sdk::RETypeDefinition*) {
+}
+
+void test_callbacks() {
+    auto [hookman, backend] = make_hookman();
+
+    const auto id = hookman->add((void*)&add_fn, two_args(),
+        [](auto& args, auto&) {
+            args[0] = 10;
+            return PreHookResult::CALL_ORIGINAL;
+        },
+        [](auto& ret_val, auto) { ret_val *= 2; });
+
+    CHECK(id != HookManager::HookId{});
+    CHECK(backend->batches.size() == 1);
+    CHECK(backend->enables.size() == 1);
+    CHECK(call(*backend, &add_fn, 1, 2) == (10 + 2) * 2);
+
+    hookman->remove((void*)&add_fn, id);
+    CHECK(backend->disables.size() == 1);
+
+    // Disabled, not destroyed, since another thread may still be inside.
+    CHECK(backend->removed.empty());
+}
+
+void test_skip_original() {
+    auto [hookman, backend] = make_hookman();
+
+    hookman->add((void*)&sub_fn, two_args(),
+        [](auto&, auto&) { return PreHookResult::SKIP_ORIGINAL; },
+        [](auto& ret_val, auto) { ret_val = 1234; });
+
+    CHECK(call(*backend, &sub_fn, 5, 3) == 1234);
+}
+
+void test_raw_callback_is_dispatched_directly() {
+    auto [hookman, backend] = make_hookman();
+
+    static int s_calls{};
+    s_calls = 0;
+
+    auto pre = [](void* data, uintptr_t* args, size_t, sdk::RETypeDefinition**) {
+        ++*(int*)data;
+        args[1] = 100;
+        return PreHookResult::CALL_ORIGINAL;
+    };
+
+    hookman->add_raw((void*)&add_fn, two_args(), pre, &s_calls, nullptr, nullptr);
+
+    auto hook = backend->hook_for((void*)&add_fn);
+
+    if (hook == nullptr) {
+        CHECK(false);
+        return;
+    }
+
+    // A single raw callback skips on_pre_hook/on_post_hook entirely.
+    CHECK(hook->dispatch.pre_fn == pre);
+    CHECK(hook->dispatch.pre_data == &s_calls);
+    CHECK(hook->dispatch.post_fn == &HookedFn::post_hook_noop);
+    CHECK(call(*backend, &add_fn, 1, 2) == 101);
+    CHECK(s_calls == 1);
+
+    // A second callback puts the dispatchers back.
+    hookman->add((void*)&add_fn, two_args(), call_original, no_post);
+    CHECK(hook->dispatch.pre_fn == &HookedFn::on_pre_hook_static);
+    CHECK(call(*backend, &add_fn, 1, 2) == 101);
+    CHECK(s_calls == 2);
+}
+
+void test_transaction_batches() {
+    auto [hookman, backend] = make_hookman();
+
+    {
+        HookManager::Transaction transaction{*hookman};
+
+        hookman->add((void*)&add_fn, two_args(), call_original, no_post);
+        hookman->add((void*)&sub_fn, two_args(), call_original, no_post);
+        const auto id = hookman->add((void*)&mul_fn, two_args(), call_original, no_post);
+
+        // Added and removed again before the commit, so it never gets enabled.
+        hookman->remove((void*)&mul_fn, id);
+
+        CHECK(backend->batches.empty());
+        CHECK(backend->detours.empty());
+        CHECK(backend->enables.empty());
+    }
+
+    // Every facilitator in one generate call, and every detour enabled in one batch.
+    CHECK(backend->batches.size() == 1);
+
+    if (!backend->batches.empty()) {
+        CHECK(backend->batches[0] == 3);
+    }
+
+    CHECK(backend->detours.size() == 3);
+    CHECK(backend->enables.size() == 1);
+
+    if (!backend->enables.empty()) {
+        CHECK(backend->enables[0].size() == 2);
+    }
+
+    CHECK(backend->disables.empty());
+}
+
+void test_failed_installs_are_dropped() {
+    auto [hookman, backend] = make_hookman();
+
+    backend->fail_create = (void*)&sub_fn;
+
+    // Outside of a transaction the failure is known right away.
+    CHECK(hookman->add((void*)&sub_fn, two_args(), call_original, no_post) == HookManager::HookId{});
+
+    HookManager::HookId id{};
+
+    {
+        HookManager::Transaction transaction{*hookman};
+
+        hookman->add((void*)&add_fn, two_args(), call_original, no_post);
+        id = hookman->add((void*)&sub_fn, two_args(), call_original, no_post);
+
+        // Handed out before the commit.
+        CHECK(id != HookManager::HookId{});
+    }
+
+    // The other hook in the transaction still goes in, and the dropped hook's ID is a no-op.
+    CHECK(backend->enables.size() == 1);
+
+    if (!backend->enables.empty()) {
+        CHECK(backend->enables[0].size() == 1);
+    }
+
+    hookman->remove((void*)&sub_fn, id);
+    CHECK(backend->disables.empty());
+
+    backend->fail_create = nullptr;
+    CHECK(hookman->add((void*)&sub_fn, two_args(), call_original, no_post) != HookManager::HookId{});
+}
+
+void test_changes_from_callbacks_are_deferred() {
+    auto [hookman, backend] = make_hookman();
+    auto& hm = *hookman;
+
+    static HookManager::HookId s_self_id{};
+    static HookManager::HookId s_added_id{};
+    static int s_calls{};
+
+    s_calls = 0;
+    s_self_id = hm.add((void*)&add_fn, two_args(),
+        [&hm, backend = backend](auto&, auto&) {
+            ++s_calls;
+
+            // Neither of these may run while this thread is inside the hooked function.
+            s_added_id = hm.add((void*)&mul_fn, two_args(), call_original, no_post);
+            hm.remove((void*)&add_fn, s_self_id);
+
+            CHECK(backend->hook_for((void*)&mul_fn) == nullptr);
+            CHECK(backend->disables.empty());
+
+            return PreHookResult::CALL_ORIGINAL;
+        },
+        no_post);
+
+    CHECK(call(*backend, &add_fn, 1, 2) == 3);
+    CHECK(s_calls == 1);
+
+    // Ran as one transaction once the call returned.
+    CHECK(s_added_id != HookManager::HookId{});
+    CHECK(backend->hook_for((void*)&mul_fn) != nullptr);
+    CHECK(backend->batches.size() == 2);
+    CHECK(backend->enables.size() == 2);
+    CHECK(backend->disables.size() == 1);
+
+    // The callback removed itself.
+    CHECK(call(*backend, &add_fn, 1, 2) == 3);
+    CHECK(s_calls == 1);
+}
+
+void test_observers() {
+    auto [hookman, backend] = make_hookman();
+
+    static uintptr_t s_seen_arg{};
+    static uintptr_t s_seen_ret{};
+
+    const auto id = hookman->add_observer((void*)&mul_fn, two_args(),
+        [](const HookManager::ObserverFrame& frame) { s_seen_arg = frame.args[1]; },
+        [](const HookManager::ObserverFrame& frame) { s_seen_ret = frame.ret_val; });
+
+    CHECK(id != HookManager::HookId{});
+    CHECK(backend->generated.size() == 1 && backend->generated[0].request.observer);
+    CHECK(call(*backend, &mul_fn, 6, 7) == 42);
+    CHECK(s_seen_arg == 7);
+    CHECK(s_seen_ret == 42);
+
+    // A regular hook on top of an observer-only one switches it to the regular facilitator,
+    // behind the same detour.
+    const auto regular_id = hookman->add((void*)&mul_fn, two_args(),
+        [](auto& args, auto&) {
+            args[1] = 8;
+            return PreHookResult::CALL_ORIGINAL;
+        },
+        no_post);
+
+    CHECK(regular_id != HookManager::HookId{});
+    CHECK(backend->detours.size() == 1);
+    CHECK(backend->generated.size() == 2);
+
+    if (backend->generated.size() == 2) {
+        const auto& replacement = backend->generated[1].request;
+
+        CHECK(replacement.replace && !replacement.observer);
+        CHECK(backend->generated[1].original == (uintptr_t)&mul_fn);
+    }
+
+    CHECK(call(*backend, &mul_fn, 6, 7) == 48);
+    CHECK(s_seen_arg == 7); // observers run before the regular callbacks
+    CHECK(s_seen_ret == 48);
+
+    hookman->remove((void*)&mul_fn, regular_id);
+    CHECK(backend->disables.empty());
+
+    hookman->remove((void*)&mul_fn, id);
+    CHECK(backend->disables.size() == 1);
+}
+
+void test_failed_conversion_keeps_observing() {
+    auto [hookman, backend] = make_hookman();
+
+    static int s_observed{};
+    s_observed = 0;
+
+    hookman->add_observer((void*)&mul_fn, two_args(), [](const auto&) { ++s_observed; }, nullptr);
+
+    backend->fail_generate = true;
+    CHECK(hookman->add((void*)&mul_fn, two_args(), call_original, no_post) == HookManager::HookId{});
+    backend->fail_generate = false;
+
+    // Still observing, through the original facilitator.
+    CHECK(backend->hook_for((void*)&mul_fn) != nullptr);
+    CHECK(call(*backend, &mul_fn, 6, 7) == 42);
+    CHECK(s_observed == 1);
+    CHECK(backend->disables.empty());
+}
+
+void test_replaced_observer_lists_outlive_their_readers() {
+    auto [hookman, backend] = make_hookman();
+    auto& hm = *hookman;
+
+    // Every copy of the observer list holds a reference, so use_count tells how many lists are alive.
+    static std::weak_ptr<int> s_token{};
+    static long s_lists_inside{};
+
+    auto token = std::make_shared<int>();
+    s_token = token;
+
+    hm.add_observer((void*)&mul_fn, two_args(),
+        [&hm, token](const auto&) {
+            // Replaces the list this call is iterating over.
+            hm.add_observer((void*)&mul_fn, two_args(), nullptr, nullptr);
+            s_lists_inside = s_token.use_count();
+        },
+        nullptr);
+
+    token.reset();
+    CHECK(s_token.use_count() == 1);
+
+    CHECK(call(*backend, &mul_fn, 2, 3) == 6);
+
+    // The old list was kept while this thread was still reading it...
+    CHECK(s_lists_inside == 2);
+    CHECK(s_token.use_count() == 2);
+
+    // ...and goes at the next quiescent point.
+    hm.reclaim_observer_lists();
+    CHECK(s_token.use_count() == 1);
+}
+}
+
+int main() {
+    test_callbacks();
+    test_skip_original();
+    test_raw_callback_is_dispatched_directly();
+    test_transaction_batches();
+    test_failed_installs_are_dropped();
+    test_changes_from_callbacks_are_deferred();
+    test_observers();
+    test_failed_conversion_keeps_observing();
+    test_replaced_observer_lists_outlive_their_readers();
+
+    return report("HookManager");
+}
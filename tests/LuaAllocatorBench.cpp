@@ -0,0 +1,137 @@
+// LuaAllocator against the allocator luaL_newstate uses (lauxlib's l_alloc, a thin realloc/free wrapper),
+// on the kinds of garbage scripts churn through every frame. Not a test; run it by hand:
+//   LuaAllocatorBench [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include <lua.hpp>
+
+#include "mods/LuaAllocator.hpp"
+
+namespace {
+struct Workload {
+    const char* name;
+    const char* code; // defines op(i)
+};
+
+constexpr Workload WORKLOADS[] = {
+    {"table churn", R"(
+        function op(i)
+            local t = {i, i + 1, i + 2, x = i, y = i * 2}
+            t.z = #t
+            return t
+        end
+    )"},
+    {"string building", R"(
+        local parts = {}
+
+        function op(i)
+            parts[1] = "item"
+            parts[2] = tostring(i)
+            parts[3] = string.format("%08x", i * 31)
+            return table.concat(parts, ":") .. "/" .. i
+        end
+    )"},
+    {"closures", R"(
+        function op(i)
+            local count = i
+            local function inc() count = count + 1 return count end
+            local get = function() return inc() * 2 end
+            return get()
+        end
+    )"},
+};
+
+// lauxlib's l_alloc, plus the byte counting LuaAllocator does on its own.
+struct DefaultAllocator {
+    size_t live_bytes{};
+    size_t peak_bytes{};
+
+    static void* alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+        auto self = (DefaultAllocator*)ud;
+
+        // Without a block, osize is the type of the object being allocated.
+        if (ptr == nullptr) {
+            osize = 0;
+        }
+
+        if (nsize == 0) {
+            std::free(ptr);
+            self->live_bytes -= osize;
+            return nullptr;
+        }
+
+        auto result = std::realloc(ptr, nsize);
+
+        if (result != nullptr) {
+            self->live_bytes += nsize - osize;
+            self->peak_bytes = std::max(self->peak_bytes, self->live_bytes);
+        }
+
+        return result;
+    }
+};
+
+// Nanoseconds per op(i) call.
+double run(lua_Alloc alloc, void* ud, const Workload& workload, lua_Integer iterations) {
+    auto l = lua_newstate(alloc, ud);
+    luaL_openlibs(l);
+
+    if (luaL_dostring(l, workload.code) != LUA_OK) {
+        std::fprintf(stderr, "%s: %s\n", workload.name, lua_tostring(l, -1));
+        std::exit(1);
+    }
+
+    luaL_dostring(l, "function run(n) for i = 1, n do op(i) end end");
+
+    auto call_run = [l](lua_Integer n) {
+        lua_getglobal(l, "run");
+        lua_pushinteger(l, n);
+
+        if (lua_pcall(l, 1, 0, 0) != LUA_OK) {
+            std::fprintf(stderr, "%s\n", lua_tostring(l, -1));
+            std::exit(1);
+        }
+    };
+
+    // Warm up the free lists and the string table, then start from a clean heap.
+    call_run(iterations / 10);
+    lua_gc(l, LUA_GCCOLLECT);
+
+    const auto start = std::chrono::steady_clock::now();
+    call_run(iterations);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    lua_close(l);
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+}
+
+int main(int argc, char** argv) {
+    const lua_Integer iterations = argc > 1 ? std::atoll(argv[1]) : 2'000'000;
+
+    std::printf("%lld iterations per workload\n\n", (long long)iterations);
+
+    // Peak bytes is the most Lua had live at once. LuaAllocator also holds on to its slabs until trim,
+    // which this never calls, so the slab bytes are the most it reserved for small blocks.
+    std::printf("%-16s %-12s %10s %14s %14s\n", "workload", "allocator", "ns/op", "peak bytes", "slab bytes");
+
+    for (const auto& workload : WORKLOADS) {
+        DefaultAllocator default_allocator{};
+        const auto base = run(&DefaultAllocator::alloc, &default_allocator, workload, iterations);
+
+        LuaAllocator pooled_allocator{};
+        const auto pooled = run(&LuaAllocator::alloc, &pooled_allocator, workload, iterations);
+        const auto stats = pooled_allocator.get_stats();
+
+        std::printf("%-16s %-12s %10.1f %14zu %14s\n", workload.name, "l_alloc", base, default_allocator.peak_bytes, "-");
+        std::printf("%-16s %-12s %10.1f %14zu %14zu\n", workload.name, "LuaAllocator", pooled, stats.peak_bytes, stats.slab_bytes);
+        std::printf("%-16s %-12s %9.1f%%\n\n", "", "difference", (pooled / base - 1.0) * 100.0);
+    }
+
+    return 0;
+}
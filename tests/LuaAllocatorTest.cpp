@@ -0,0 +1,204 @@
+// LuaAllocator on its own and under a real Lua state.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <lua.hpp>
+
+#include "mods/LuaAllocator.hpp"
+
+#include "Check.hpp"
+
+namespace {
+void* allocate(LuaAllocator& allocator, size_t size) {
+    return LuaAllocator::alloc(&allocator, nullptr, LUA_TTABLE, size);
+}
+
+void release(LuaAllocator& allocator, void* ptr, size_t size) {
+    LuaAllocator::alloc(&allocator, ptr, size, 0);
+}
+
+void test_accounting() {
+    LuaAllocator allocator{};
+
+    auto small = allocate(allocator, 24);
+    auto large = allocate(allocator, 4096);
+
+    auto stats = allocator.get_stats();
+    CHECK(stats.live_bytes == 24 + 4096);
+    CHECK(stats.live_blocks == 2);
+    CHECK(stats.small_bytes == 24);
+    CHECK(stats.large_bytes == 4096);
+    CHECK(stats.slab_bytes == LuaAllocator::SLAB_SIZE);
+
+    // Same size class, different class, small to large; the contents have to survive each move.
+    std::memset(small, 0xAB, 24);
+    small = LuaAllocator::alloc(&allocator, small, 24, 30);
+    small = LuaAllocator::alloc(&allocator, small, 30, 100);
+    small = LuaAllocator::alloc(&allocator, small, 100, 1000);
+    CHECK(((unsigned char*)small)[0] == 0xAB && ((unsigned char*)small)[23] == 0xAB);
+
+    release(allocator, small, 1000);
+    release(allocator, large, 4096);
+
+    stats = allocator.get_stats();
+    CHECK(stats.live_bytes == 0);
+    CHECK(stats.live_blocks == 0);
+    CHECK(stats.peak_bytes >= 24 + 4096);
+}
+
+void test_trim() {
+    LuaAllocator allocator{};
+
+    constexpr size_t size = 64;
+    constexpr size_t per_slab = LuaAllocator::SLAB_SIZE / size;
+
+    std::vector<void*> blocks{};
+
+    for (size_t i = 0; i < per_slab * 8; ++i) {
+        blocks.push_back(allocate(allocator, size));
+    }
+
+    CHECK(allocator.get_stats().slab_bytes == 8 * LuaAllocator::SLAB_SIZE);
+
+    // Nothing is free yet.
+    CHECK(allocator.trim() == 0);
+
+    // Free every other block of the first half, and all of the second half.
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (i >= blocks.size() / 2 || i % 2 == 0) {
+            release(allocator, blocks[i], size);
+            blocks[i] = nullptr;
+        }
+    }
+
+    CHECK(allocator.trim() == 4 * LuaAllocator::SLAB_SIZE);
+    CHECK(allocator.get_stats().slab_bytes == 4 * LuaAllocator::SLAB_SIZE);
+
+    // The half-used slabs' free blocks are still handed out, and nothing is handed out twice.
+    std::vector<void*> reused{};
+
+    for (size_t i = 0; i < per_slab * 2; ++i) {
+        reused.push_back(allocate(allocator, size));
+    }
+
+    CHECK(allocator.get_stats().slab_bytes == 4 * LuaAllocator::SLAB_SIZE);
+
+    std::vector<void*> all{reused};
+
+    for (auto block : blocks) {
+        if (block != nullptr) {
+            all.push_back(block);
+        }
+    }
+
+    std::sort(all.begin(), all.end());
+    CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+
+    for (auto block : all) {
+        release(allocator, block, size);
+    }
+
+    CHECK(allocator.trim() == 4 * LuaAllocator::SLAB_SIZE);
+    CHECK(allocator.get_stats().slab_bytes == 0);
+    CHECK(allocator.get_stats().live_bytes == 0);
+}
+
+void test_maybe_trim() {
+    LuaAllocator allocator{};
+
+    constexpr size_t size = 32;
+    constexpr size_t per_slab = LuaAllocator::SLAB_SIZE / size;
+
+    std::vector<void*> blocks{};
+
+    for (size_t i = 0; i < per_slab * 2; ++i) {
+        blocks.push_back(allocate(allocator, size));
+    }
+
+    // Less than MIN_TRIM_BYTES free; left alone.
+    for (size_t i = per_slab; i < blocks.size(); ++i) {
+        release(allocator, blocks[i], size);
+    }
+
+    allocator.maybe_trim();
+    CHECK(allocator.get_stats().slab_bytes == 2 * LuaAllocator::SLAB_SIZE);
+
+    blocks.resize(per_slab);
+
+    for (size_t i = 0; i < per_slab * 8; ++i) {
+        blocks.push_back(allocate(allocator, size));
+    }
+
+    for (size_t i = per_slab; i < blocks.size(); ++i) {
+        release(allocator, blocks[i], size);
+    }
+
+    allocator.maybe_trim();
+    CHECK(allocator.get_stats().slab_bytes == LuaAllocator::SLAB_SIZE);
+
+    for (size_t i = 0; i < per_slab; ++i) {
+        release(allocator, blocks[i], size);
+    }
+}
+
+void test_lua_state() {
+    LuaAllocator allocator{};
+    auto l = lua_newstate(&LuaAllocator::alloc, &allocator);
+
+    CHECK(l != nullptr);
+
+    if (l == nullptr) {
+        return;
+    }
+
+    luaL_openlibs(l);
+
+    const auto script = R"(
+        local t = {}
+        for i = 1, 200000 do
+            t[i] = { x = i, name = "item" .. i }
+        end
+        local sum = 0
+        for i, v in ipairs(t) do
+            sum = sum + v.x
+        end
+        t = nil
+        return sum
+    )";
+
+    CHECK(luaL_dostring(l, script) == LUA_OK);
+    CHECK(lua_tointeger(l, -1) == 200000ll * 200001ll / 2);
+    lua_pop(l, 1);
+
+    const auto before = allocator.get_stats();
+
+    lua_gc(l, LUA_GCCOLLECT);
+    allocator.maybe_trim();
+
+    const auto after = allocator.get_stats();
+    CHECK(after.live_bytes < before.live_bytes);
+    CHECK(after.slab_bytes < before.slab_bytes);
+
+    // The state still works on top of the trimmed pools.
+    CHECK(luaL_dostring(l, "local s = {} for i = 1, 1000 do s[#s + 1] = tostring(i) end return #s") == LUA_OK);
+    CHECK(lua_tointeger(l, -1) == 1000);
+    lua_pop(l, 1);
+
+    lua_close(l);
+
+    CHECK(allocator.get_stats().live_bytes == 0);
+    CHECK(allocator.get_stats().live_blocks == 0);
+}
+}
+
+int main() {
+    test_accounting();
+    test_trim();
+    test_maybe_trim();
+    test_lua_state();
+
+    return report("LuaAllocator");
+}
@@ -0,0 +1,246 @@
+// LuaTaskScheduler driven frame by frame against a plain Lua state.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "mods/LuaTaskScheduler.hpp"
+
+#include "Check.hpp"
+
+namespace {
+using namespace std::chrono_literals;
+
+// A budget no task fits in, so every frame resumes exactly one.
+constexpr auto TINY_BUDGET = 1us;
+constexpr auto LARGE_BUDGET = 1s;
+
+class Fixture {
+public:
+    Fixture() {
+        luaL_openlibs(l);
+
+        lua_newtable(l);
+        scheduler.open(-1);
+        lua_setglobal(l, "re");
+
+        // Spins for about ms milliseconds, so a task reliably outlasts TINY_BUDGET.
+        run("function busy(ms) local t = os.clock() while os.clock() - t < ms / 1000 do end end");
+        run("log = {}");
+    }
+
+    ~Fixture() {
+        scheduler.clear();
+        lua_close(l);
+    }
+
+    void run(const char* code) {
+        if (luaL_dostring(l, code) != LUA_OK) {
+            std::fprintf(stderr, "Lua error: %s\n", lua_tostring(l, -1));
+            lua_pop(l, 1);
+            ++g_failures;
+        }
+    }
+
+    void frame(std::chrono::microseconds budget = LARGE_BUDGET) {
+        scheduler.run_frame(budget, [this](const std::string& e) { errors.push_back(e); });
+    }
+
+    // The log table joined with commas.
+    std::string log() {
+        run("return table.concat(log, ',')");
+        std::string result = lua_tostring(l, -1);
+        lua_pop(l, 1);
+        return result;
+    }
+
+    lua_State* l{luaL_newstate()};
+    LuaTaskScheduler scheduler{l};
+    std::vector<std::string> errors{};
+};
+
+void test_spawn_runs_next_frame() {
+    Fixture f{};
+
+    f.run("re.spawn(function() log[#log + 1] = 'ran' end)");
+    CHECK(f.log() == "");
+    CHECK(f.scheduler.get_stats().tasks == 0);
+
+    f.frame();
+    CHECK(f.log() == "ran");
+    CHECK(f.scheduler.get_stats().resumed == 1);
+    CHECK(f.scheduler.get_stats().tasks == 0);
+}
+
+void test_yield_and_wait_frames() {
+    Fixture f{};
+
+    f.run(R"(
+        re.spawn(function()
+            for i = 1, 3 do
+                log[#log + 1] = 'y' .. i
+                re.yield()
+            end
+        end)
+
+        re.spawn(function()
+            re.wait_frames(3)
+            log[#log + 1] = 'w'
+        end)
+    )");
+
+    f.frame();
+    CHECK(f.log() == "y1");
+    f.frame();
+    CHECK(f.log() == "y1,y2");
+    f.frame();
+    CHECK(f.log() == "y1,y2,y3");
+    f.frame();
+    CHECK(f.log() == "y1,y2,y3,w");
+    CHECK(f.scheduler.get_stats().tasks == 0);
+    CHECK(f.errors.empty());
+}
+
+void test_budget_defers_in_order() {
+    Fixture f{};
+
+    f.run(R"(
+        for i = 1, 3 do
+            re.spawn(function()
+                busy(2)
+                log[#log + 1] = tostring(i)
+            end)
+        end
+    )");
+
+    // Only one task fits per frame, but one always runs even when it's over budget.
+    f.frame(TINY_BUDGET);
+    CHECK(f.log() == "1");
+    CHECK(f.scheduler.get_stats().resumed == 1);
+    CHECK(f.scheduler.get_stats().deferred == 2);
+    CHECK(f.scheduler.get_stats().tasks == 2);
+
+    // Deferred tasks keep their place at the front.
+    f.frame(TINY_BUDGET);
+    CHECK(f.log() == "1,2");
+    CHECK(f.scheduler.get_stats().deferred == 1);
+
+    f.frame(TINY_BUDGET);
+    CHECK(f.log() == "1,2,3");
+    CHECK(f.scheduler.get_stats().deferred == 0);
+    CHECK(f.scheduler.get_stats().tasks == 0);
+}
+
+void test_round_robin_under_budget() {
+    Fixture f{};
+
+    f.run(R"(
+        for _, name in ipairs({ 'a', 'b' }) do
+            re.spawn(function()
+                while true do
+                    busy(2)
+                    log[#log + 1] = name
+                    re.yield()
+                end
+            end)
+        end
+    )");
+
+    // A task that keeps yielding can't hog the frame; the other one gets the next turn.
+    for (int i = 0; i < 4; ++i) {
+        f.frame(TINY_BUDGET);
+    }
+
+    CHECK(f.log() == "a,b,a,b");
+}
+
+void test_spawn_from_task() {
+    Fixture f{};
+
+    f.run(R"(
+        re.spawn(function()
+            log[#log + 1] = 'parent'
+            re.spawn(function() log[#log + 1] = 'child' end)
+        end)
+    )");
+
+    f.frame();
+    CHECK(f.log() == "parent");
+    CHECK(f.scheduler.get_stats().tasks == 1);
+
+    f.frame();
+    CHECK(f.log() == "parent,child");
+}
+
+void test_errors() {
+    Fixture f{};
+
+    f.run(R"(
+        re.spawn(function()
+            re.yield()
+            error('boom')
+        end)
+
+        re.spawn(function()
+            for i = 1, 3 do
+                log[#log + 1] = tostring(i)
+                re.yield()
+            end
+        end)
+    )");
+
+    f.frame();
+    CHECK(f.errors.empty());
+
+    // The failing task is reported with a traceback and dropped; the other one carries on.
+    f.frame();
+    CHECK(f.errors.size() == 1);
+
+    if (!f.errors.empty()) {
+        CHECK(f.errors[0].find("boom") != std::string::npos);
+        CHECK(f.errors[0].find("stack traceback") != std::string::npos);
+    }
+
+    CHECK(f.scheduler.get_stats().tasks == 1);
+
+    f.frame();
+    CHECK(f.log() == "1,2,3");
+    CHECK(f.errors.size() == 1);
+
+    // Bad arguments raise in the caller instead.
+    f.run("ok = pcall(re.spawn, 42)");
+    f.run("return ok");
+    CHECK(lua_toboolean(f.l, -1) == 0);
+    lua_pop(f.l, 1);
+}
+
+void test_clear() {
+    Fixture f{};
+
+    f.run("re.spawn(function() while true do re.yield() end end)");
+    f.frame();
+    CHECK(f.scheduler.get_stats().tasks == 1);
+
+    f.scheduler.clear();
+    CHECK(f.scheduler.get_stats().tasks == 0);
+
+    f.frame();
+    CHECK(f.scheduler.get_stats().resumed == 0);
+
+    // The task's thread is no longer referenced, so it can be collected.
+    lua_gc(f.l, LUA_GCCOLLECT);
+}
+}
+
+int main() {
+    test_spawn_runs_next_frame();
+    test_yield_and_wait_frames();
+    test_budget_defers_in_order();
+    test_round_robin_under_budget();
+    test_spawn_from_task();
+    test_errors();
+    test_clear();
+
+    return report("LuaTaskScheduler");
+}